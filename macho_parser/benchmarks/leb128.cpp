@@ -0,0 +1,98 @@
+// Compares the byte-at-a-time LEB128 decoder with the bounded, word-at-a-time one, and with
+// DataCursor, which the decoders of untrusted data use.
+// Run with `bazel run -c opt //:leb128_benchmark`.
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "utils/utils.h"
+
+static const int VALUE_COUNT = 1 << 20;
+static const int ROUNDS = 20;
+
+static std::vector<uint8_t> encode(const std::vector<uint64_t> &values) {
+    std::vector<uint8_t> bytes;
+    for (uint64_t value : values) {
+        writeULEB128(value, bytes);
+    }
+    return bytes;
+}
+
+template <typename Decode>
+static double measure(const std::vector<uint8_t> &bytes, Decode decode) {
+    const uint8_t *end = bytes.data() + bytes.size();
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        const uint8_t *p = bytes.data();
+        while (p < end) {
+            uint64_t value;
+            p += decode(p, end, &value);
+            checksum += value;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Keep the loop from being optimized away.
+    if (checksum == 42) {
+        printf(" ");
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)VALUE_COUNT * ROUNDS);
+}
+
+static double measureCursor(const std::vector<uint8_t> &bytes) {
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        DataCursor cursor(bytes.data(), bytes.size());
+        while (!cursor.atEnd()) {
+            checksum += cursor.readULEB128();
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (checksum == 42) {
+        printf(" ");
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)VALUE_COUNT * ROUNDS);
+}
+
+static void run(const char *name, const std::vector<uint64_t> &values) {
+    std::vector<uint8_t> bytes = encode(values);
+
+    double bytewise = measure(bytes, [](const uint8_t *p, const uint8_t *end, uint64_t *out) {
+        return readULEB128(p, out);
+    });
+    double wordwise = measure(bytes, [](const uint8_t *p, const uint8_t *end, uint64_t *out) {
+        return readULEB128(p, end, out);
+    });
+    double cursor = measureCursor(bytes);
+
+    printf("%-10s %5.2f bytes/value  bytewise %6.2f ns/value  bounded %6.2f ns/value  (%.2fx)  cursor %6.2f ns/value\n",
+        name, (double)bytes.size() / VALUE_COUNT, bytewise, wordwise, bytewise / wordwise, cursor);
+}
+
+int main() {
+    std::mt19937_64 random(128);
+    std::vector<uint64_t> values(VALUE_COUNT);
+
+    // Function starts and most rebase/bind operands fit in one byte.
+    for (uint64_t &value : values) value = random() % 0x80;
+    run("1 byte", values);
+
+    // Typical export trie offsets and addresses.
+    for (uint64_t &value : values) value = (random() & 1) ? 0x80 + random() % 0x3f80 : 0x4000 + random() % 0x1fc000;
+    run("2-3 bytes", values);
+
+    // Large addresses, such as the ones in __DATA of a big image.
+    for (uint64_t &value : values) value = random() >> (random() % 8);
+    run("large", values);
+
+    for (uint64_t &value : values) value = random() >> (random() % 64);
+    run("mixed", values);
+
+    return 0;
+}
@@ -18,12 +18,23 @@ while [[ $# -gt 0 ]]; do
     esac
 done
 
-CFLAGS=()
-LDFLAGS=("-lz")
+CXX=(c++)
+CFLAGS=("-Isources")
+LDFLAGS=("-lz" "-lpthread")
+
+# Only decompiling code requirements needs a macOS framework.
+if [[ "$(uname)" == "Darwin" ]]; then
+    CXX=(xcrun clang++)
+    LDFLAGS+=("-framework" "CoreFoundation" "-framework" "Security")
+fi
 
 if [[ "$OPT_OPENSSL" == 1 ]]; then
-    CFLAGS+=("-DOPENSSL" "-I$(brew --prefix openssl)/include")
-    LDFLAGS+=("-lssl" "-lcrypto" "-L$(brew --prefix openssl)/lib" "-DOPENSSL")
+    CFLAGS+=("-DOPENSSL")
+    LDFLAGS+=("-lssl" "-lcrypto")
+    if [[ "$(uname)" == "Darwin" ]]; then
+        CFLAGS+=("-I$(brew --prefix openssl)/include")
+        LDFLAGS+=("-L$(brew --prefix openssl)/lib")
+    fi
 fi
 
 if [[ "$OPT_DEBUG" == 1 ]]; then
@@ -34,7 +45,7 @@ mkdir -p build/
 find build -name "*.o" -delete
 
 for src in sources/**/*.cpp; do
-    xcrun clang++ --std=c++17 -c -o "build/$(basename $src).o" $CFLAGS $src
+    $CXX --std=c++17 -c -o "build/$(basename $src).o" $CFLAGS $src
 done
 
-xcrun clang++ --std=c++17 -o macho_parser -framework CoreFoundation -framework Security $LDFLAGS build/*.o
+$CXX --std=c++17 -o macho_parser build/*.o $LDFLAGS
@@ -0,0 +1,88 @@
+/*
+ * Portable subset of xnu's <kern/cs_blobs.h>.
+ *
+ * All code signing structures are stored in network (big-endian) byte order.
+ */
+#ifndef _MACHO_PARSER_KERN_CS_BLOBS_H_
+#define _MACHO_PARSER_KERN_CS_BLOBS_H_
+
+#include <stdint.h>
+
+enum {
+    CSMAGIC_REQUIREMENT = 0xfade0c00,
+    CSMAGIC_REQUIREMENTS = 0xfade0c01,
+    CSMAGIC_CODEDIRECTORY = 0xfade0c02,
+    CSMAGIC_EMBEDDED_SIGNATURE = 0xfade0cc0,
+    CSMAGIC_EMBEDDED_SIGNATURE_OLD = 0xfade0b02,
+    CSMAGIC_EMBEDDED_ENTITLEMENTS = 0xfade7171,
+    CSMAGIC_EMBEDDED_DER_ENTITLEMENTS = 0xfade7172,
+    CSMAGIC_DETACHED_SIGNATURE = 0xfade0cc1,
+    CSMAGIC_BLOBWRAPPER = 0xfade0b01,
+
+    CSSLOT_CODEDIRECTORY = 0,
+    CSSLOT_INFOSLOT = 1,
+    CSSLOT_REQUIREMENTS = 2,
+    CSSLOT_RESOURCEDIR = 3,
+    CSSLOT_APPLICATION = 4,
+    CSSLOT_ENTITLEMENTS = 5,
+    CSSLOT_DER_ENTITLEMENTS = 7,
+    CSSLOT_ALTERNATE_CODEDIRECTORIES = 0x1000,
+    CSSLOT_SIGNATURESLOT = 0x10000,
+
+    CS_HASHTYPE_SHA1 = 1,
+    CS_HASHTYPE_SHA256 = 2,
+    CS_HASHTYPE_SHA256_TRUNCATED = 3,
+    CS_HASHTYPE_SHA384 = 4,
+
+    CS_SHA1_LEN = 20,
+    CS_SHA256_LEN = 32,
+    CS_SHA256_TRUNCATED_LEN = 20,
+};
+
+typedef struct __BlobIndex {
+    uint32_t type;      /* type of entry */
+    uint32_t offset;    /* offset of entry */
+} CS_BlobIndex;
+
+typedef struct __SC_SuperBlob {
+    uint32_t magic;     /* magic number */
+    uint32_t length;    /* total length of SuperBlob */
+    uint32_t count;     /* number of index entries following */
+    CS_BlobIndex index[];   /* (count) entries */
+} CS_SuperBlob;
+
+typedef struct __SC_GenericBlob {
+    uint32_t magic;     /* magic number */
+    uint32_t length;    /* total length of blob */
+    char data[];
+} CS_GenericBlob;
+
+typedef struct __CodeDirectory {
+    uint32_t magic;         /* magic number (CSMAGIC_CODEDIRECTORY) */
+    uint32_t length;        /* total length of CodeDirectory blob */
+    uint32_t version;       /* compatibility version */
+    uint32_t flags;         /* setup and mode flags */
+    uint32_t hashOffset;    /* offset of hash slot element at index zero */
+    uint32_t identOffset;   /* offset of identifier string */
+    uint32_t nSpecialSlots; /* number of special hash slots */
+    uint32_t nCodeSlots;    /* number of ordinary (code) hash slots */
+    uint32_t codeLimit;     /* limit to main image signature range */
+    uint8_t hashSize;       /* size of each hash in bytes */
+    uint8_t hashType;       /* type of hash (cdHashType* constants) */
+    uint8_t platform;       /* platform identifier; zero if not platform binary */
+    uint8_t pageSize;       /* log2(page size in bytes); 0 => infinite */
+    uint32_t spare2;        /* unused (must be zero) */
+    /* Version 0x20100 */
+    uint32_t scatterOffset; /* offset of optional scatter vector */
+    /* Version 0x20200 */
+    uint32_t teamOffset;    /* offset of optional team identifier */
+    /* Version 0x20300 */
+    uint32_t spare3;        /* unused (must be zero) */
+    uint64_t codeLimit64;   /* limit to main image signature range, 64 bits */
+    /* Version 0x20400 */
+    uint64_t execSegBase;   /* offset of executable segment */
+    uint64_t execSegLimit;  /* limit of executable segment */
+    uint64_t execSegFlags;  /* executable segment flags */
+} __attribute__((packed)) CS_CodeDirectory;
+
+#endif /* _MACHO_PARSER_KERN_CS_BLOBS_H_ */
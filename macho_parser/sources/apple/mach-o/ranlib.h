@@ -0,0 +1,28 @@
+/*
+ * Portable copy of Apple's <mach-o/ranlib.h>.
+ */
+#ifndef _MACHO_PARSER_MACHO_RANLIB_H_
+#define _MACHO_PARSER_MACHO_RANLIB_H_
+
+#include <stdint.h>
+
+#define SYMDEF              "__.SYMDEF"
+#define SYMDEF_SORTED       "__.SYMDEF SORTED"
+#define SYMDEF_64           "__.SYMDEF_64"
+#define SYMDEF_64_SORTED    "__.SYMDEF_64 SORTED"
+
+struct ranlib {
+    union {
+        uint32_t ran_strx;  /* string table index of */
+    } ran_un;
+    uint32_t ran_off;       /* library member at this offset */
+};
+
+struct ranlib_64 {
+    union {
+        uint64_t ran_strx;  /* string table index of */
+    } ran_un;
+    uint64_t ran_off;       /* library member at this offset */
+};
+
+#endif /* _MACHO_PARSER_MACHO_RANLIB_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Portable replacement for the parts of Apple's <mach-o/swap.h> that the
+ * parser uses. The byte order argument is accepted for source compatibility;
+ * the functions always swap.
+ */
+#ifndef _MACHO_PARSER_MACHO_SWAP_H_
+#define _MACHO_PARSER_MACHO_SWAP_H_
+
+#include <stdint.h>
+#include "fat.h"
+
+enum NXByteOrder {
+    NX_UnknownByteOrder,
+    NX_LittleEndian,
+    NX_BigEndian
+};
+
+static inline void swap_fat_header(struct fat_header *header, enum NXByteOrder) {
+    header->magic = __builtin_bswap32(header->magic);
+    header->nfat_arch = __builtin_bswap32(header->nfat_arch);
+}
+
+static inline void swap_fat_arch(struct fat_arch *archs, uint32_t nfat_arch, enum NXByteOrder) {
+    for (uint32_t i = 0; i < nfat_arch; ++i) {
+        archs[i].cputype = (cpu_type_t)__builtin_bswap32((uint32_t)archs[i].cputype);
+        archs[i].cpusubtype = (cpu_subtype_t)__builtin_bswap32((uint32_t)archs[i].cpusubtype);
+        archs[i].offset = __builtin_bswap32(archs[i].offset);
+        archs[i].size = __builtin_bswap32(archs[i].size);
+        archs[i].align = __builtin_bswap32(archs[i].align);
+    }
+}
+
+static inline void swap_fat_arch_64(struct fat_arch_64 *archs, uint32_t nfat_arch, enum NXByteOrder) {
+    for (uint32_t i = 0; i < nfat_arch; ++i) {
+        archs[i].cputype = (cpu_type_t)__builtin_bswap32((uint32_t)archs[i].cputype);
+        archs[i].cpusubtype = (cpu_subtype_t)__builtin_bswap32((uint32_t)archs[i].cpusubtype);
+        archs[i].offset = __builtin_bswap64(archs[i].offset);
+        archs[i].size = __builtin_bswap64(archs[i].size);
+        archs[i].align = __builtin_bswap32(archs[i].align);
+        archs[i].reserved = __builtin_bswap32(archs[i].reserved);
+    }
+}
+
+#endif /* _MACHO_PARSER_MACHO_SWAP_H_ */
@@ -0,0 +1,42 @@
+/*
+ * Subset of <mach/machine.h> needed to parse Mach-O headers on non-Apple hosts.
+ */
+#ifndef _MACHO_PARSER_MACH_MACHINE_H_
+#define _MACHO_PARSER_MACH_MACHINE_H_
+
+#include <stdint.h>
+
+typedef int32_t cpu_type_t;
+typedef int32_t cpu_subtype_t;
+typedef int32_t cpu_threadtype_t;
+typedef int vm_prot_t;
+
+#define CPU_ARCH_MASK           0xff000000
+#define CPU_ARCH_ABI64          0x01000000
+#define CPU_ARCH_ABI64_32       0x02000000
+
+#define CPU_TYPE_ANY            ((cpu_type_t) -1)
+#define CPU_TYPE_X86            ((cpu_type_t) 7)
+#define CPU_TYPE_I386           CPU_TYPE_X86
+#define CPU_TYPE_X86_64         (CPU_TYPE_X86 | CPU_ARCH_ABI64)
+#define CPU_TYPE_ARM            ((cpu_type_t) 12)
+#define CPU_TYPE_ARM64          (CPU_TYPE_ARM | CPU_ARCH_ABI64)
+#define CPU_TYPE_ARM64_32       (CPU_TYPE_ARM | CPU_ARCH_ABI64_32)
+#define CPU_TYPE_POWERPC        ((cpu_type_t) 18)
+#define CPU_TYPE_POWERPC64      (CPU_TYPE_POWERPC | CPU_ARCH_ABI64)
+
+#define CPU_SUBTYPE_MASK        0xff000000
+#define CPU_SUBTYPE_LIB64       0x80000000
+#define CPU_SUBTYPE_PTRAUTH_ABI 0x80000000
+
+#define CPU_SUBTYPE_X86_ALL     ((cpu_subtype_t)3)
+#define CPU_SUBTYPE_X86_64_ALL  ((cpu_subtype_t)3)
+#define CPU_SUBTYPE_X86_64_H    ((cpu_subtype_t)8)
+
+#define CPU_SUBTYPE_ARM_ALL     ((cpu_subtype_t) 0)
+#define CPU_SUBTYPE_ARM_V7      ((cpu_subtype_t) 9)
+#define CPU_SUBTYPE_ARM64_ALL   ((cpu_subtype_t) 0)
+#define CPU_SUBTYPE_ARM64_V8    ((cpu_subtype_t) 1)
+#define CPU_SUBTYPE_ARM64E      ((cpu_subtype_t) 2)
+
+#endif /* _MACHO_PARSER_MACH_MACHINE_H_ */
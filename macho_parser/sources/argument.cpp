@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <getopt.h>
 #include <map>
@@ -9,6 +11,7 @@
 #include <algorithm>
 
 #include "argument.h"
+#include "utils/utils.h"
 
 struct argument args;
 
@@ -16,11 +19,21 @@ struct argument args;
 std::vector<std::string> specifiedSectNames;
 
 static uint8_t getCommandTypeFromString(char *commandString);
+static int getJobCountFromString(const char *jobsString);
 
 static struct option longopts[] = {
     {"help", no_argument, NULL, 'h'},
     {"command", required_argument, NULL, 'c'},
     {"arch", required_argument, NULL, 0},
+    {"batch", required_argument, NULL, 0},
+    {"find-symbol", required_argument, NULL, 0},
+    {"format", required_argument, NULL, 0},
+    {"export-columns", required_argument, NULL, 0},
+    {"cache-dir", required_argument, NULL, 0},
+    {"lookup-export", required_argument, NULL, 0},
+    {"rebuild-exports", no_argument, &(args.rebuild_exports), 1},
+    {"hide-exports", required_argument, NULL, 0},
+    {"jobs", required_argument, NULL, 'j'},
     {"verbose", no_argument, NULL, 'v'},
     {"no-truncate", no_argument, &(args.no_truncate), 1},
     {"segments", no_argument, &(args.show_segments), 1},
@@ -42,6 +55,7 @@ static struct option longopts[] = {
     {"extdef", no_argument, &(args.show_extdef), 1},
     {"undef", no_argument, &(args.show_undef), 1},
     {"indirect", no_argument, &(args.show_indirect), 1},
+    {"symbol", required_argument, NULL, 0},
 
     {"dyld-info", no_argument, &(args.show_dyld_info), 1},
     {"rebase", no_argument, &(args.show_rebase), 1},
@@ -59,6 +73,15 @@ void usage() {
     puts("    -v, --verbose                        can be used multiple times to increase verbose level");
     puts("        --arch                           specify an architecture, arm64 or x86_64");
     puts("        --no-truncate                    do not truncate even the content is long");
+    puts("        --batch DIR/FILELIST             scan all Mach-O files under DIR (or listed in FILELIST) and print one line per image");
+    puts("    -j, --jobs N                         number of threads used by --batch, static libraries and chained fixups, default to the number of CPUs");
+    puts("        --format FORMAT                  text (default), json or ndjson");
+    puts("        --find-symbol SYMBOL             show only the archive member that defines SYMBOL, using the archive symbol table");
+    puts("        --export-columns DIR             write sections, symbols and fixups to DIR as columnar binary files");
+    puts("        --cache-dir DIR                  cache decoded symbols, fixups, exports and function starts in DIR");
+    puts("        --lookup-export NAME             look up NAME in the export trie and show how it is exported");
+    puts("        --rebuild-exports                re-encode the export trie and compare its size with the original");
+    puts("        --hide-exports FILE              with --rebuild-exports, leave out the symbols listed in FILE");
     puts("    -h, --help                           show this help message");
     puts("");
     puts("    --segments                           equivalent to '--command LC_SEGMENT_64'");
@@ -79,6 +102,7 @@ void usage() {
     puts("    --extdef                             show externally (public) defined symbols");
     puts("    --undef                              show undefined symbols");
     puts("    --indirect                           show indirect symbol table");
+    puts("    --symbol NAME                        show the symbol named NAME");
     puts("");
     puts("Dyld Info Options:");
     puts("    --dyld-info                          equivalent to '--command LC_DYLD_INFO(_ONLY)'");
@@ -94,7 +118,7 @@ void parseArguments(int argc, char **argv) {
     int opt = 0;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "c:s:hv", longopts, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:s:j:hv", longopts, &option_index)) != -1) {
         switch(opt) {
             case 'c':
                 args.commands[args.command_count++] = getCommandTypeFromString(optarg);
@@ -102,6 +126,9 @@ void parseArguments(int argc, char **argv) {
             case 'v':
                 args.verbosity++;
                 break;
+            case 'j':
+                args.jobs = getJobCountFromString(optarg);
+                break;
             case 'h':
                 usage();
                 exit(0);
@@ -118,6 +145,31 @@ void parseArguments(int argc, char **argv) {
                 // all long options that don't have short options
                 if (strcmp(longopts[option_index].name, "arch") == 0) {
                     args.arch = optarg;
+                } else if (strcmp(longopts[option_index].name, "batch") == 0) {
+                    args.batch = optarg;
+                } else if (strcmp(longopts[option_index].name, "symbol") == 0) {
+                    args.symbol = optarg;
+                } else if (strcmp(longopts[option_index].name, "find-symbol") == 0) {
+                    args.find_symbol = optarg;
+                } else if (strcmp(longopts[option_index].name, "export-columns") == 0) {
+                    args.export_columns = optarg;
+                } else if (strcmp(longopts[option_index].name, "cache-dir") == 0) {
+                    args.cache_dir = optarg;
+                } else if (strcmp(longopts[option_index].name, "lookup-export") == 0) {
+                    args.lookup_export = optarg;
+                } else if (strcmp(longopts[option_index].name, "hide-exports") == 0) {
+                    args.hide_exports = optarg;
+                } else if (strcmp(longopts[option_index].name, "format") == 0) {
+                    if (strcmp(optarg, "text") == 0) {
+                        args.format = FORMAT_TEXT;
+                    } else if (strcmp(optarg, "json") == 0) {
+                        args.format = FORMAT_JSON;
+                    } else if (strcmp(optarg, "ndjson") == 0) {
+                        args.format = FORMAT_NDJSON;
+                    } else {
+                        fprintf(stderr, "Unknown format %s. It must be text, json or ndjson.\n", optarg);
+                        exit(1);
+                    }
                 }
                 break;
             case '?':
@@ -128,11 +180,16 @@ void parseArguments(int argc, char **argv) {
 
     if (optind < argc) {
         args.file_name = argv[optind];
-    } else {
+    } else if (args.batch == NULL) {
         puts("Error: missing a macho file.");
         exit(1);
     }
 
+    // Without -j, every parallel step uses all the cores.
+    if (args.jobs == 0) {
+        args.jobs = defaultThreadCount();
+    }
+
     if (args.arch != NULL && (strcasecmp(args.arch, "arm64") != 0 && strcasecmp(args.arch, "x86_64") != 0)) {
         fprintf(stderr, "Only architecture arm64 and x86_64 are supported.\n");
         exit(1);
@@ -165,7 +222,7 @@ void parseArguments(int argc, char **argv) {
         args.commands[args.command_count++] = LC_CODE_SIGNATURE;
     }
 
-    if (args.show_symtab) {
+    if (args.show_symtab || args.symbol != NULL) {
         args.commands[args.command_count++] = LC_SYMTAB;
     }
 
@@ -217,9 +274,7 @@ static uint8_t getCommandTypeFromString(char *commandString) {
         { "LC_DYLD_ENVIRONMENT",    LC_DYLD_ENVIRONMENT },
         { "LC_CODE_SIGNATURE",      LC_CODE_SIGNATURE },
         { "LC_ENCRYPTION_INFO_64",  LC_ENCRYPTION_INFO_64 },
-#if __clang_major__ >= 15
         { "LC_ATOM_INFO",           LC_ATOM_INFO },
-#endif
     };
 
     std::string key = std::string(commandString);
@@ -236,8 +291,23 @@ static uint8_t getCommandTypeFromString(char *commandString) {
     exit(1);
 }
 
+// Parse the value of -j, which must be a positive number.
+static int getJobCountFromString(const char *jobsString) {
+    char *end = NULL;
+    errno = 0;
+    long jobs = strtol(jobsString, &end, 10);
+    if (end == jobsString || *end != '\0' || errno == ERANGE || jobs <= 0 || jobs > INT_MAX) {
+        fprintf(stderr, "Invalid number of jobs %s. It must be a positive integer.\n", jobsString);
+        exit(1);
+    }
+    return (int)jobs;
+}
+
 bool showHeader() {
-    return args.command_count == 0;
+    // The header is one of the records in the structured formats, never printed as text,
+    // and --export-columns, --lookup-export and --rebuild-exports only print what they are asked for.
+    return args.command_count == 0 && args.format == FORMAT_TEXT && args.export_columns == NULL
+        && args.lookup_export == NULL && !args.rebuild_exports;
 }
 
 bool showCommand(uint8_t cmd) {
@@ -260,7 +330,7 @@ bool hasSectionSpecifed() {
     return args.section_count > 0 || specifiedSectNames.size() > 0;
 }
 
-bool showSection(int sectIndex, char *sectName) {
+bool showSection(int sectIndex, std::string_view sectName) {
     if (!hasSectionSpecifed()) {
         // if no command is specified, show all sections
         return true;
@@ -276,8 +346,7 @@ bool showSection(int sectIndex, char *sectName) {
 
     if (!show) {
         // check if the section name is specified
-        auto sectionName = std::string(sectName, std::min<size_t>(strlen(sectName), 16));
-        show = std::find(specifiedSectNames.begin(), specifiedSectNames.end(), sectionName) != specifiedSectNames.end();
+        show = std::find(specifiedSectNames.begin(), specifiedSectNames.end(), sectName) != specifiedSectNames.end();
     }
 
     return show;
@@ -1,8 +1,16 @@
 #ifndef ARGUMENT_H
 #define ARGUMENT_H
 
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
 #include <stdbool.h>
+#include <string_view>
+
+// output formats of --format
+enum output_format {
+    FORMAT_TEXT = 0,
+    FORMAT_JSON,
+    FORMAT_NDJSON,
+};
 
 // command line argument
 struct argument {
@@ -12,6 +20,15 @@ struct argument {
     int command_count;
     int no_truncate;
     char *arch;
+    char *batch;
+    char *find_symbol;
+    char *export_columns;
+    char *cache_dir;
+    char *lookup_export;
+    int rebuild_exports;
+    char *hide_exports;
+    int format;
+    int jobs;
 
     int show_build_version;
     int show_segments;
@@ -32,6 +49,7 @@ struct argument {
     int show_extdef;
     int show_undef;
     int show_indirect;
+    char *symbol;
 
     // dyld info options
     int show_dyld_info;
@@ -57,7 +75,7 @@ bool showCommand(uint8_t cmd);
 
 bool hasSectionSpecifed();
 
-bool showSection(int sectIndex, char *sectName);
+bool showSection(int sectIndex, std::string_view sectName);
 
 bool isSelectedArch(const char *arch);
 
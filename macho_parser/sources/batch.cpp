@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "apple/mach-o/fat.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "argument.h"
+#include "utils/utils.h"
+#include "macho_header.h"
+#include "core/macho_image.h"
+#include "core/ar_parser.h"
+#include "core/rebase_bind.h"
+#include "core/fixup_chains.h"
+
+// This file handles scanning many files in one process (--batch).
+// Files are parsed on a pool of threads and a summary line is printed for every image in a fixed order,
+// so the output is the same no matter how the work is scheduled.
+
+static std::vector<std::string> collectFiles(const char *path);
+static std::string scanFile(const std::string &path);
+static std::string scanSlice(uint8_t *sliceBase, uint64_t sliceSize, const std::string &name);
+static bool isMachOMagic(uint32_t magic);
+static std::string summarizeImage(uint8_t *base, uint64_t size, const std::string &name);
+static std::string countFixups(const MachoImage &image);
+
+int runBatch(const char *path) {
+    std::vector<std::string> files = collectFiles(path);
+    std::vector<std::string> results(files.size());
+
+    parallelFor(files.size(), [&files, &results](size_t i) {
+        results[i] = scanFile(files[i]);
+    }, args.jobs);
+
+    for (const auto &result : results) {
+        fputs(result.c_str(), stdout);
+    }
+    return 0;
+}
+
+// If `path` is a directory, return all regular files under it, sorted by path.
+// Otherwise `path` is a file list with one path per line.
+static std::vector<std::string> collectFiles(const char *path) {
+    std::vector<std::string> files;
+    std::error_code ec;
+
+    if (std::filesystem::is_directory(path, ec)) {
+        auto options = std::filesystem::directory_options::skip_permission_denied;
+        for (auto it = std::filesystem::recursive_directory_iterator(path, options, ec);
+            it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) { break; }
+            // Skip symlinks, otherwise the same binary in a framework (Versions/Current) is scanned twice.
+            if (it->is_symlink(ec) || !it->is_regular_file(ec)) { continue; }
+            files.push_back(it->path().string());
+        }
+        std::sort(files.begin(), files.end());
+    } else {
+        std::ifstream fileList(path);
+        if (!fileList) {
+            fprintf(stderr, "Cannot read file list %s\n", path);
+            exit(1);
+        }
+
+        std::string line;
+        while (std::getline(fileList, line)) {
+            if (!line.empty()) {
+                files.push_back(line);
+            }
+        }
+    }
+
+    return files;
+}
+
+// Return the summary lines of all the images in a file, or an empty string if it's not a Mach-O file.
+// Only the first page is mapped to tell what the file is, so a file that isn't scanned, like most of the files
+// in an app bundle, costs one page. Then only the slices that are scanned are mapped.
+static std::string scanFile(const std::string &path) {
+    std::unique_ptr<MappedFile> file;
+    std::string result;
+    try {
+        file = std::make_unique<MappedFile>(path.c_str());
+        uint64_t fileSize = file->size();
+        if (fileSize < sizeof(uint32_t)) {
+            return "";
+        }
+        uint64_t headSize = std::min(fileSize, (uint64_t)getpagesize());
+        uint8_t *head = file->map(0, headSize);
+
+        if (FatMacho::isFatMacho(head, headSize)) {
+            // Like the single file mode, the arch table has to be in the first page.
+            struct fat_header header;
+            std::vector<struct fat_arch_64> archs;
+            if (!FatMacho::readFatArchs(head, headSize, header, archs)) {
+                return "";
+            }
+
+            for (const struct fat_arch_64 &arch : archs) {
+                if (arch.offset > fileSize || arch.size > fileSize - arch.offset) {
+                    continue;
+                }
+                if ((arch.cputype & CPU_ARCH_ABI64) && isSelectedArch(stringifyCPUType(arch.cputype).c_str())) {
+                    result += scanSlice(file->map(arch.offset, arch.size), arch.size, path);
+                }
+            }
+        } else if (Archive::isArchive(head, headSize) || isMachOMagic(*(uint32_t *)head)) {
+            result = scanSlice(file->map(0, fileSize), fileSize, path);
+        }
+    } catch (const std::exception &) {
+        return "";
+    }
+
+    return result;
+}
+
+static std::string scanSlice(uint8_t *sliceBase, uint64_t sliceSize, const std::string &name) {
+    if (Archive::isArchive(sliceBase, sliceSize)) {
+        std::string result;
+        Archive::enumerateObjectFileInArchive(sliceBase, sliceSize, [&result, &name](char *objectFileName, uint8_t *objectFileBase, uint64_t objectFileSize) {
+            result += summarizeImage(objectFileBase, objectFileSize, name + "(" + objectFileName + ")");
+        });
+        return result;
+    }
+
+    if (sliceSize < sizeof(uint32_t)) {
+        return "";
+    }
+
+    uint32_t magic = *(uint32_t *)sliceBase;
+    if (magic == MH_MAGIC_64) {
+        return summarizeImage(sliceBase, sliceSize, name);
+    } else if (isMachOMagic(magic)) {
+        return std::string("error: only 64-bit little-endian Mach-O is supported   ") + name + "\n";
+    }
+
+    // not a Mach-O file
+    return "";
+}
+
+// Any Mach-O header, including the ones that are reported as unsupported.
+static bool isMachOMagic(uint32_t magic) {
+    return magic == MH_MAGIC_64 || magic == MH_MAGIC || magic == MH_CIGAM || magic == MH_CIGAM_64;
+}
+
+static std::string summarizeImage(uint8_t *base, uint64_t size, const std::string &name) {
+    char line[256];
+
+    try {
+        MachoImage image(base, size);
+        if (!isSelectedArch(stringifyCPUType(image.header->cputype).c_str())) {
+            return "";
+        }
+
+        snprintf(line, sizeof(line), "%-8s %-8s ncmds: %-4u segments: %-3zu sections: %-4zu dylibs: %-4zu symbols: %-8u ",
+            stringifyCPUType(image.header->cputype).c_str(),
+            stringifyFileType(image.header->filetype).c_str(),
+            image.header->ncmds, image.segmentCommands.size(), image.sections.size(), image.dylibCommands.size(),
+            image.symtabCmd ? image.symtabCmd->nsyms : 0);
+        strncat(line, countFixups(image).c_str(), sizeof(line) - strlen(line) - 1);
+    } catch (const std::exception &e) {
+        snprintf(line, sizeof(line), "error: %s   ", e.what());
+    }
+
+    return std::string(line) + name + "\n";
+}
+
+// The number of rebases and binds in LC_DYLD_INFO or LC_DYLD_CHAINED_FIXUPS. With LC_DYLD_INFO only the opcodes
+// are walked, never the individual fixups. The chains are walked serially because files are already scanned in parallel.
+static std::string countFixups(const MachoImage &image) {
+    struct dyld_info_command *cmd = image.dyldInfoCmd;
+    uint64_t rebases = 0;
+    uint64_t binds = 0;
+
+    try {
+        if (cmd != nullptr) {
+            forEachRebaseRun(image, cmd->rebase_off, cmd->rebase_size, [&rebases](const RebaseRun &run) {
+                rebases += run.count;
+            });
+
+            auto countBinds = [&binds](const BindRun &run) { binds += run.count; };
+            forEachBindRun(image, cmd->bind_off, cmd->bind_size, countBinds);
+            forEachBindRun(image, cmd->weak_bind_off, cmd->weak_bind_size, countBinds);
+            forEachBindRun(image, cmd->lazy_bind_off, cmd->lazy_bind_size, countBinds);
+        }
+
+        forEachChainedFixup(image, [&rebases, &binds](const ChainedFixupRecord &fixup) {
+            if (fixup.bind) {
+                binds += 1;
+            } else {
+                rebases += 1;
+            }
+        });
+    } catch (const std::exception &e) {
+        // for example BIND_OPCODE_THREADED or a malformed chain, the rest of the line is still useful
+        return "rebases: -        binds: -        ";
+    }
+
+    char counts[64];
+    snprintf(counts, sizeof(counts), "rebases: %-8llu binds: %-8llu ", (unsigned long long)rebases, (unsigned long long)binds);
+    return counts;
+}
@@ -11,7 +11,7 @@ void printBuildVersion(const uint8_t *base, const struct build_version_command *
     auto minos = formatVersion(buildVersionCmd->minos);
     auto sdk = formatVersion(buildVersionCmd->sdk);
 
-    printf("%-20s cmdsize: %-6u platform: %s   minos: %s   sdk: %s\n", "LC_BUILD_VERSION",
+    fprintf(textOutput(), "%-20s cmdsize: %-6u platform: %s   minos: %s   sdk: %s\n", "LC_BUILD_VERSION",
         buildVersionCmd->cmdsize,
         platformName.c_str(), minos.c_str(), sdk.c_str());
 
@@ -25,7 +25,7 @@ void printBuildVersion(const uint8_t *base, const struct build_version_command *
         auto toolName = formatToolName(tool_version->tool);
         auto toolVersionString = formatVersion(tool_version->version);
 
-        printf ("    tool:  %s   version: %s\n", toolName.c_str(), toolVersionString.c_str());
+        fprintf(textOutput(), "    tool:  %s   version: %s\n", toolName.c_str(), toolVersionString.c_str());
     }
 }
 
@@ -41,7 +41,7 @@ void printVersionMin(const uint8_t *base, const struct version_min_command *vers
     auto version = formatVersion(versionMinCmd->version);
     auto sdk = formatVersion(versionMinCmd->sdk);
 
-    printf("%-20s cmdsize: %-6u version: %s   sdk: %s\n",
+    fprintf(textOutput(), "%-20s cmdsize: %-6u version: %s   sdk: %s\n",
         cmd_name, versionMinCmd->cmdsize,
         version.c_str(), sdk.c_str());
 }
@@ -1,72 +1,96 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
-#include <mach-o/loader.h>
-#include <mach-o/fixup-chains.h>
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/fixup-chains.h"
 #include <sys/mman.h>
+#include <stddef.h>
+#include <climits>
 #include <algorithm>
+#include <stdexcept>
 #include <string>
 
 #include "argument.h"
-#include "macho_binary.h"
+#include "utils/utils.h"
+#include "core/macho_image.h"
+#include "core/fixup_chains.h"
+#include "chained_fixups.h"
 
 static void printChainedFixupsHeader(struct dyld_chained_fixups_header *header);
-static void printImports(struct dyld_chained_fixups_header *header);
-static void printFixupsInPage(uint8_t *base, uint8_t *fixupBase, struct dyld_chained_fixups_header *header,
-    struct dyld_chained_starts_in_segment *startsInSegment, int pageIndex);
+static void printImports(const MachoImage &image, struct dyld_chained_fixups_header *header);
+static void printFixupsInPage(const MachoImage &image, struct dyld_chained_starts_in_segment *startsInSegment,
+    int segmentIndex, int pageIndex);
+static void printFixup(const ChainedFixupRecord &fixup, bool is64);
+static const char *formatPtrAuthKey(uint8_t key);
 
-static std::string getDylibName(uint16_t dylibOrdinal);
+static std::string getDylibName(const MachoImage &image, int dylibOrdinal);
 static void formatPointerFormat(uint16_t pointer_format, char *formatted);
 
-void printChainedFixups(uint8_t *base, uint32_t dataoff, uint32_t datasize) {
-    uint8_t *fixup_base = base + dataoff;
-
-    struct dyld_chained_fixups_header *header = (struct dyld_chained_fixups_header *)fixup_base;
+void printChainedFixups(const MachoImage &image) {
+    struct dyld_chained_fixups_header *header = getChainedFixupsHeader(image);
     printChainedFixupsHeader(header);
-    printImports(header);
-
-    struct dyld_chained_starts_in_image *starts_in_image =
-        (struct dyld_chained_starts_in_image *)(fixup_base + header->starts_offset);
+    printImports(image, header);
 
+    struct dyld_chained_starts_in_image *starts_in_image = getChainedStartsInImage(image);
 
     uint32_t *offsets = starts_in_image->seg_info_offset;
     for (int i = 0; i < starts_in_image->seg_count; ++i) {
-        struct segment_command_64 *segCmd = machoBinary.segmentCommands[i];
-        printf("  SEGMENT %.16s (offset: %d)\n", segCmd->segname, offsets[i]);
+        struct segment_command_64 *segCmd = image.segmentCommands[i];
+        fprintf(textOutput(), "  SEGMENT %.16s (offset: %d)\n", segCmd->segname, offsets[i]);
 
         if (offsets[i] == 0) {
-            printf("\n");
+            fprintf(textOutput(), "\n");
             continue;
         }
 
-        struct dyld_chained_starts_in_segment* startsInSegment = (struct dyld_chained_starts_in_segment*)(fixup_base + header->starts_offset + offsets[i]);
+        struct dyld_chained_starts_in_segment* startsInSegment = getChainedStartsInSegment(image, i);
         char formatted_pointer_format[256];
         formatPointerFormat(startsInSegment->pointer_format, formatted_pointer_format);
 
-        printf("    size: %d\n", startsInSegment->size);
-        printf("    page_size: 0x%x\n", startsInSegment->page_size);
-        printf("    pointer_format: %d (%s)\n", startsInSegment->pointer_format, formatted_pointer_format);
-        printf("    segment_offset: 0x%llx\n", startsInSegment->segment_offset);
-        printf("    max_valid_pointer: %d\n", startsInSegment->max_valid_pointer);
-        printf("    page_count: %d\n", startsInSegment->page_count);
-        printf("    page_start: %d\n", startsInSegment-> page_start[0]);
+        fprintf(textOutput(), "    size: %d\n", startsInSegment->size);
+        fprintf(textOutput(), "    page_size: 0x%x\n", startsInSegment->page_size);
+        fprintf(textOutput(), "    pointer_format: %d (%s)\n", startsInSegment->pointer_format, formatted_pointer_format);
+        fprintf(textOutput(), "    segment_offset: 0x%llx\n", (unsigned long long)startsInSegment->segment_offset);
+        fprintf(textOutput(), "    max_valid_pointer: %d\n", startsInSegment->max_valid_pointer);
+        fprintf(textOutput(), "    page_count: %d\n", startsInSegment->page_count);
+        fprintf(textOutput(), "    page_start: %d\n", startsInSegment-> page_start[0]);
+
+        bool is64 = startsInSegment->pointer_format == DYLD_CHAINED_PTR_64
+            || startsInSegment->pointer_format == DYLD_CHAINED_PTR_64_OFFSET;
+
+        // Without truncation every fixup is printed, so decode all the pages up front on all the cores.
+        // If that fails, fall back to page by page, which reports the error under the page it happens.
+        std::vector<std::vector<ChainedFixupRecord>> decodedPages;
+        if (args.no_truncate) {
+            try {
+                decodedPages = decodeChainedFixupPages(image, i, args.jobs);
+            } catch (const std::exception &) {
+                decodedPages.clear();
+            }
+        }
 
         uint16_t *page_starts = startsInSegment->page_start;
         uint16_t maxPageNum = args.no_truncate ? UINT16_MAX : 10;
         int pageCount = 0;
         for (int j = 0; j < std::min(startsInSegment->page_count, maxPageNum); ++j) {
-            printf("      PAGE %d (offset: %d)\n", j, page_starts[j]);
+            fprintf(textOutput(), "      PAGE %d (offset: %d)\n", j, page_starts[j]);
 
             if (page_starts[j] == DYLD_CHAINED_PTR_START_NONE) { continue; }
 
-            printFixupsInPage(base, fixup_base, header, startsInSegment, j);
+            if (decodedPages.empty()) {
+                printFixupsInPage(image, startsInSegment, i, j);
+            } else {
+                for (const ChainedFixupRecord &fixup : decodedPages[j]) {
+                    printFixup(fixup, is64);
+                }
+            }
 
             pageCount++;
-            printf("\n");
+            fprintf(textOutput(), "\n");
         }
 
         if (pageCount < startsInSegment->page_count) {
-            printf("      ... %d more pages ...\n\n", startsInSegment->page_count - pageCount);
+            fprintf(textOutput(), "      ... %d more pages ...\n\n", startsInSegment->page_count - pageCount);
         }
     }
 }
@@ -79,80 +103,101 @@ static void printChainedFixupsHeader(struct dyld_chained_fixups_header *header)
         case DYLD_CHAINED_IMPORT_ADDEND64: imports_format = "DYLD_CHAINED_IMPORT_ADDEND64"; break;
     }
 
-    printf("  CHAINED FIXUPS HEADER\n");
-    printf("    fixups_version : %d\n", header->fixups_version);
-    printf("    starts_offset  : %#4x (%d)\n", header->starts_offset, header->starts_offset);
-    printf("    imports_offset : %#4x (%d)\n", header->imports_offset, header->imports_offset);
-    printf("    symbols_offset : %#4x (%d)\n", header->symbols_offset, header->symbols_offset);
-    printf("    imports_count  : %d\n", header->imports_count);
-    printf("    imports_format : %d (%s)\n", header->imports_format, imports_format);
-    printf("    symbols_format : %d (%s)\n", header->symbols_format,
+    fprintf(textOutput(), "  CHAINED FIXUPS HEADER\n");
+    fprintf(textOutput(), "    fixups_version : %d\n", header->fixups_version);
+    fprintf(textOutput(), "    starts_offset  : %#4x (%d)\n", header->starts_offset, header->starts_offset);
+    fprintf(textOutput(), "    imports_offset : %#4x (%d)\n", header->imports_offset, header->imports_offset);
+    fprintf(textOutput(), "    symbols_offset : %#4x (%d)\n", header->symbols_offset, header->symbols_offset);
+    fprintf(textOutput(), "    imports_count  : %d\n", header->imports_count);
+    fprintf(textOutput(), "    imports_format : %d (%s)\n", header->imports_format, imports_format);
+    fprintf(textOutput(), "    symbols_format : %d (%s)\n", header->symbols_format,
         (header->symbols_format == 0 ? "UNCOMPRESSED" : "ZLIB COMPRESSED"));
-    printf("\n");
+    fprintf(textOutput(), "\n");
 }
 
-static void printImports(struct dyld_chained_fixups_header *header) {
-    printf("  IMPORTS\n");
+static void printImports(const MachoImage &image, struct dyld_chained_fixups_header *header) {
+    fprintf(textOutput(), "  IMPORTS\n");
 
     uint32_t maxImportNum = args.no_truncate ? UINT32_MAX : 10;
     int importCount = 0;
-    for (int i = 0; i < std::min(header->imports_count, maxImportNum); ++i) {
-        struct dyld_chained_import import =
-            ((struct dyld_chained_import *)((uint8_t *)header + header->imports_offset))[i];
-
-        printf("    [%d] lib_ordinal: %-22s   weak_import: %d   name_offset: %d (%s)\n",
-            i, getDylibName(import.lib_ordinal).c_str(), import.weak_import, import.name_offset,
-            (char *)((uint8_t *)header + header->symbols_offset + import.name_offset));
+    try {
+        ChainedImportTable imports(image);
+        for (uint32_t i = 0; i < std::min(imports.size(), maxImportNum); ++i) {
+            ChainedImport import = imports[i];
+
+            fprintf(textOutput(), "    [%d] lib_ordinal: %-22s   weak_import: %d   name_offset: %d (%s)",
+                i, getDylibName(image, import.libOrdinal).c_str(), import.weakImport, import.nameOffset, import.name);
+            if (imports.format() != DYLD_CHAINED_IMPORT) {
+                fprintf(textOutput(), "   addend: %lld", (long long)import.addend);
+            }
+            fprintf(textOutput(), "\n");
 
-        importCount++;
+            importCount++;
+        }
+    } catch (const std::exception &e) {
+        fprintf(textOutput(), "    %s\n", e.what());
     }
 
     if (importCount < header->imports_count) {
-        printf("    ... %d more imports ...\n", header->imports_count - importCount);
+        fprintf(textOutput(), "    ... %d more imports ...\n", header->imports_count - importCount);
     }
 
-    printf("\n");
+    fprintf(textOutput(), "\n");
 }
 
-static void printFixupsInPage(uint8_t *base, uint8_t *fixupBase, struct dyld_chained_fixups_header *header,
-    struct dyld_chained_starts_in_segment *startsInSegment, int pageIndex) {
-    uint32_t chain = startsInSegment->segment_offset + startsInSegment->page_size * pageIndex + startsInSegment->page_start[pageIndex];
-    bool done = false;
+static void printFixupsInPage(const MachoImage &image, struct dyld_chained_starts_in_segment *startsInSegment,
+    int segmentIndex, int pageIndex) {
     int count = 0;
     int maxNumFixup = args.no_truncate ? INT_MAX : 10;
-    while (!done) {
-        if (startsInSegment->pointer_format == DYLD_CHAINED_PTR_64
-            || startsInSegment->pointer_format == DYLD_CHAINED_PTR_64_OFFSET) {
-            struct dyld_chained_ptr_64_bind bind = *(struct dyld_chained_ptr_64_bind *)(base + chain);
-            if (bind.bind) {
-                struct dyld_chained_import import = ((struct dyld_chained_import *)(fixupBase + header->imports_offset))[bind.ordinal];
-                char *symbol = (char *)(fixupBase + header->symbols_offset + import.name_offset);
-                printf("        0x%08x BIND     ordinal: %d   addend: %d    reserved: %d   (%s)\n",
-                    chain, bind.ordinal, bind.addend, bind.reserved, symbol);
-            } else {
-                // rebase
-                struct dyld_chained_ptr_64_rebase rebase = *(struct dyld_chained_ptr_64_rebase *)&bind;
-                printf("        %#010x REBASE   target: %#010llx   high8: %d\n",
-                    chain, rebase.target, rebase.high8);
-            }
+    bool is64 = startsInSegment->pointer_format == DYLD_CHAINED_PTR_64
+        || startsInSegment->pointer_format == DYLD_CHAINED_PTR_64_OFFSET;
 
-            if (bind.next == 0) {
-                done = true;
-            } else {
-                chain += bind.next * 4;
+    try {
+        forEachChainedFixupInPage(image, segmentIndex, pageIndex, [&](const ChainedFixupRecord &fixup) {
+            printFixup(fixup, is64);
+
+            count++;
+            if (count >= maxNumFixup) {
+                fprintf(textOutput(), "        ... more fixups ...\n");
+                return false;
             }
+            return true;
+        });
+    } catch (const std::exception &e) {
+        fprintf(textOutput(), "        %s\n", e.what());
+    }
+}
 
-        } else {
-            printf("Unsupported pointer format: 0x%x", startsInSegment->pointer_format);
-            break;
-        }
+static void printFixup(const ChainedFixupRecord &fixup, bool is64) {
+    uint32_t chain = fixup.vmOffset;
+    if (fixup.bind && fixup.auth) {
+        fprintf(textOutput(), "        0x%08x AUTH_BIND ordinal: %d   key: %s   addrDiv: %d   diversity: %#06x   (%s)\n",
+            chain, fixup.importOrdinal, formatPtrAuthKey(fixup.key), fixup.addrDiv, fixup.diversity, fixup.symbolName);
+    } else if (fixup.bind && is64) {
+        struct dyld_chained_ptr_64_bind bind;
+        memcpy(&bind, &fixup.raw, sizeof(bind));
+        fprintf(textOutput(), "        0x%08x BIND     ordinal: %d   addend: %d    reserved: %d   (%s)\n",
+            chain, fixup.importOrdinal, (int)fixup.addend, bind.reserved, fixup.symbolName);
+    } else if (fixup.bind) {
+        fprintf(textOutput(), "        0x%08x BIND     ordinal: %d   addend: %lld   (%s)\n",
+            chain, fixup.importOrdinal, (long long)fixup.addend, fixup.symbolName);
+    } else if (fixup.auth) {
+        fprintf(textOutput(), "        %#010x AUTH_REBASE target: %#010llx   key: %s   addrDiv: %d   diversity: %#06x\n",
+            chain, (unsigned long long)fixup.target, formatPtrAuthKey(fixup.key), fixup.addrDiv, fixup.diversity);
+    } else {
+        fprintf(textOutput(), "        %#010x REBASE   target: %#010llx   high8: %d\n",
+            chain, (unsigned long long)fixup.target, fixup.high8);
+    }
+}
 
-        count++;
-        if (count >= maxNumFixup) {
-            done = true;
-            printf("        ... more fixups ...\n");
-        }
+static const char *formatPtrAuthKey(uint8_t key) {
+    switch (key) {
+        case 0: return "IA";
+        case 1: return "IB";
+        case 2: return "DA";
+        case 3: return "DB";
     }
+    return "??";
 }
 
 static void formatPointerFormat(uint16_t pointer_format, char *formatted) {
@@ -173,24 +218,24 @@ static void formatPointerFormat(uint16_t pointer_format, char *formatted) {
     }
 }
 
-static std::string getDylibName(uint16_t dylibOrdinal) {
+static std::string getDylibName(const MachoImage &image, int dylibOrdinal) {
     std::string dylibName;
 
     switch (dylibOrdinal) {
-        case (uint8_t)BIND_SPECIAL_DYLIB_SELF:
+        case BIND_SPECIAL_DYLIB_SELF:
             dylibName = "self";
             break;
-        case (uint8_t)BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE:
+        case BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE:
             dylibName = "main executable";
             break;
-        case (uint8_t)BIND_SPECIAL_DYLIB_FLAT_LOOKUP:
+        case BIND_SPECIAL_DYLIB_FLAT_LOOKUP:
             dylibName = "flat lookup";
             break;
-        case (uint8_t)BIND_SPECIAL_DYLIB_WEAK_LOOKUP:
+        case BIND_SPECIAL_DYLIB_WEAK_LOOKUP:
             dylibName = "weak lookup";
             break;
         default:
-            dylibName = machoBinary.getDylibNameByOrdinal(dylibOrdinal);
+            dylibName = image.getDylibNameByOrdinal(dylibOrdinal);
     }
 
     return std::to_string(dylibOrdinal) + std::string(" (") + dylibName + std::string(")");
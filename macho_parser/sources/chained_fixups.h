@@ -0,0 +1,8 @@
+#ifndef CHAINED_FIXUPS_H
+#define CHAINED_FIXUPS_H
+
+#include "core/macho_image.h"
+
+void printChainedFixups(const MachoImage &image);
+
+#endif /* CHAINED_FIXUPS_H */
@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+
+// Requirements are decompiled to text by Security.framework, which only exists on macOS.
+// This is the only part of the parser that depends on the host.
+#ifdef __APPLE__
+
+#include <Security/SecRequirement.h> // Security.framework
+
+void printRequirement(const unsigned char *data, size_t size) {
+    SecRequirementRef requirement;
+    CFStringRef text;
+    int err_code;
+
+    CFDataRef requirement_data = CFDataCreate(kCFAllocatorDefault, data, size);
+
+    err_code = SecRequirementCreateWithData(requirement_data, kSecCSDefaultFlags, &requirement);
+    if (errSecSuccess != err_code) {
+        fprintf(textOutput(), "An error(%d) occurs while parsing requirement binary.\n", err_code);
+        CFRelease(requirement_data);
+        return;
+    }
+
+    err_code = SecRequirementCopyString(requirement, kSecCSDefaultFlags, &text);
+    if (errSecSuccess != err_code) {
+        fprintf(textOutput(), "An error(%d) occurs while de-compiling requirement.\n", err_code);
+        CFRelease(requirement_data);
+        return;
+    }
+
+    fprintf(textOutput(), "      %s\n", CFStringGetCStringPtr(text, kCFStringEncodingUTF8));
+
+    CFRelease(requirement_data);
+}
+
+#else
+
+void printRequirement(const unsigned char *data, size_t size) {
+    fputs("      Info: Decompiling a requirement needs Security.framework, which is only on macOS.\n", textOutput());
+}
+
+#endif
@@ -1,9 +1,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <assert.h>
+#include <string>
 
-#include <Kernel/kern/cs_blobs.h>    // /Kernel.framework
-#include <Security/SecRequirement.h> // Security.framework
+#include "apple/kern/cs_blobs.h"
 
 #ifdef OPENSSL
 #include <openssl/pkcs7.h>
@@ -12,139 +13,103 @@
 
 #include "argument.h"
 #include "utils/utils.h"
+#include "core/signature.h"
 
-static void printCodeDirectory(CS_CodeDirectory *codeDirectory);
-static void printRequirement(unsigned char *data, int size);
+static void printCodeDirectory(DataCursor blob);
 static void printPKCS7(const unsigned char* buffer, size_t size);
 static void formatBlobMagic(uint32_t magic, char *formatted, size_t output_size);
 static void formatHashType(uint8_t hash_type, char *formatted, size_t output_size);
-static std::string cdHash(CS_CodeDirectory *codeDirectory);
+static std::string cdHash(const CodeDirectory &codeDirectory);
 static std::string sha1(const unsigned char *data, size_t size);
 static std::string sha256(const unsigned char *data, size_t size);
 
-void printCodeSignature(uint8_t *base, uint32_t dataoff, uint32_t datasize) {
-    char magic_name[256];
-
-    CS_SuperBlob *super_blob = (CS_SuperBlob *)(base + dataoff);
+// code_requirement.cpp
+void printRequirement(const unsigned char *data, size_t size);
 
-    // Code signature is always encoded in network byte ordering,
-    // so we need to use ntohl to covert byte order from network to host.
-    formatBlobMagic(ntohl(super_blob->magic), magic_name, sizeof(magic_name));
-    printf("SuperBlob: magic: %s, length: %d, count: %d\n", magic_name, ntohl(super_blob->length), ntohl(super_blob->count));
-    for (int i = 0; i < ntohl(super_blob->count); ++i) {
-        uint32_t blob_type = ntohl(super_blob->index[i].type);
-        uint32_t blob_offset = ntohl(super_blob->index[i].offset);
+void printCodeSignature(const MachoImage &image) {
+    char magic_name[256];
 
-        CS_GenericBlob *blob = (CS_GenericBlob *)((uint8_t *)super_blob + blob_offset);
-        uint32_t magic = ntohl(blob->magic);
-        formatBlobMagic(magic, magic_name, sizeof(magic_name));
+    CodeSignatureSuperBlob super_blob = getCodeSignature(image);
+    formatBlobMagic(super_blob.magic(), magic_name, sizeof(magic_name));
+    fprintf(textOutput(), "SuperBlob: magic: %s, length: %d, count: %d\n", magic_name, super_blob.length(), super_blob.count());
+    for (int i = 0; i < super_blob.count(); ++i) {
+        CodeSignatureBlob blob = super_blob[i];
+        formatBlobMagic(blob.magic, magic_name, sizeof(magic_name));
 
-        printf("  Blob %d: type: %#07x, offset: %d, magic: %s, length: %d", i, blob_type, blob_offset, magic_name, ntohl(blob->length));
-        if (blob_type == 0x7 && magic == 0xfade7172) {
-            printf("  (likely DER entitlements)");
+        fprintf(textOutput(), "  Blob %d: type: %#07x, offset: %d, magic: %s, length: %d", i, blob.type, blob.offset, magic_name, (int)blob.data.size());
+        if (blob.type == 0x7 && blob.magic == 0xfade7172) {
+            fprintf(textOutput(), "  (likely DER entitlements)");
         }
-        printf("\n");
+        fprintf(textOutput(), "\n");
 
-        if (magic == CSMAGIC_CODEDIRECTORY) {
+        if (blob.magic == CSMAGIC_CODEDIRECTORY) {
             if (args.show_code_direcotry) {
-                CS_CodeDirectory *cd_blob = (CS_CodeDirectory *)((uint8_t *)super_blob + blob_offset);
-                printCodeDirectory(cd_blob);
+                printCodeDirectory(blob.data);
             }
-        } else if (magic == CSMAGIC_EMBEDDED_ENTITLEMENTS) {
+        } else if (blob.magic == CSMAGIC_EMBEDDED_ENTITLEMENTS) {
             if (args.show_entitlement) {
-                CS_GenericBlob *ent_blob = (CS_GenericBlob *)((uint8_t *)super_blob + blob_offset);
-                printf("%.*s\n\n", ntohl(ent_blob->length), ent_blob->data);
+                DataCursor entitlements = blob.payload();
+                fprintf(textOutput(), "%.*s\n\n", (int)entitlements.size(), (const char *)entitlements.data());
             }
-        } else if (magic == CSMAGIC_REQUIREMENTS) {
+        } else if (blob.magic == CSMAGIC_REQUIREMENTS) {
             if (args.verbosity < 2) { continue; }
-            CS_SuperBlob *req_super_blob = (CS_SuperBlob *)((uint8_t *)super_blob + blob_offset);
-            for (int j = 0; j < ntohl(req_super_blob->count); ++j) {
-                uint32_t req_blob_offset = ntohl(req_super_blob->index[j].offset);
-                CS_GenericBlob *req_blob = (CS_GenericBlob *)((uint8_t *)req_super_blob + req_blob_offset);
-
-                printf("    Requirement[%d]: offset: %d, length: %d\n", j, req_blob_offset, ntohl(req_blob->length));
-                printRequirement((unsigned char *)req_blob, ntohl(req_blob->length));
+            CodeSignatureSuperBlob requirements(blob.data);
+            for (int j = 0; j < requirements.count(); ++j) {
+                CodeSignatureBlob requirement = requirements[j];
+                fprintf(textOutput(), "    Requirement[%d]: offset: %d, length: %d\n", j, requirement.offset, (int)requirement.data.size());
+                printRequirement(requirement.data.data(), requirement.data.size());
             }
-            printf("\n");
-        } else if (magic == CSMAGIC_BLOBWRAPPER) {
+            fprintf(textOutput(), "\n");
+        } else if (blob.magic == CSMAGIC_BLOBWRAPPER) {
             if (args.show_blob_wrapper) {
-                CS_GenericBlob *blob_wrapper = (CS_GenericBlob *)((uint8_t *)super_blob + blob_offset);
-                printPKCS7((const unsigned char *)blob_wrapper->data, ntohl(blob_wrapper->length));
+                DataCursor wrapper = blob.payload();
+                printPKCS7(wrapper.data(), wrapper.size());
             }
         }
     }
 }
 
-static void printRequirement(unsigned char *data, int size) {
-    SecRequirementRef requirement;
-    CFStringRef text;
-    int err_code;
-
-    CFDataRef requirement_data = CFDataCreate(kCFAllocatorDefault, data, size);
-
-    err_code = SecRequirementCreateWithData(requirement_data, kSecCSDefaultFlags, &requirement);
-    if (errSecSuccess != err_code) {
-        printf("An error(%d) occurs while parsing requirement binary.\n", err_code);
-        CFRelease(requirement_data);
-        return;
-    }
-
-    err_code = SecRequirementCopyString(requirement, kSecCSDefaultFlags, &text);
-    if (errSecSuccess != err_code) {
-        printf("An error(%d) occurs while de-compiling requirement.\n", err_code);
-        CFRelease(requirement_data);
-        return;
-    }
-
-    printf("      %s\n", CFStringGetCStringPtr(text, kCFStringEncodingUTF8));
-
-    CFRelease(requirement_data);
-}
-
-static void printCodeDirectory(CS_CodeDirectory *codeDirectory) {
-    uint32_t hash_offset = ntohl(codeDirectory->hashOffset);
-    uint8_t hash_size = codeDirectory->hashSize;
-    uint32_t special_slot_size = ntohl(codeDirectory->nSpecialSlots);
-    uint32_t slot_size = ntohl(codeDirectory->nCodeSlots);
-    uint32_t identity_offset = ntohl(codeDirectory->identOffset);
+static void printCodeDirectory(DataCursor blob) {
+    CodeDirectory codeDirectory = decodeCodeDirectory(blob);
 
     char hash_type[32];
-    formatHashType(codeDirectory->hashType, hash_type, sizeof(hash_type));
-
-    printf("    version      : %#x\n", ntohl(codeDirectory->version));
-    printf("    flags        : %#x\n", ntohl(codeDirectory->flags));
-    printf("    hashOffset   : %d\n", hash_offset);
-    printf("    identOffset  : %d\n", identity_offset);
-    printf("    nSpecialSlots: %d\n", special_slot_size);
-    printf("    nCodeSlots   : %d\n", ntohl(codeDirectory->nCodeSlots));
-    printf("    codeLimit    : %d\n", ntohl(codeDirectory->codeLimit));
-    printf("    hashSize     : %d\n", hash_size);
-    printf("    hashType     : %s\n", hash_type);
-    printf("    platform     : %d\n", (codeDirectory->platform));
-    printf("    pageSize     : %d\n", (int)pow(2, codeDirectory->pageSize));
-    printf("    identity     : %s\n", (char *)codeDirectory + identity_offset);
+    formatHashType(codeDirectory.hashType, hash_type, sizeof(hash_type));
+
+    fprintf(textOutput(), "    version      : %#x\n", codeDirectory.version);
+    fprintf(textOutput(), "    flags        : %#x\n", codeDirectory.flags);
+    fprintf(textOutput(), "    hashOffset   : %d\n", codeDirectory.hashOffset);
+    fprintf(textOutput(), "    identOffset  : %d\n", codeDirectory.identOffset);
+    fprintf(textOutput(), "    nSpecialSlots: %d\n", codeDirectory.nSpecialSlots);
+    fprintf(textOutput(), "    nCodeSlots   : %d\n", codeDirectory.nCodeSlots);
+    fprintf(textOutput(), "    codeLimit    : %d\n", codeDirectory.codeLimit);
+    fprintf(textOutput(), "    hashSize     : %d\n", codeDirectory.hashSize);
+    fprintf(textOutput(), "    hashType     : %s\n", hash_type);
+    fprintf(textOutput(), "    platform     : %d\n", codeDirectory.platform);
+    fprintf(textOutput(), "    pageSize     : %d\n", (int)pow(2, codeDirectory.pageSize));
+    fprintf(textOutput(), "    identity     : %s\n", codeDirectory.identity);
 
     auto cdhash = cdHash(codeDirectory);
-    printf("    CDHash       : %s\n", cdhash.c_str());
-    printf("\n");
+    fprintf(textOutput(), "    CDHash       : %s\n", cdhash.c_str());
+    fprintf(textOutput(), "\n");
 
-    uint8_t *hash_base = (uint8_t *)codeDirectory + hash_offset;
+    int special_slot_size = codeDirectory.nSpecialSlots;
+    int slot_size = codeDirectory.nCodeSlots;
     for (int i = special_slot_size; i > 0; --i) {
-        auto hash = formatBufferToHex(hash_base - i * hash_size, hash_size);
-        printf("    Slot[%3d] : %s\n", -i, hash.c_str());
+        auto hash = formatBufferToHex(codeDirectory.slotHash(-i), codeDirectory.hashSize);
+        fprintf(textOutput(), "    Slot[%3d] : %s\n", -i, hash.c_str());
     }
 
     int max_number = args.no_truncate ? slot_size : (slot_size > 10 ? 10 : slot_size);
 
     for (int i = 0; i < max_number; ++i) {
-        auto hash = formatBufferToHex(hash_base + i * hash_size, hash_size);
-        printf("    Slot[%3d] : %s\n", i, hash.c_str());
+        auto hash = formatBufferToHex(codeDirectory.slotHash(i), codeDirectory.hashSize);
+        fprintf(textOutput(), "    Slot[%3d] : %s\n", i, hash.c_str());
     }
 
     if (!args.no_truncate && slot_size > 10) {
-        printf("        ... %d more ...\n", slot_size - 10);
+        fprintf(textOutput(), "        ... %d more ...\n", slot_size - 10);
     }
-    printf("\n");
+    fprintf(textOutput(), "\n");
 }
 
 #ifdef OPENSSL
@@ -153,7 +118,7 @@ static void printPKCS7(const unsigned char *data, size_t size) {
     assert(pkcs7 != NULL);
 
     BIO *bio = BIO_new(BIO_s_file());
-    BIO_set_fp(bio, stdout, BIO_NOCLOSE);
+    BIO_set_fp(bio, textOutput(), BIO_NOCLOSE);
     PKCS7_print_ctx(bio, pkcs7, 4, NULL);
     BIO_free(bio);
 }
@@ -171,7 +136,7 @@ static std::string sha1(const unsigned char *data, size_t size) {
 #else
 
 static void printPKCS7(const unsigned char *data, size_t size) {
-    puts("    Info: To show detailed PKCS7 information, use 'build.sh --openssl' and run again.");
+    fputs("    Info: To show detailed PKCS7 information, use 'build.sh --openssl' and run again.\n", textOutput());
 }
 
 static std::string sha256(const unsigned char *data, size_t size) {
@@ -184,13 +149,13 @@ static std::string sha1(const unsigned char *data, size_t size) {
 
 #endif
 
-static std::string cdHash(CS_CodeDirectory *codeDirectory) {
-    switch(codeDirectory->hashType) {
+static std::string cdHash(const CodeDirectory &codeDirectory) {
+    switch(codeDirectory.hashType) {
         case CS_HASHTYPE_SHA1:
-            return sha1((unsigned char *)codeDirectory, ntohl(codeDirectory->length));
+            return sha1(codeDirectory.base, codeDirectory.length);
         case CS_HASHTYPE_SHA256:
         case CS_HASHTYPE_SHA256_TRUNCATED:
-            return sha256((unsigned char *)codeDirectory, ntohl(codeDirectory->length));
+            return sha256(codeDirectory.base, codeDirectory.length);
         default:
             return "Unsupported hash type.";
     }
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include <string>
+
+#include "utils/utils.h"
+#include "argument.h"
+#include "core/rebase_bind.h"
+#include "core/fixup_chains.h"
+#include "core/exports.h"
+
+#include "columnar_export.h"
+
+// the kind column of binds.col
+enum BindKind {
+    BIND_KIND_REGULAR = 0,
+    BIND_KIND_LAZY,
+    BIND_KIND_WEAK,
+};
+
+static void exportSections(const MachoImage &image, const std::string &path);
+static void exportSymbols(const MachoImage &image, const std::string &path);
+static void exportRebases(const MachoImage &image, const std::string &path);
+static void exportBinds(const MachoImage &image, const std::string &path);
+static void exportChainedFixups(const MachoImage &image, const std::string &path);
+static void exportExports(const MachoImage &image, const std::string &path);
+static void writeTable(const ColumnTableWriter &table, const std::string &path);
+static uint64_t segmentAddress(const MachoImage &image, int segmentIndex);
+
+void exportColumns(const MachoImage &image, const char *dir) {
+    std::string prefix = std::string(dir) + "/";
+
+    try {
+        exportSections(image, prefix + "sections.col");
+        exportSymbols(image, prefix + "symbols.col");
+        exportRebases(image, prefix + "rebases.col");
+        exportBinds(image, prefix + "binds.col");
+        exportChainedFixups(image, prefix + "chained_fixups.col");
+        exportExports(image, prefix + "exports.col");
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        exit(1);
+    }
+}
+
+static void exportSections(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t index = table.addColumn("index", COLUMN_U32);
+    size_t segname = table.addColumn("segname", COLUMN_STRING);
+    size_t sectname = table.addColumn("sectname", COLUMN_STRING);
+    size_t addr = table.addColumn("addr", COLUMN_U64);
+    size_t size = table.addColumn("size", COLUMN_U64);
+    size_t offset = table.addColumn("offset", COLUMN_U32);
+    size_t align = table.addColumn("align", COLUMN_U32);
+    size_t flags = table.addColumn("flags", COLUMN_U32);
+
+    uint32_t ordinal = 1;
+    for (SectionView sect : image.getSections()) {
+        table.append(index, ordinal++);
+        table.appendString(segname, sect.segmentName());
+        table.appendString(sectname, sect.name());
+        table.append(addr, sect.address());
+        table.append(size, sect.size());
+        table.append(offset, sect.offset());
+        table.append(align, sect.align());
+        table.append(flags, sect.flags());
+    }
+
+    writeTable(table, path);
+}
+
+static void exportSymbols(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t index = table.addColumn("index", COLUMN_U32);
+    size_t name = table.addColumn("name", COLUMN_STRING);
+    size_t type = table.addColumn("n_type", COLUMN_U8);
+    size_t sect = table.addColumn("n_sect", COLUMN_U8);
+    size_t desc = table.addColumn("n_desc", COLUMN_U16);
+    size_t value = table.addColumn("n_value", COLUMN_U64);
+    // the library ordinal of undefined symbols in a two-level namespace image, otherwise 0
+    size_t dylib = table.addColumn("dylib_ordinal", COLUMN_U8);
+
+    if (image.symtabCmd != nullptr) {
+        bool twoLevel = image.header->flags & MH_TWOLEVEL;
+
+        uint32_t i = 0;
+        for (SymbolView symbol : image.getSymbols()) {
+            table.append(index, i++);
+            table.appendString(name, symbol.name());
+            table.append(type, symbol.type());
+            table.append(sect, symbol.sect());
+            table.append(desc, symbol.desc());
+            table.append(value, symbol.value());
+            table.append(dylib, symbol.isUndefined() && twoLevel ? GET_LIBRARY_ORDINAL(symbol.desc()) : 0);
+        }
+    }
+
+    writeTable(table, path);
+}
+
+static void exportRebases(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t segIndex = table.addColumn("seg_index", COLUMN_U32);
+    size_t segOffset = table.addColumn("seg_offset", COLUMN_U64);
+    size_t address = table.addColumn("address", COLUMN_U64);
+    size_t type = table.addColumn("type", COLUMN_U8);
+
+    struct dyld_info_command *cmd = image.dyldInfoCmd;
+    if (cmd != nullptr && cmd->rebase_size > 0) {
+        RebaseTable rebases = decodeRebaseTable(image, cmd->rebase_off, cmd->rebase_size);
+        for (size_t i = 0; i < rebases.count; ++i) {
+            table.append(segIndex, rebases.segmentIndexes[i]);
+            table.append(segOffset, rebases.segmentOffsets[i]);
+            table.append(address, segmentAddress(image, rebases.segmentIndexes[i]) + rebases.segmentOffsets[i]);
+            table.append(type, rebases.types[i]);
+        }
+    }
+
+    writeTable(table, path);
+}
+
+static void exportBinds(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t kind = table.addColumn("kind", COLUMN_U8);
+    size_t segIndex = table.addColumn("seg_index", COLUMN_U32);
+    size_t segOffset = table.addColumn("seg_offset", COLUMN_U64);
+    size_t address = table.addColumn("address", COLUMN_U64);
+    size_t type = table.addColumn("type", COLUMN_U8);
+    size_t ordinal = table.addColumn("dylib_ordinal", COLUMN_I32);
+    size_t symbol = table.addColumn("symbol", COLUMN_STRING);
+    size_t flags = table.addColumn("flags", COLUMN_U8);
+    size_t addend = table.addColumn("addend", COLUMN_I64);
+
+    struct dyld_info_command *cmd = image.dyldInfoCmd;
+    if (cmd != nullptr) {
+        auto exportKind = [&](BindKind bindKind, uint32_t offset, uint32_t size) {
+            if (size == 0) {
+                return;
+            }
+            BindTable binds = decodeBindTable(image, offset, size);
+            for (size_t i = 0; i < binds.count; ++i) {
+                const char *symbolName = binds.symbolName(i);
+                table.append(kind, bindKind);
+                table.append(segIndex, binds.segmentIndexes[i]);
+                table.append(segOffset, binds.segmentOffsets[i]);
+                table.append(address, segmentAddress(image, binds.segmentIndexes[i]) + binds.segmentOffsets[i]);
+                table.append(type, binds.types[i]);
+                table.append(ordinal, binds.dylibOrdinals[i]);
+                table.appendString(symbol, symbolName != nullptr ? symbolName : "");
+                table.append(flags, binds.symbolFlags[i]);
+                table.append(addend, binds.addends[i]);
+            }
+        };
+
+        exportKind(BIND_KIND_REGULAR, cmd->bind_off, cmd->bind_size);
+        exportKind(BIND_KIND_LAZY, cmd->lazy_bind_off, cmd->lazy_bind_size);
+        exportKind(BIND_KIND_WEAK, cmd->weak_bind_off, cmd->weak_bind_size);
+    }
+
+    writeTable(table, path);
+}
+
+static void exportChainedFixups(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t segIndex = table.addColumn("seg_index", COLUMN_U32);
+    size_t vmOffset = table.addColumn("vm_offset", COLUMN_U64);
+    // 0 for a rebase and 1 for a bind
+    size_t bind = table.addColumn("bind", COLUMN_U8);
+    size_t target = table.addColumn("target", COLUMN_U64);
+    size_t high8 = table.addColumn("high8", COLUMN_U8);
+    size_t importOrdinal = table.addColumn("import_ordinal", COLUMN_U32);
+    size_t libOrdinal = table.addColumn("lib_ordinal", COLUMN_I32);
+    size_t symbol = table.addColumn("symbol", COLUMN_STRING);
+    size_t addend = table.addColumn("addend", COLUMN_I64);
+    size_t auth = table.addColumn("auth", COLUMN_U8);
+    size_t key = table.addColumn("key", COLUMN_U8);
+    size_t addrDiv = table.addColumn("addr_div", COLUMN_U8);
+    size_t diversity = table.addColumn("diversity", COLUMN_U16);
+
+    if (image.chainedFixupsCmd != nullptr) {
+        for (const ChainedFixupRecord &fixup : decodeChainedFixups(image, args.jobs)) {
+            table.append(segIndex, fixup.segmentIndex);
+            table.append(vmOffset, fixup.vmOffset);
+            table.append(bind, fixup.bind);
+            table.append(target, fixup.bind ? 0 : fixup.target);
+            table.append(high8, fixup.bind ? 0 : fixup.high8);
+            table.append(importOrdinal, fixup.bind ? fixup.importOrdinal : 0);
+            table.append(libOrdinal, fixup.bind ? fixup.libOrdinal : 0);
+            table.appendString(symbol, fixup.bind ? fixup.symbolName : "");
+            table.append(addend, fixup.bind ? fixup.addend : 0);
+            table.append(auth, fixup.auth);
+            table.append(key, fixup.key);
+            table.append(addrDiv, fixup.addrDiv);
+            table.append(diversity, fixup.diversity);
+        }
+    }
+
+    writeTable(table, path);
+}
+
+static void exportExports(const MachoImage &image, const std::string &path) {
+    ColumnTableWriter table;
+    size_t name = table.addColumn("name", COLUMN_STRING);
+    size_t flags = table.addColumn("flags", COLUMN_U64);
+    size_t address = table.addColumn("address", COLUMN_U64);
+    size_t resolver = table.addColumn("resolver", COLUMN_U64);
+    size_t dylibOrdinal = table.addColumn("dylib_ordinal", COLUMN_I32);
+    size_t importName = table.addColumn("import_name", COLUMN_STRING);
+
+    forEachExport(image, [&](const ExportRecord &record) {
+        table.appendString(name, record.name);
+        table.append(flags, record.flags);
+        table.append(address, record.address);
+        table.append(resolver, record.resolver);
+        table.append(dylibOrdinal, record.dylibOrdinal);
+        table.appendString(importName, record.importName != nullptr ? record.importName : "");
+    });
+
+    writeTable(table, path);
+}
+
+static void writeTable(const ColumnTableWriter &table, const std::string &path) {
+    table.write(path.c_str());
+    fprintf(textOutput(), "%-40s %zu rows\n", path.c_str(), table.rowCount());
+}
+
+static uint64_t segmentAddress(const MachoImage &image, int segmentIndex) {
+    if (segmentIndex < 0 || segmentIndex >= image.segmentCommands.size()) {
+        return 0;
+    }
+    return image.segmentCommands[segmentIndex]->vmaddr;
+}
@@ -0,0 +1,13 @@
+#ifndef COLUMNAR_EXPORT_H
+#define COLUMNAR_EXPORT_H
+
+#include "core/macho_image.h"
+
+// Export the image for analytics, --export-columns DIR.
+//
+// Each table is written to DIR as a ColumnTableWriter file (see utils.h): sections.col, symbols.col,
+// rebases.col, binds.col, chained_fixups.col and exports.col. Tables whose load command is absent are written empty,
+// so a set of exports always has the same files and columns. DIR must exist.
+void exportColumns(const MachoImage &image, const char *dir);
+
+#endif /* COLUMNAR_EXPORT_H */
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ar.h>
+#include "apple/mach-o/ranlib.h"
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils/utils.h"
+#include "core/ar_parser.h"
+
+// BSD's <ar.h> defines the prefix of extended format names, like "#1/20", but glibc's doesn't.
+#ifndef AR_EFMT1
+#define AR_EFMT1 "#1/"
+#endif
+
+// This file handles parsing archive (static library) format
+
+bool Archive::isArchive(uint8_t *fileBase, uint64_t fileSize) {
+    return fileSize >= strlen(ARMAG) && strncmp(ARMAG,(char *)fileBase, strlen(ARMAG)) == 0;
+}
+
+uint64_t Archive::memberSizeAt(uint8_t *header) {
+    struct ar_hdr *metadata = (struct ar_hdr *)header;
+    if (strncmp(ARFMAG, metadata->ar_fmag, strlen(ARFMAG)) != 0) {
+        // not a member header, which callers treat as out of bounds
+        return 0;
+    }
+    // ar_size is decimal padded with spaces and isn't null-terminated. Ten digits don't fit in an int.
+    const char *digit = metadata->ar_size;
+    const char *end = metadata->ar_size + sizeof(metadata->ar_size);
+    while (digit < end && *digit == ' ') {
+        ++digit;
+    }
+    uint64_t size = 0;
+    for (; digit < end && *digit >= '0' && *digit <= '9'; ++digit) {
+        size = size * 10 + (*digit - '0');
+    }
+    return sizeof(struct ar_hdr) + size;
+}
+
+Archive::Member Archive::memberAt(uint8_t *header, uint64_t headerOffset) {
+    struct ar_hdr *metadata = (struct ar_hdr *)header;
+    uint8_t *content = header + sizeof(struct ar_hdr);
+    uint64_t memberSize = std::max<uint64_t>(memberSizeAt(header), sizeof(struct ar_hdr)) - sizeof(struct ar_hdr);
+
+    // BSD archives store long names right after the header, and the name is part of ar_size.
+    std::string objectFileName;
+    uint64_t efmtSize = 0;
+    if (strncmp(AR_EFMT1, metadata->ar_name, strlen(AR_EFMT1)) == 0) {
+        efmtSize = std::clamp<int64_t>(atoi(metadata->ar_name + strlen(AR_EFMT1)), 0, memberSize);
+        objectFileName = std::string((char *)content, strnlen((char *)content, efmtSize));
+    } else {
+        objectFileName = std::string(metadata->ar_name, sizeof(metadata->ar_name));
+        objectFileName.erase(objectFileName.find_last_not_of(' ') + 1);
+    }
+
+    return {objectFileName, headerOffset, content + efmtSize, memberSize - efmtSize};
+}
+
+std::vector<Archive::Member> Archive::indexMembers(uint8_t *fileBase, uint64_t fileSize) {
+    assert(isArchive(fileBase, fileSize));
+
+    std::vector<Member> members;
+    uint64_t offset = strlen(ARMAG);
+    while (offset + sizeof(struct ar_hdr) <= fileSize) {
+        // A member that runs past the end of the file ends the archive, like a truncated header does.
+        uint64_t memberSize = memberSizeAt(fileBase + offset);
+        if (memberSize < sizeof(struct ar_hdr) || memberSize > fileSize - offset) {
+            break;
+        }
+        Member member = memberAt(fileBase + offset, offset);
+
+        // The first member in a static archive library is always the symbol table describing the contents of the rest of the member files.
+        // It's always called __.SYMDEF or __.SYMDEF SORTED. We just skip this.
+        // http://mirror.informatimago.com/next/developer.apple.com/documentation/DeveloperTools/Conceptual/MachORuntime/8rt_file_format/chapter_10_section_33.html
+        if (member.name.compare(0, strlen(SYMDEF), SYMDEF) != 0) {
+            members.push_back(member);
+        }
+
+        offset += memberSize;
+    }
+
+    return members;
+}
+
+void Archive::enumerateObjectFileInArchive(uint8_t *fileBase, uint64_t fileSize, std::function<void(char*, uint8_t*, uint64_t)> const& handler) {
+    for (auto &member : indexMembers(fileBase, fileSize)) {
+        handler((char *)member.name.c_str(), member.base, member.size);
+    }
+}
+
+void Archive::enumerateObjectFileInArchiveParallel(const std::vector<Member> &members,
+    std::function<void(size_t, const Member&)> const& handler, unsigned int threadCount) {
+    parallelFor(members.size(), [&members, &handler](size_t i) {
+        handler(i, members[i]);
+    }, threadCount);
+}
+
+// The layout of the symbol table member is
+//   ranlib size in bytes (uint32_t, or uint64_t for _64)
+//   struct ranlib[] (or struct ranlib_64[])
+//   string table size in bytes (uint32_t, or uint64_t for _64)
+//   string table
+Archive::SymbolTable::SymbolTable(uint8_t *archiveBase, uint64_t size) {
+    if (!isArchive(archiveBase, size) || strlen(ARMAG) + sizeof(struct ar_hdr) > size) {
+        return;
+    }
+
+    uint64_t headerOffset = strlen(ARMAG);
+    uint64_t memberSize = memberSizeAt(archiveBase + headerOffset);
+    if (memberSize < sizeof(struct ar_hdr) || memberSize > size - headerOffset) {
+        return;
+    }
+
+    Member member = memberAt(archiveBase + headerOffset, headerOffset);
+    if (member.name == SYMDEF || member.name == SYMDEF_SORTED) {
+        is64 = false;
+    } else if (member.name == SYMDEF_64 || member.name == SYMDEF_64_SORTED) {
+        is64 = true;
+    } else {
+        return;
+    }
+    sorted = (member.name == SYMDEF_SORTED || member.name == SYMDEF_64_SORTED);
+
+    const uint8_t *ranlibs;
+    try {
+        DataCursor cursor(member.base, member.size);
+        uint64_t ranlibSize = is64 ? cursor.read<uint64_t>() : cursor.read<uint32_t>();
+        ranlibs = cursor.readBytes(ranlibSize);
+        count = ranlibSize / (is64 ? sizeof(struct ranlib_64) : sizeof(struct ranlib));
+
+        stringsSize = is64 ? cursor.read<uint64_t>() : cursor.read<uint32_t>();
+        strings = (const char *)cursor.readBytes(stringsSize);
+    } catch (const std::exception &) {
+        // corrupted symbol table
+        count = 0;
+        return;
+    }
+
+    entries = (uint8_t *)ranlibs;
+
+    if (!sorted) {
+        symbolMap.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            // The first definition wins, which matches what the linker does.
+            symbolMap.emplace(symbolAt(i), offsetAt(i));
+        }
+    }
+}
+
+std::string_view Archive::SymbolTable::symbolAt(size_t index) const {
+    uint64_t strx = is64 ? ((struct ranlib_64 *)entries)[index].ran_un.ran_strx : ((struct ranlib *)entries)[index].ran_un.ran_strx;
+    if (strx >= stringsSize) {
+        return std::string_view();
+    }
+    return std::string_view(strings + strx, strnlen(strings + strx, stringsSize - strx));
+}
+
+uint64_t Archive::SymbolTable::offsetAt(size_t index) const {
+    return is64 ? ((struct ranlib_64 *)entries)[index].ran_off : ((struct ranlib *)entries)[index].ran_off;
+}
+
+bool Archive::SymbolTable::findMember(std::string_view symbol, uint64_t *headerOffset) const {
+    if (!isValid()) {
+        return false;
+    }
+
+    if (sorted) {
+        size_t low = 0, high = count;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (symbolAt(mid) < symbol) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        if (low < count && symbolAt(low) == symbol) {
+            *headerOffset = offsetAt(low);
+            return true;
+        }
+        return false;
+    }
+
+    auto it = symbolMap.find(symbol);
+    if (it == symbolMap.end()) {
+        return false;
+    }
+    *headerOffset = it->second;
+    return true;
+}
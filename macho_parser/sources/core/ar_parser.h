@@ -0,0 +1,69 @@
+#ifndef AR_PARSER_H
+#define AR_PARSER_H
+
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Archive {
+struct Member {
+    std::string name;
+    uint64_t headerOffset; // offset of the member's ar_hdr from the start of the archive
+    uint8_t *base;         // start of the member's content, after the extended name
+    uint64_t size;         // size of the member's content
+};
+
+// The ranlib symbol table in the first member of an archive (__.SYMDEF, __.SYMDEF_64 and their SORTED variants).
+// It maps every defined symbol to the header offset of the member that defines it.
+class SymbolTable {
+public:
+    // `archiveBase` only needs to cover the archive magic and the first member.
+    SymbolTable(uint8_t *archiveBase, uint64_t size);
+
+    // Whether the archive has a symbol table.
+    bool isValid() const { return entries != nullptr; }
+    // The sorted variant is sorted by symbol name and can be binary searched.
+    bool isSorted() const { return sorted; }
+    size_t size() const { return count; }
+
+    // Look up the member defining `symbol`. Binary search if the table is sorted, otherwise a hash lookup.
+    bool findMember(std::string_view symbol, uint64_t *headerOffset) const;
+
+private:
+    uint8_t *entries = nullptr; // struct ranlib[] or struct ranlib_64[]
+    size_t count = 0;
+    const char *strings = nullptr;
+    uint64_t stringsSize = 0;
+    bool is64 = false;
+    bool sorted = false;
+    std::unordered_map<std::string_view, uint64_t> symbolMap; // only for unsorted tables
+
+    std::string_view symbolAt(size_t index) const;
+    uint64_t offsetAt(size_t index) const;
+};
+
+bool isArchive(uint8_t *fileBase, uint64_t fileSize);
+
+// The size of the member whose ar_hdr is at `header`, including the header, or 0 if it's not a member header.
+// ar_size has 10 digits, so a member can be larger than 4 GB.
+uint64_t memberSizeAt(uint8_t *header);
+
+// Parse the member whose ar_hdr is at `header`. The whole member needs to be readable.
+Member memberAt(uint8_t *header, uint64_t headerOffset);
+
+// Walk the member headers once without touching the contents. The symbol table (__.SYMDEF) is skipped.
+std::vector<Member> indexMembers(uint8_t *archiveBase, uint64_t fileSize);
+
+void enumerateObjectFileInArchive(uint8_t *archiveBase, uint64_t fileSize, std::function<void(char*, uint8_t*, uint64_t)> const& handler);
+
+// Call `handler` for every member returned by indexMembers() on a pool of worker threads.
+// The handler runs concurrently and gets the member's position in the archive,
+// so the caller can keep one result per member and merge them in archive order.
+void enumerateObjectFileInArchiveParallel(const std::vector<Member> &members,
+    std::function<void(size_t, const Member&)> const& handler, unsigned int threadCount = 0);
+}
+
+#endif /* AR_PARSER_H */
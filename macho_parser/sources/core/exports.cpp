@@ -0,0 +1,76 @@
+#include <tuple>
+
+#include "utils/utils.h"
+#include "core/image_cache.h"
+#include "core/exports.h"
+
+static void decodeExports(const MachoImage &image, std::function<void(const ExportRecord&)> const& handler);
+
+std::pair<uint8_t *, uint32_t> getExportTrie(const MachoImage &image) {
+    if (image.exportsTrieCmd != nullptr) {
+        return {image.base + image.exportsTrieCmd->dataoff, image.exportsTrieCmd->datasize};
+    } else if (image.dyldInfoCmd != nullptr) {
+        return {image.base + image.dyldInfoCmd->export_off, image.dyldInfoCmd->export_size};
+    }
+    return {image.base, 0};
+}
+
+bool exportLookup(const MachoImage &image, std::string_view name, ExportRecord &record) {
+    uint8_t *trie;
+    uint32_t size;
+    std::tie(trie, size) = getExportTrie(image);
+    return lookupExportInTrie(trie, size, name, record);
+}
+
+void forEachExport(const MachoImage &image, std::function<void(const ExportRecord&)> const& handler) {
+    if (image.cache == nullptr) {
+        decodeExports(image, handler);
+        return;
+    }
+
+    // Import names are stored as offsets into the image, where they already are NUL-terminated.
+    const ColumnTableReader &table = image.cache->table("exports",
+        {{"name", COLUMN_STRING}, {"flags", COLUMN_U64}, {"address", COLUMN_U64}, {"resolver", COLUMN_U64},
+        {"dylib_ordinal", COLUMN_I32}, {"import_name_offset", COLUMN_U32}}, [&image](ColumnTableWriter &writer) {
+            decodeExports(image, [&](const ExportRecord &record) {
+                writer.appendString(0, record.name);
+                writer.append(1, record.flags);
+                writer.append(2, record.address);
+                writer.append(3, record.resolver);
+                writer.append(4, record.dylibOrdinal);
+                writer.append(5, record.importName != nullptr ? (const uint8_t *)record.importName - image.base : 0);
+            });
+        }, [&image](const ColumnTableReader &table) {
+            const uint32_t *importNameOffsets = (const uint32_t *)table.columnData(5);
+            for (uint64_t i = 0; i < table.rowCount(); ++i) {
+                if (importNameOffsets[i] != 0 && !image.hasCString(importNameOffsets[i])) {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+    const uint64_t *flags = (const uint64_t *)table.columnData(1);
+    const uint64_t *addresses = (const uint64_t *)table.columnData(2);
+    const uint64_t *resolvers = (const uint64_t *)table.columnData(3);
+    const int32_t *dylibOrdinals = (const int32_t *)table.columnData(4);
+    const uint32_t *importNameOffsets = (const uint32_t *)table.columnData(5);
+    for (uint64_t i = 0; i < table.rowCount(); ++i) {
+        const char *importName = importNameOffsets[i] != 0 ? (const char *)image.base + importNameOffsets[i] : nullptr;
+        handler({table.string(0, i), flags[i], addresses[i], resolvers[i], dylibOrdinals[i], importName});
+    }
+}
+
+static void decodeExports(const MachoImage &image, std::function<void(const ExportRecord&)> const& handler) {
+    uint8_t *trie;
+    uint32_t size;
+    std::tie(trie, size) = getExportTrie(image);
+    if (size == 0) {
+        return;
+    }
+
+    ExportTrieIterator it(trie, size);
+    while (it.next()) {
+        handler(it.record());
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef EXPORTS_H
+#define EXPORTS_H
+
+#include <functional>
+#include <string_view>
+#include <utility>
+
+#include "utils/utils.h"
+#include "core/macho_image.h"
+
+// The export trie from LC_DYLD_EXPORTS_TRIE or LC_DYLD_INFO, and its size, which is 0 if there is none.
+std::pair<uint8_t *, uint32_t> getExportTrie(const MachoImage &image);
+
+// Look up `name` in the export trie of the image with lookupExportInTrie().
+bool exportLookup(const MachoImage &image, std::string_view name, ExportRecord &record);
+
+// Walk the export trie of the image, from LC_DYLD_EXPORTS_TRIE or LC_DYLD_INFO, and call `handler`
+// for every exported symbol. The name is only valid during the call.
+void forEachExport(const MachoImage &image, std::function<void(const ExportRecord&)> const& handler);
+
+#endif // EXPORTS_H
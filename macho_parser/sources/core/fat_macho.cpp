@@ -0,0 +1,63 @@
+#include <string.h>
+#include <assert.h>
+#include "apple/mach-o/swap.h"
+
+#include "core/fat_macho.h"
+
+#define NEEDS_SWAP(magic) (magic == FAT_CIGAM || magic == FAT_CIGAM_64)
+#define IS_64(magic) (magic == FAT_MAGIC_64 || magic == FAT_CIGAM_64)
+
+bool FatMacho::isFatMacho(uint8_t *fileBase, uint64_t fileSize) {
+    if (fileSize < sizeof(struct fat_header)) return false;
+    uint32_t magic = *(uint32_t *)fileBase;
+    return (magic == FAT_MAGIC || magic == FAT_CIGAM || magic == FAT_MAGIC_64 || magic == FAT_CIGAM_64);
+}
+
+bool FatMacho::readFatArchs(uint8_t *fileBase, uint64_t fileSize, struct fat_header &header, std::vector<struct fat_arch_64> &archs) {
+    assert(isFatMacho(fileBase, fileSize));
+
+    uint32_t magic = *(uint32_t *)fileBase;
+    bool needsSwap = NEEDS_SWAP(magic);
+    header = *(struct fat_header *)fileBase;
+    if (needsSwap) {
+        swap_fat_header(&header, NX_UnknownByteOrder);
+    }
+
+    uint64_t archSize = IS_64(magic) ? sizeof(struct fat_arch_64) : sizeof(struct fat_arch);
+    if (archSize * header.nfat_arch > fileSize - sizeof(header)) {
+        return false;
+    }
+    archs.resize(header.nfat_arch);
+
+    if (IS_64(magic)) {
+        memcpy(archs.data(), fileBase + sizeof(header), archSize * header.nfat_arch);
+        if (needsSwap) {
+            swap_fat_arch_64(archs.data(), header.nfat_arch, NX_UnknownByteOrder);
+        }
+        return true;
+    }
+
+    std::vector<struct fat_arch> archs32(header.nfat_arch);
+    memcpy(archs32.data(), fileBase + sizeof(header), archSize * header.nfat_arch);
+    if (needsSwap) {
+        swap_fat_arch(archs32.data(), header.nfat_arch, NX_UnknownByteOrder);
+    }
+    for (uint32_t i = 0; i < header.nfat_arch; ++i) {
+        archs[i] = {archs32[i].cputype, archs32[i].cpusubtype, archs32[i].offset, archs32[i].size, archs32[i].align, 0};
+    }
+    return true;
+}
+
+void FatMacho::enumerateSlices(uint8_t *fileBase, uint64_t fileSize, std::function<void(cpu_type_t, uint8_t*, uint64_t)> const& handler) {
+    struct fat_header header;
+    std::vector<struct fat_arch_64> archs;
+    if (!readFatArchs(fileBase, fileSize, header, archs)) {
+        return;
+    }
+
+    for (const struct fat_arch_64 &arch : archs) {
+        if (arch.offset <= fileSize && arch.size <= fileSize - arch.offset) {
+            handler(arch.cputype, fileBase + arch.offset, arch.size);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef FAT_MACHO_H
+#define FAT_MACHO_H
+
+#include "apple/mach-o/fat.h"
+#include <functional>
+#include <vector>
+
+namespace FatMacho {
+// Both FAT_MAGIC and FAT_MAGIC_64, which is used when a slice is past 4 GB.
+bool isFatMacho(uint8_t *fileBase, uint64_t fileSize);
+
+// Read the fat header and the arch table in host byte order. The entries of a 32-bit table are widened to
+// fat_arch_64. Return false if the arch table runs past `fileSize`.
+bool readFatArchs(uint8_t *fileBase, uint64_t fileSize, struct fat_header &header, std::vector<struct fat_arch_64> &archs);
+
+// Call `handler` with the cpu type, base and size of every slice that is inside the file. Nothing is printed.
+void enumerateSlices(uint8_t *fileBase, uint64_t fileSize, std::function<void(cpu_type_t, uint8_t*, uint64_t)> const& handler);
+}
+
+#endif /* FAT_MACHO_H */
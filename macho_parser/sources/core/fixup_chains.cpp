@@ -0,0 +1,524 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "apple/mach-o/fixup-chains.h"
+#include <stdexcept>
+#include <string>
+
+#include "utils/utils.h"
+#include "core/fixup_chains.h"
+
+static DataCursor getFixupsData(const MachoImage &image);
+static struct dyld_chained_fixups_header *getFixupsHeader(DataCursor fixups);
+static struct dyld_chained_starts_in_image *getStartsInImage(const MachoImage &image, DataCursor fixups);
+static struct dyld_chained_starts_in_segment *getStartsInSegment(const MachoImage &image, DataCursor fixups, int segmentIndex);
+
+void forEachChainedFixup(const MachoImage &image, std::function<void(const ChainedFixupRecord&)> const& handler) {
+    if (image.chainedFixupsCmd == nullptr) {
+        return;
+    }
+
+    DataCursor fixups = getFixupsData(image);
+    struct dyld_chained_starts_in_image *startsInImage = getStartsInImage(image, fixups);
+
+    for (int i = 0; i < startsInImage->seg_count; ++i) {
+        struct dyld_chained_starts_in_segment *startsInSegment = getStartsInSegment(image, fixups, i);
+        if (startsInSegment == nullptr) {
+            continue;
+        }
+
+        for (int pageIndex = 0; pageIndex < startsInSegment->page_count; ++pageIndex) {
+            forEachChainedFixupInPage(image, i, pageIndex, [&handler](const ChainedFixupRecord &record) {
+                handler(record);
+                return true;
+            });
+        }
+    }
+}
+
+struct dyld_chained_fixups_header *getChainedFixupsHeader(const MachoImage &image) {
+    return getFixupsHeader(getFixupsData(image));
+}
+
+struct dyld_chained_starts_in_image *getChainedStartsInImage(const MachoImage &image) {
+    return getStartsInImage(image, getFixupsData(image));
+}
+
+struct dyld_chained_starts_in_segment *getChainedStartsInSegment(const MachoImage &image, int segmentIndex) {
+    return getStartsInSegment(image, getFixupsData(image), segmentIndex);
+}
+
+// A page with fixups, the unit of work of the parallel decoders.
+struct ChainedPage {
+    int segmentIndex;
+    int pageIndex;
+};
+
+static std::vector<ChainedPage> collectPages(const MachoImage &image, int segmentIndex);
+static std::vector<std::vector<ChainedFixupRecord>> decodePages(const MachoImage &image,
+    const std::vector<ChainedPage> &pages, unsigned int threadCount);
+
+std::vector<std::vector<ChainedFixupRecord>> decodeChainedFixupPages(const MachoImage &image, int segmentIndex,
+    unsigned int threadCount) {
+    struct dyld_chained_starts_in_segment *startsInSegment = getStartsInSegment(image, getFixupsData(image), segmentIndex);
+    if (startsInSegment == nullptr) {
+        return {};
+    }
+
+    std::vector<ChainedPage> pages = collectPages(image, segmentIndex);
+    std::vector<std::vector<ChainedFixupRecord>> decoded = decodePages(image, pages, threadCount);
+
+    // Put the pages back to their indexes. Pages without fixups stay empty.
+    std::vector<std::vector<ChainedFixupRecord>> result(startsInSegment->page_count);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        result[pages[i].pageIndex] = std::move(decoded[i]);
+    }
+    return result;
+}
+
+std::vector<ChainedFixupRecord> decodeChainedFixups(const MachoImage &image, unsigned int threadCount) {
+    if (image.chainedFixupsCmd == nullptr) {
+        return {};
+    }
+
+    // Partition all the pages of all the segments at once, so small segments don't leave cores idle.
+    std::vector<ChainedPage> pages = collectPages(image, -1);
+    std::vector<std::vector<ChainedFixupRecord>> decoded = decodePages(image, pages, threadCount);
+
+    size_t total = 0;
+    for (auto &records : decoded) {
+        total += records.size();
+    }
+
+    std::vector<ChainedFixupRecord> result;
+    result.reserve(total);
+    for (auto &records : decoded) {
+        result.insert(result.end(), records.begin(), records.end());
+    }
+    return result;
+}
+
+// The pages that have fixups in the segment at `segmentIndex`, or in all the segments if it's -1, in order.
+static std::vector<ChainedPage> collectPages(const MachoImage &image, int segmentIndex) {
+    DataCursor fixups = getFixupsData(image);
+    struct dyld_chained_starts_in_image *startsInImage = getStartsInImage(image, fixups);
+
+    std::vector<ChainedPage> pages;
+    for (int i = 0; i < startsInImage->seg_count; ++i) {
+        if (segmentIndex >= 0 && i != segmentIndex) {
+            continue;
+        }
+
+        struct dyld_chained_starts_in_segment *startsInSegment = getStartsInSegment(image, fixups, i);
+        if (startsInSegment == nullptr) {
+            continue;
+        }
+
+        for (int j = 0; j < startsInSegment->page_count; ++j) {
+            if (startsInSegment->page_start[j] != DYLD_CHAINED_PTR_START_NONE) {
+                pages.push_back({i, j});
+            }
+        }
+    }
+    return pages;
+}
+
+// Every page is decoded into its own buffer, so the workers never share anything but the image.
+static std::vector<std::vector<ChainedFixupRecord>> decodePages(const MachoImage &image,
+    const std::vector<ChainedPage> &pages, unsigned int threadCount) {
+    std::vector<std::vector<ChainedFixupRecord>> decoded(pages.size());
+
+    parallelFor(pages.size(), [&](size_t i) {
+        std::vector<ChainedFixupRecord> &records = decoded[i];
+        forEachChainedFixupInPage(image, pages[i].segmentIndex, pages[i].pageIndex, [&records](const ChainedFixupRecord &record) {
+            records.push_back(record);
+            return true;
+        });
+    }, threadCount);
+
+    return decoded;
+}
+
+ChainedImportTable::ChainedImportTable(const MachoImage &image) {
+    DataCursor fixups = getFixupsData(image);
+    struct dyld_chained_fixups_header *header = getFixupsHeader(fixups);
+
+    size_t importSize;
+    switch (header->imports_format) {
+        case DYLD_CHAINED_IMPORT: importSize = sizeof(struct dyld_chained_import); break;
+        case DYLD_CHAINED_IMPORT_ADDEND: importSize = sizeof(struct dyld_chained_import_addend); break;
+        case DYLD_CHAINED_IMPORT_ADDEND64: importSize = sizeof(struct dyld_chained_import_addend64); break;
+        default:
+            throw std::runtime_error("Unknown chained fixups imports format " + std::to_string(header->imports_format));
+    }
+    if (header->imports_offset + (uint64_t)header->imports_count * importSize > fixups.size()) {
+        throw std::runtime_error("Chained fixups imports are out of bounds");
+    }
+
+    imports = fixups.data() + header->imports_offset;
+    importsFormat = header->imports_format;
+    count = header->imports_count;
+    symbols = image.getChainedFixupsSymbols();
+}
+
+ChainedImport ChainedImportTable::operator[](uint32_t index) const {
+    if (index >= count) {
+        throw std::runtime_error("Chained fixup import ordinal is out of bounds");
+    }
+
+    ChainedImport import = {};
+    switch (importsFormat) {
+        case DYLD_CHAINED_IMPORT: {
+            struct dyld_chained_import raw;
+            memcpy(&raw, imports + index * sizeof(raw), sizeof(raw));
+            import = {(int8_t)raw.lib_ordinal, (bool)raw.weak_import, raw.name_offset, 0, nullptr};
+            break;
+        }
+        case DYLD_CHAINED_IMPORT_ADDEND: {
+            struct dyld_chained_import_addend raw;
+            memcpy(&raw, imports + index * sizeof(raw), sizeof(raw));
+            import = {(int8_t)raw.lib_ordinal, (bool)raw.weak_import, raw.name_offset, raw.addend, nullptr};
+            break;
+        }
+        case DYLD_CHAINED_IMPORT_ADDEND64: {
+            struct dyld_chained_import_addend64 raw;
+            memcpy(&raw, imports + index * sizeof(raw), sizeof(raw));
+            // The ordinal is 16 bits wide here, so the special ordinals are 0xFFFF and below.
+            import = {(int16_t)raw.lib_ordinal, (bool)raw.weak_import, (uint32_t)raw.name_offset, (int64_t)raw.addend, nullptr};
+            break;
+        }
+    }
+
+    if (import.nameOffset >= symbols.size()) {
+        throw std::runtime_error("Chained fixup import name is out of bounds");
+    }
+    import.name = symbols.data() + import.nameOffset;
+    return import;
+}
+
+// The layout of every pointer format. Each one has the type of the stored pointer, the stride of `next`
+// and a decode() that fills the record and returns false if the location isn't a real fixup.
+// walkChain() is instantiated once per format, so the loop over a chain never branches on the format.
+
+template <typename T, typename Raw>
+static T bitCast(Raw raw) {
+    static_assert(sizeof(T) == sizeof(Raw), "pointer layouts must have the size of the pointer");
+    T value;
+    memcpy(&value, &raw, sizeof(T));
+    return value;
+}
+
+// Sign extend the low `bits` bits of `value`.
+static int64_t signExtend(uint64_t value, int bits) {
+    return (int64_t)(value << (64 - bits)) >> (64 - bits);
+}
+
+// DYLD_CHAINED_PTR_64, DYLD_CHAINED_PTR_64_OFFSET
+struct ChainedPtr64 {
+    typedef uint64_t Raw;
+    static const int stride = 4;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_64_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *, ChainedFixupRecord &record) {
+        struct dyld_chained_ptr_64_bind bind = bitCast<struct dyld_chained_ptr_64_bind>(raw);
+        record.bind = bind.bind;
+        if (bind.bind) {
+            record.importOrdinal = bind.ordinal;
+            record.addend = bind.addend;
+        } else {
+            struct dyld_chained_ptr_64_rebase rebase = bitCast<struct dyld_chained_ptr_64_rebase>(raw);
+            record.target = rebase.target;
+            record.high8 = rebase.high8;
+        }
+        return true;
+    }
+};
+
+// DYLD_CHAINED_PTR_ARM64E and its variants, which differ in the stride and the width of the bind ordinal.
+template <int Stride, bool Bind24>
+struct ChainedPtrArm64e {
+    typedef uint64_t Raw;
+    static const int stride = Stride;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_arm64e_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *, ChainedFixupRecord &record) {
+        struct dyld_chained_ptr_arm64e_rebase rebase = bitCast<struct dyld_chained_ptr_arm64e_rebase>(raw);
+        record.bind = rebase.bind;
+        record.auth = rebase.auth;
+
+        if (rebase.auth) {
+            // All the auth layouts have diversity, addrDiv and key at the same bits.
+            struct dyld_chained_ptr_arm64e_auth_rebase authRebase = bitCast<struct dyld_chained_ptr_arm64e_auth_rebase>(raw);
+            record.diversity = authRebase.diversity;
+            record.addrDiv = authRebase.addrDiv;
+            record.key = authRebase.key;
+        }
+
+        if (rebase.bind && rebase.auth) {
+            record.importOrdinal = Bind24 ? bitCast<struct dyld_chained_ptr_arm64e_auth_bind24>(raw).ordinal
+                : bitCast<struct dyld_chained_ptr_arm64e_auth_bind>(raw).ordinal;
+        } else if (rebase.bind) {
+            if (Bind24) {
+                struct dyld_chained_ptr_arm64e_bind24 bind = bitCast<struct dyld_chained_ptr_arm64e_bind24>(raw);
+                record.importOrdinal = bind.ordinal;
+                record.addend = signExtend(bind.addend, 19);
+            } else {
+                struct dyld_chained_ptr_arm64e_bind bind = bitCast<struct dyld_chained_ptr_arm64e_bind>(raw);
+                record.importOrdinal = bind.ordinal;
+                record.addend = signExtend(bind.addend, 19);
+            }
+        } else if (rebase.auth) {
+            record.target = bitCast<struct dyld_chained_ptr_arm64e_auth_rebase>(raw).target;
+        } else {
+            record.target = rebase.target;
+            record.high8 = rebase.high8;
+        }
+        return true;
+    }
+};
+
+// DYLD_CHAINED_PTR_64_KERNEL_CACHE, DYLD_CHAINED_PTR_X86_64_KERNEL_CACHE
+template <int Stride>
+struct ChainedPtrKernelCache {
+    typedef uint64_t Raw;
+    static const int stride = Stride;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_64_kernel_cache_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *, ChainedFixupRecord &record) {
+        struct dyld_chained_ptr_64_kernel_cache_rebase rebase = bitCast<struct dyld_chained_ptr_64_kernel_cache_rebase>(raw);
+        record.target = rebase.target;
+        record.cacheLevel = rebase.cacheLevel;
+        record.auth = rebase.isAuth;
+        record.diversity = rebase.diversity;
+        record.addrDiv = rebase.addrDiv;
+        record.key = rebase.key;
+        return true;
+    }
+};
+
+// DYLD_CHAINED_PTR_32
+struct ChainedPtr32 {
+    typedef uint32_t Raw;
+    static const int stride = 4;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_32_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *startsInSegment, ChainedFixupRecord &record) {
+        struct dyld_chained_ptr_32_bind bind = bitCast<struct dyld_chained_ptr_32_bind>(raw);
+        record.bind = bind.bind;
+        if (bind.bind) {
+            record.importOrdinal = bind.ordinal;
+            record.addend = bind.addend;
+            return true;
+        }
+
+        // Rebases beyond max_valid_pointer are non-pointer values that are only in the chain to link it.
+        record.target = bitCast<struct dyld_chained_ptr_32_rebase>(raw).target;
+        return record.target <= startsInSegment->max_valid_pointer;
+    }
+};
+
+// DYLD_CHAINED_PTR_32_CACHE
+struct ChainedPtr32Cache {
+    typedef uint32_t Raw;
+    static const int stride = 4;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_32_cache_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *, ChainedFixupRecord &record) {
+        record.target = bitCast<struct dyld_chained_ptr_32_cache_rebase>(raw).target;
+        return true;
+    }
+};
+
+// DYLD_CHAINED_PTR_32_FIRMWARE
+struct ChainedPtr32Firmware {
+    typedef uint32_t Raw;
+    static const int stride = 4;
+
+    static uint32_t next(Raw raw) { return bitCast<struct dyld_chained_ptr_32_firmware_rebase>(raw).next; }
+
+    static bool decode(Raw raw, const struct dyld_chained_starts_in_segment *, ChainedFixupRecord &record) {
+        record.target = bitCast<struct dyld_chained_ptr_32_firmware_rebase>(raw).target;
+        return true;
+    }
+};
+
+// Everything the walker needs besides the pointer format.
+struct ChainContext {
+    uint8_t *base;
+    uint64_t imageSize;
+    struct dyld_chained_starts_in_segment *startsInSegment;
+    uint32_t pageStartCount;  // the number of page_start[] entries in the data, including the extra chain starts
+    const ChainedImportTable *imports;
+    int segmentIndex;
+};
+
+// Walk one chain starting at `chain`. Return false if `handler` stopped the walk.
+template <typename Pointer>
+static bool walkChain(const ChainContext &context, uint64_t chain, std::function<bool(const ChainedFixupRecord&)> const& handler) {
+    while (true) {
+        typename Pointer::Raw raw;
+        if (chain > context.imageSize - sizeof(raw)) {
+            throw std::runtime_error("Chained fixup at offset " + std::to_string(chain) + " is out of bounds of the image");
+        }
+        memcpy(&raw, context.base + chain, sizeof(raw));
+
+        ChainedFixupRecord record = {};
+        record.segmentIndex = context.segmentIndex;
+        record.vmOffset = chain;
+        record.raw = raw;
+        if (Pointer::decode(raw, context.startsInSegment, record)) {
+            if (record.bind) {
+                ChainedImport import = (*context.imports)[record.importOrdinal];
+                record.libOrdinal = import.libOrdinal;
+                record.symbolName = import.name;
+                record.addend += import.addend;
+            }
+            if (!handler(record)) {
+                return false;
+            }
+        }
+
+        uint32_t next = Pointer::next(raw);
+        if (next == 0) {
+            return true;
+        }
+        chain += next * Pointer::stride;
+    }
+}
+
+// Walk all the chains of a page. A page has one chain, except that 32-bit formats can start multiple
+// chains in a page, which are listed after page_start[page_count].
+template <typename Pointer>
+static void walkPage(const ChainContext &context, int pageIndex, std::function<bool(const ChainedFixupRecord&)> const& handler) {
+    struct dyld_chained_starts_in_segment *startsInSegment = context.startsInSegment;
+    uint64_t pageOffset = startsInSegment->segment_offset + (uint64_t)startsInSegment->page_size * pageIndex;
+    uint16_t pageStart = startsInSegment->page_start[pageIndex];
+
+    if (pageStart == DYLD_CHAINED_PTR_START_NONE) {
+        return;
+    }
+
+    if (!(pageStart & DYLD_CHAINED_PTR_START_MULTI)) {
+        walkChain<Pointer>(context, pageOffset + pageStart, handler);
+        return;
+    }
+
+    for (uint32_t i = pageStart & ~DYLD_CHAINED_PTR_START_MULTI; ; ++i) {
+        if (i >= context.pageStartCount) {
+            throw std::runtime_error("Chain starts of page " + std::to_string(pageIndex) + " run past the end of the chained fixups");
+        }
+        uint16_t chainStart = startsInSegment->page_start[i];
+        if (!walkChain<Pointer>(context, pageOffset + (chainStart & ~DYLD_CHAINED_PTR_START_LAST), handler)) {
+            return;
+        }
+        if (chainStart & DYLD_CHAINED_PTR_START_LAST) {
+            return;
+        }
+    }
+}
+
+void forEachChainedFixupInPage(const MachoImage &image, int segmentIndex, int pageIndex,
+    std::function<bool(const ChainedFixupRecord&)> const& handler) {
+    DataCursor fixups = getFixupsData(image);
+    struct dyld_chained_starts_in_segment *startsInSegment = getStartsInSegment(image, fixups, segmentIndex);
+    if (startsInSegment == nullptr) {
+        return;
+    }
+    if (pageIndex < 0 || pageIndex >= startsInSegment->page_count) {
+        throw std::runtime_error("Page index " + std::to_string(pageIndex) + " is out of bounds of the chained fixups");
+    }
+    ChainedImportTable imports(image);
+
+    uint32_t pageStartCount = (fixups.data() + fixups.size() - (uint8_t *)startsInSegment->page_start) / sizeof(uint16_t);
+    ChainContext context = {image.base, image.size, startsInSegment, pageStartCount, &imports, segmentIndex};
+
+    // Dispatch on the format once per page. Everything below is specialized for it.
+    switch (context.startsInSegment->pointer_format) {
+        case DYLD_CHAINED_PTR_64:
+        case DYLD_CHAINED_PTR_64_OFFSET:
+            walkPage<ChainedPtr64>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_ARM64E:
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND:
+            walkPage<ChainedPtrArm64e<8, false>>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_ARM64E_KERNEL:
+        case DYLD_CHAINED_PTR_ARM64E_FIRMWARE:
+            walkPage<ChainedPtrArm64e<4, false>>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_ARM64E_USERLAND24:
+            walkPage<ChainedPtrArm64e<8, true>>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_64_KERNEL_CACHE:
+            walkPage<ChainedPtrKernelCache<4>>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_X86_64_KERNEL_CACHE:
+            walkPage<ChainedPtrKernelCache<1>>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_32:
+            walkPage<ChainedPtr32>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_32_CACHE:
+            walkPage<ChainedPtr32Cache>(context, pageIndex, handler);
+            break;
+        case DYLD_CHAINED_PTR_32_FIRMWARE:
+            walkPage<ChainedPtr32Firmware>(context, pageIndex, handler);
+            break;
+        default: {
+            char errMsg[64];
+            snprintf(errMsg, sizeof(errMsg), "Unsupported pointer format: 0x%x", context.startsInSegment->pointer_format);
+            throw std::runtime_error(errMsg);
+        }
+    }
+}
+
+// Throw std::runtime_error if the image doesn't have LC_DYLD_CHAINED_FIXUPS.
+static DataCursor getFixupsData(const MachoImage &image) {
+    if (image.chainedFixupsCmd == nullptr) {
+        throw std::runtime_error("The image doesn't have LC_DYLD_CHAINED_FIXUPS");
+    }
+    return image.getData(image.chainedFixupsCmd->dataoff, image.chainedFixupsCmd->datasize);
+}
+
+// Throw std::runtime_error if the data is too small for the header.
+static struct dyld_chained_fixups_header *getFixupsHeader(DataCursor fixups) {
+    return (struct dyld_chained_fixups_header *)fixups.subrange(0, sizeof(struct dyld_chained_fixups_header)).data();
+}
+
+// Check that seg_info_offset[seg_count] is in the data, and that there are no more segments than the image has,
+// so callers can index both with the same index.
+static struct dyld_chained_starts_in_image *getStartsInImage(const MachoImage &image, DataCursor fixups) {
+    uint32_t startsOffset = getFixupsHeader(fixups)->starts_offset;
+    DataCursor starts = fixups.subrange(startsOffset, sizeof(uint32_t));
+    uint32_t segCount = starts.read<uint32_t>();
+    if (segCount > image.segmentCommands.size()) {
+        throw std::runtime_error("Chained fixups have starts for " + std::to_string(segCount) + " segments, but the image has "
+            + std::to_string(image.segmentCommands.size()));
+    }
+    fixups.subrange(startsOffset, sizeof(uint32_t) * (1 + (uint64_t)segCount));
+    return (struct dyld_chained_starts_in_image *)starts.data();
+}
+
+// The starts of the segment at `segmentIndex`, or nullptr if it has no fixups.
+// Check that it's in the data up to page_start[page_count].
+static struct dyld_chained_starts_in_segment *getStartsInSegment(const MachoImage &image, DataCursor fixups, int segmentIndex) {
+    struct dyld_chained_starts_in_image *startsInImage = getStartsInImage(image, fixups);
+    if (segmentIndex < 0 || (uint32_t)segmentIndex >= startsInImage->seg_count) {
+        throw std::runtime_error("Segment index " + std::to_string(segmentIndex) + " is out of bounds of the chained fixups");
+    }
+    if (startsInImage->seg_info_offset[segmentIndex] == 0) {
+        return nullptr;
+    }
+
+    uint64_t offset = (uint64_t)getFixupsHeader(fixups)->starts_offset + startsInImage->seg_info_offset[segmentIndex];
+    DataCursor starts = fixups.subrange(offset, offsetof(struct dyld_chained_starts_in_segment, page_start));
+    struct dyld_chained_starts_in_segment *startsInSegment = (struct dyld_chained_starts_in_segment *)starts.data();
+    fixups.subrange(offset, offsetof(struct dyld_chained_starts_in_segment, page_start)
+        + sizeof(uint16_t) * (uint64_t)startsInSegment->page_count);
+    return startsInSegment;
+}
@@ -0,0 +1,95 @@
+#ifndef FIXUP_CHAINS_H
+#define FIXUP_CHAINS_H
+
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/fixup-chains.h"
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "core/macho_image.h"
+
+// LC_DYLD_CHAINED_FIXUPS, decoded without printing anything. The functions below throw std::runtime_error
+// if the image doesn't have the command, except forEachChainedFixup(), which does nothing.
+
+// One fixup location in a chain, either a rebase or a bind.
+struct ChainedFixupRecord {
+    int segmentIndex;
+    uint64_t vmOffset;      // offset of the fixup location from the start of the image
+    uint64_t raw;           // the pointer as stored, zero-extended for 32-bit formats
+    bool bind;
+    bool auth;              // arm64e authenticated pointer or authenticated kernel cache pointer
+    // bind only
+    uint32_t importOrdinal; // index into the imports table
+    int libOrdinal;         // the dylib of the import, can be a BIND_SPECIAL_DYLIB_* value
+    const char *symbolName;
+    int64_t addend;
+    // rebase only
+    // As encoded, which is a vmaddr or an offset from the start of the image depending on the pointer format.
+    uint64_t target;
+    uint8_t high8;
+    uint8_t cacheLevel;     // kernel cache formats only
+    // auth only
+    uint8_t key;            // ptrauth key, IA, IB, DA or DB
+    bool addrDiv;           // whether the address of the location is blended into the discriminator
+    uint16_t diversity;
+};
+
+// One entry of the imports table, whatever its layout.
+struct ChainedImport {
+    int libOrdinal;         // can be a BIND_SPECIAL_DYLIB_* value
+    bool weakImport;
+    uint32_t nameOffset;    // offset in the symbol pool
+    int64_t addend;         // always 0 for DYLD_CHAINED_IMPORT
+    const char *name;
+};
+
+// The imports table of LC_DYLD_CHAINED_FIXUPS in any of the DYLD_CHAINED_IMPORT* layouts. Names point into
+// MachoImage::getChainedFixupsSymbols(), so a compressed pool is only decompressed once per image and
+// every lookup is O(1). It's cheap to construct, so each walk makes its own.
+class ChainedImportTable {
+public:
+    // Throw std::runtime_error on an unknown imports format or a corrupted symbol pool.
+    explicit ChainedImportTable(const MachoImage &image);
+
+    uint32_t format() const { return importsFormat; }
+    uint32_t size() const { return count; }
+
+    // Throw std::runtime_error if `index` or the name offset of the import is out of bounds.
+    ChainedImport operator[](uint32_t index) const;
+
+private:
+    const uint8_t *imports;
+    uint32_t importsFormat;
+    uint32_t count;
+    std::string_view symbols;
+};
+
+// The header of the fixups. Throw std::runtime_error if the data is too small for it.
+struct dyld_chained_fixups_header *getChainedFixupsHeader(const MachoImage &image);
+
+// The starts of every segment. seg_info_offset[seg_count] is in the data, and seg_count is never larger than
+// the number of segments of the image, so both can be indexed with the same index.
+struct dyld_chained_starts_in_image *getChainedStartsInImage(const MachoImage &image);
+
+// The starts of the segment at `segmentIndex`, or nullptr if it has no fixups. page_start[page_count] is in the data.
+struct dyld_chained_starts_in_segment *getChainedStartsInSegment(const MachoImage &image, int segmentIndex);
+
+// Walk every chain in the image's LC_DYLD_CHAINED_FIXUPS and call `handler` for every fixup in order.
+// All DYLD_CHAINED_PTR_* pointer formats and DYLD_CHAINED_IMPORT* layouts are decoded. The addend of
+// a bind is the one in the pointer plus the one in its import. Throw std::runtime_error on unknown formats.
+void forEachChainedFixup(const MachoImage &image, std::function<void(const ChainedFixupRecord&)> const& handler);
+
+// Walk the chains that start in one page of a segment. `handler` returns false to stop the walk early.
+void forEachChainedFixupInPage(const MachoImage &image, int segmentIndex, int pageIndex,
+    std::function<bool(const ChainedFixupRecord&)> const& handler);
+
+// Decode the pages of one segment on a pool of `threadCount` threads, 0 meaning one per hardware thread.
+// Element i holds the fixups of page i in chain order. Throw std::runtime_error like forEachChainedFixup().
+std::vector<std::vector<ChainedFixupRecord>> decodeChainedFixupPages(const MachoImage &image, int segmentIndex,
+    unsigned int threadCount = 0);
+
+// Decode every page of the image in parallel and return all the fixups in the order of forEachChainedFixup().
+std::vector<ChainedFixupRecord> decodeChainedFixups(const MachoImage &image, unsigned int threadCount = 0);
+
+#endif /* FIXUP_CHAINS_H */
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#include <stdexcept>
+
+#include "core/macho_image.h"
+
+#include "core/image_cache.h"
+
+// Bump it when the layout of any table changes, so old entries are ignored.
+#define IMAGE_CACHE_VERSION 1
+
+static bool hasColumns(const ColumnTableReader &table, const std::vector<ImageCache::Column> &columns);
+
+std::unique_ptr<ImageCache> ImageCache::open(const char *dir, const MachoImage &image, const char *filePath) {
+    if (image.uuidCmd == nullptr) {
+        return nullptr;
+    }
+
+    struct stat sb;
+    if (stat(filePath, &sb) != 0) {
+        return nullptr;
+    }
+
+    char name[128];
+    int length = snprintf(name, sizeof(name), "v%d-", IMAGE_CACHE_VERSION);
+    for (int i = 0; i < sizeof(image.uuidCmd->uuid); ++i) {
+        length += snprintf(name + length, sizeof(name) - length, "%02X", image.uuidCmd->uuid[i]);
+    }
+    snprintf(name + length, sizeof(name) - length, "-%llx-%llx", (unsigned long long)sb.st_size, (unsigned long long)sb.st_mtime);
+
+    std::string path = std::string(dir) + "/" + name;
+    std::error_code error;
+    std::filesystem::create_directories(path, error);
+    if (error) {
+        throw std::runtime_error("Cannot create cache directory " + path + ": " + error.message());
+    }
+
+    return std::unique_ptr<ImageCache>(new ImageCache(path));
+}
+
+const ColumnTableReader &ImageCache::table(const char *name, const std::vector<Column> &columns,
+    std::function<void(ColumnTableWriter &)> const& build, std::function<bool(const ColumnTableReader &)> const& isValid) {
+    // The indexes of an image can be built from multiple threads.
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = tables.find(name);
+    if (it != tables.end()) {
+        return *it->second;
+    }
+
+    std::string tablePath = path + "/" + name + ".col";
+    std::unique_ptr<ColumnTableReader> table;
+    if (access(tablePath.c_str(), F_OK) == 0) {
+        try {
+            table = std::make_unique<ColumnTableReader>(tablePath.c_str());
+        } catch (const std::exception &e) {
+            // Corrupted, for example by a crash while writing. Build it again.
+        }
+        if (table && (!hasColumns(*table, columns) || (isValid && !isValid(*table)))) {
+            table.reset();
+        }
+    }
+
+    if (!table) {
+        ColumnTableWriter writer;
+        for (auto &column : columns) {
+            writer.addColumn(column.name, column.type);
+        }
+        build(writer);
+
+        // Write to a temporary file and rename it, so other processes never see a partial table. The name is unique,
+        // because other caches in this process can write the same table, e.g. for another copy of the same image.
+        std::string tempPath = tablePath + ".XXXXXX";
+        int fd = mkstemp(&tempPath[0]);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot write cache file " + tablePath);
+        }
+        // mkstemp() creates the file with mode 0600. Keep tables readable by others like the rest of the cache.
+        fchmod(fd, 0644);
+        close(fd);
+        try {
+            writer.write(tempPath.c_str());
+        } catch (const std::exception &) {
+            unlink(tempPath.c_str());
+            throw;
+        }
+        if (rename(tempPath.c_str(), tablePath.c_str()) != 0) {
+            unlink(tempPath.c_str());
+            throw std::runtime_error("Cannot write cache file " + tablePath);
+        }
+        table = std::make_unique<ColumnTableReader>(tablePath.c_str());
+    }
+
+    return *tables.emplace(name, std::move(table)).first->second;
+}
+
+static bool hasColumns(const ColumnTableReader &table, const std::vector<ImageCache::Column> &columns) {
+    if (table.columnCount() != columns.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (table.columnName(i) != columns[i].name || table.columnType(i) != columns[i].type) {
+            return false;
+        }
+    }
+    return true;
+}
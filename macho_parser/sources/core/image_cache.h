@@ -0,0 +1,48 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/utils.h"
+
+class MachoImage;
+
+// A persistent cache of the indexes decoded from an image, enabled by --cache-dir DIR.
+//
+// Every image has its own directory under DIR named after its LC_UUID and the size and mtime of the file,
+// so a rebuilt binary never hits a stale entry. Every index is a ColumnTableWriter file in that directory,
+// written the first time the index is built and only mmapped on later runs.
+class ImageCache {
+public:
+    struct Column {
+        const char *name;
+        ColumnType type;
+    };
+
+    // Return nullptr if the image doesn't have an LC_UUID, which is the case for most object files.
+    // Throw std::runtime_error if the cache directory can't be created.
+    static std::unique_ptr<ImageCache> open(const char *dir, const MachoImage &image, const char *filePath);
+
+    // Return the cached table `name`. If it isn't cached yet, or the cached file doesn't have `columns`,
+    // call `build` to append the rows, in the order of `columns`, and store the table first.
+    // A cached file can be stale or corrupt, so if `isValid` is given and returns false for it, e.g. because
+    // an offset in it is out of bounds of the image, the table is built again too.
+    // Throw std::runtime_error if the table can't be stored.
+    const ColumnTableReader &table(const char *name, const std::vector<Column> &columns,
+        std::function<void(ColumnTableWriter &)> const& build,
+        std::function<bool(const ColumnTableReader &)> const& isValid = nullptr);
+
+private:
+    explicit ImageCache(std::string path) : path(std::move(path)) {}
+
+    std::string path;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<ColumnTableReader>> tables;
+};
+
+#endif /* IMAGE_CACHE_H */
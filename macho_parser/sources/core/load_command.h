@@ -0,0 +1,15 @@
+#ifndef LOAD_COMMAND_H
+#define LOAD_COMMAND_H
+
+#include <stdbool.h>
+#include "apple/mach-o/loader.h"
+#include <vector>
+
+// Return the `ncmds` load commands in the `sizeofcmds` bytes at `offset`.
+// Throw std::runtime_error if a command is smaller than a load_command or runs past the end.
+std::vector<struct load_command *> parseLoadCommands(uint8_t *Base, int offset, uint32_t ncmds, uint32_t sizeofcmds);
+
+// Return the name of a load command, e.g. "LC_SEGMENT_64", or NULL if it's unknown.
+const char *stringifyLoadCommand(uint32_t cmd);
+
+#endif /* LOAD_COMMAND_H */
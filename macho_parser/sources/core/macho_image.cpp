@@ -0,0 +1,615 @@
+#include <stdio.h>
+#include <string.h>
+#include "apple/mach-o/fixup-chains.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include "utils/utils.h"
+#include "core/load_command.h"
+#include "core/image_cache.h"
+
+#include "core/macho_image.h"
+
+MachoImage::MachoImage(uint8_t *base, uint64_t size) : base(base), size(size) {
+    header = (struct mach_header_64 *)base;
+    if (size < sizeof(struct mach_header_64) || header->magic != MH_MAGIC_64) {
+        throw std::runtime_error("Not a 64-bit Mach-O image.");
+    }
+
+    checkRange(sizeof(struct mach_header_64), header->sizeofcmds, "The load commands");
+    allLoadCommands = parseLoadCommands(base, sizeof(struct mach_header_64), header->ncmds, header->sizeofcmds);
+
+    for (auto lcmd : allLoadCommands) {
+        checkLoadCommand(lcmd);
+
+        switch (lcmd->cmd) {
+            case LC_SEGMENT_64: {
+                struct segment_command_64 *segCmd = (struct segment_command_64 *)lcmd;
+                segmentCommands.push_back(segCmd);
+
+                // section_64 is immediately after segment_command_64.
+                struct section_64 *sects = (struct section_64 *)((uint8_t *)segCmd + sizeof(struct segment_command_64));
+                for (int i = 0; i < segCmd->nsects; ++i) {
+                    sections.push_back(sects + i);
+                }
+                break;
+            }
+            case LC_LOAD_DYLIB:
+            case LC_LOAD_WEAK_DYLIB:
+            case LC_REEXPORT_DYLIB:
+            case LC_PREBOUND_DYLIB:
+            case LC_LAZY_LOAD_DYLIB:
+            case LC_LOAD_UPWARD_DYLIB:
+                dylibCommands.push_back((struct dylib_command *)lcmd);
+                break;
+            case LC_UUID:
+                uuidCmd = (struct uuid_command *)lcmd;
+                break;
+            case LC_SYMTAB:
+                symtabCmd = (struct symtab_command *)lcmd;
+                break;
+            case LC_DYSYMTAB:
+                dysymtabCmd = (struct dysymtab_command *)lcmd;
+                break;
+            case LC_DYLD_INFO:
+            case LC_DYLD_INFO_ONLY:
+                dyldInfoCmd = (struct dyld_info_command *)lcmd;
+                break;
+            case LC_FUNCTION_STARTS:
+                functionStartsCmd = (struct linkedit_data_command *)lcmd;
+                break;
+            case LC_DYLD_CHAINED_FIXUPS:
+                chainedFixupsCmd = (struct linkedit_data_command *)lcmd;
+                break;
+            case LC_DYLD_EXPORTS_TRIE:
+                exportsTrieCmd = (struct linkedit_data_command *)lcmd;
+                break;
+            case LC_CODE_SIGNATURE:
+                codeSignatureCmd = (struct linkedit_data_command *)lcmd;
+                break;
+        }
+    }
+
+    buildSectionIntervals();
+}
+
+// Defined here because the cache is an incomplete type in the header.
+MachoImage::~MachoImage() = default;
+
+DataCursor MachoImage::getData(uint64_t offset, uint64_t length) const {
+    checkRange(offset, length, "The data");
+    return DataCursor(base + offset, length);
+}
+
+const char *MachoImage::getString(uint32_t strx) const {
+    if (symtabCmd == nullptr || strx >= symtabCmd->strsize) {
+        return "";
+    }
+    return (const char *)(base + symtabCmd->stroff + strx);
+}
+
+bool MachoImage::hasCString(uint64_t offset) const {
+    return offset < size && memchr(base + offset, '\0', size - offset) != nullptr;
+}
+
+void MachoImage::checkRange(uint64_t offset, uint64_t length, const char *what) const {
+    if (offset > size || length > size - offset) {
+        throw std::runtime_error(std::string(what) + " at offset " + std::to_string(offset)
+            + " is out of bounds of the image.");
+    }
+}
+
+// Check that a load command is big enough for its struct, and that the ranges of the file it refers to
+// are inside the image, so the decoders can use them without checking again.
+void MachoImage::checkLoadCommand(struct load_command *lcmd) const {
+    auto requireSize = [lcmd](size_t minSize) {
+        if (lcmd->cmdsize < minSize) {
+            const char *name = stringifyLoadCommand(lcmd->cmd);
+            throw std::runtime_error(std::string(name ? name : "A load command") + " is too small.");
+        }
+    };
+    // An lc_str is an offset from the start of the command to a null-terminated string inside it.
+    auto requireString = [lcmd](union lc_str str) {
+        const char *start = (const char *)lcmd + str.offset;
+        if (str.offset >= lcmd->cmdsize || memchr(start, '\0', lcmd->cmdsize - str.offset) == nullptr) {
+            const char *name = stringifyLoadCommand(lcmd->cmd);
+            throw std::runtime_error(std::string(name ? name : "A load command") + " has a malformed string.");
+        }
+    };
+
+    switch (lcmd->cmd) {
+        case LC_SEGMENT_64: {
+            requireSize(sizeof(struct segment_command_64));
+            struct segment_command_64 *segCmd = (struct segment_command_64 *)lcmd;
+            requireSize(sizeof(struct segment_command_64) + (uint64_t)segCmd->nsects * sizeof(struct section_64));
+            checkRange(segCmd->fileoff, segCmd->filesize, "A segment");
+
+            struct section_64 *sects = (struct section_64 *)((uint8_t *)segCmd + sizeof(struct segment_command_64));
+            for (int i = 0; i < segCmd->nsects; ++i) {
+                uint8_t type = sects[i].flags & SECTION_TYPE;
+                if (type != S_ZEROFILL && type != S_GB_ZEROFILL && type != S_THREAD_LOCAL_ZEROFILL) {
+                    checkRange(sects[i].offset, sects[i].size, "A section");
+                }
+            }
+            break;
+        }
+        case LC_ID_DYLIB:
+        case LC_LOAD_DYLIB:
+        case LC_LOAD_WEAK_DYLIB:
+        case LC_REEXPORT_DYLIB:
+        case LC_LAZY_LOAD_DYLIB:
+        case LC_LOAD_UPWARD_DYLIB:
+        case LC_PREBOUND_DYLIB:
+            // The name of prebound_dylib_command is at the same place, and it's indexed as a dylib_command.
+            requireSize(sizeof(struct dylib_command));
+            requireString(((struct dylib_command *)lcmd)->dylib.name);
+            break;
+        case LC_LOAD_DYLINKER:
+        case LC_ID_DYLINKER:
+        case LC_DYLD_ENVIRONMENT:
+            requireSize(sizeof(struct dylinker_command));
+            requireString(((struct dylinker_command *)lcmd)->name);
+            break;
+        case LC_RPATH:
+            requireSize(sizeof(struct rpath_command));
+            requireString(((struct rpath_command *)lcmd)->path);
+            break;
+        case LC_UUID:
+            requireSize(sizeof(struct uuid_command));
+            break;
+        case LC_MAIN:
+            requireSize(sizeof(struct entry_point_command));
+            break;
+        case LC_SOURCE_VERSION:
+            requireSize(sizeof(struct source_version_command));
+            break;
+        case LC_ENCRYPTION_INFO_64:
+            requireSize(sizeof(struct encryption_info_command_64));
+            break;
+        case LC_LINKER_OPTION:
+            requireSize(sizeof(struct linker_option_command));
+            break;
+        case LC_VERSION_MIN_MACOSX:
+        case LC_VERSION_MIN_IPHONEOS:
+        case LC_VERSION_MIN_WATCHOS:
+        case LC_VERSION_MIN_TVOS:
+            requireSize(sizeof(struct version_min_command));
+            break;
+        case LC_BUILD_VERSION:
+            requireSize(sizeof(struct build_version_command));
+            requireSize(sizeof(struct build_version_command)
+                + (uint64_t)((struct build_version_command *)lcmd)->ntools * sizeof(struct build_tool_version));
+            break;
+        case LC_SYMTAB: {
+            requireSize(sizeof(struct symtab_command));
+            struct symtab_command *cmd = (struct symtab_command *)lcmd;
+            checkRange(cmd->symoff, (uint64_t)cmd->nsyms * sizeof(struct nlist_64), "The symbol table");
+            checkRange(cmd->stroff, cmd->strsize, "The string table");
+            // Names are read as C strings, so the last one needs to be terminated inside the table.
+            if (cmd->strsize > 0 && base[cmd->stroff + cmd->strsize - 1] != '\0') {
+                throw std::runtime_error("The string table isn't null-terminated.");
+            }
+            break;
+        }
+        case LC_DYSYMTAB: {
+            requireSize(sizeof(struct dysymtab_command));
+            struct dysymtab_command *cmd = (struct dysymtab_command *)lcmd;
+            checkRange(cmd->indirectsymoff, (uint64_t)cmd->nindirectsyms * sizeof(uint32_t), "The indirect symbol table");
+            break;
+        }
+        case LC_DYLD_INFO:
+        case LC_DYLD_INFO_ONLY: {
+            requireSize(sizeof(struct dyld_info_command));
+            struct dyld_info_command *cmd = (struct dyld_info_command *)lcmd;
+            checkRange(cmd->rebase_off, cmd->rebase_size, "The rebase opcodes");
+            checkRange(cmd->bind_off, cmd->bind_size, "The bind opcodes");
+            checkRange(cmd->weak_bind_off, cmd->weak_bind_size, "The weak bind opcodes");
+            checkRange(cmd->lazy_bind_off, cmd->lazy_bind_size, "The lazy bind opcodes");
+            checkRange(cmd->export_off, cmd->export_size, "The export trie");
+            break;
+        }
+        case LC_CODE_SIGNATURE:
+        case LC_SEGMENT_SPLIT_INFO:
+        case LC_FUNCTION_STARTS:
+        case LC_DATA_IN_CODE:
+        case LC_DYLIB_CODE_SIGN_DRS:
+        case LC_LINKER_OPTIMIZATION_HINT:
+        case LC_DYLD_EXPORTS_TRIE:
+        case LC_DYLD_CHAINED_FIXUPS:
+        case LC_ATOM_INFO:
+        {
+            requireSize(sizeof(struct linkedit_data_command));
+            struct linkedit_data_command *cmd = (struct linkedit_data_command *)lcmd;
+            const char *name = stringifyLoadCommand(cmd->cmd);
+            checkRange(cmd->dataoff, cmd->datasize, name);
+            break;
+        }
+    }
+}
+
+struct segment_command_64 *MachoImage::getSegmentByName(const char *segname) const {
+    for (auto segCmd : segmentCommands) {
+        if (strncmp(segCmd->segname, segname, 16) == 0) {
+            return segCmd;
+        }
+    }
+    return nullptr;
+}
+
+struct segment_command_64 *MachoImage::getSegmentByIndex(uint64_t index) const {
+    if (index >= segmentCommands.size()) {
+        throw std::runtime_error("Segment index " + std::to_string(index) + " is out of bounds");
+    }
+    return segmentCommands[index];
+}
+
+struct section_64 *MachoImage::getSectionByAddress(uint64_t addr) const {
+    if (sectionsOverlap) {
+        for (auto sect : sections) {
+            if (addr >= sect->addr && addr < (sect->addr + sect->size)) {
+                return sect;
+            }
+        }
+        return nullptr;
+    }
+
+    // Fixups and symbols are mostly visited in address order, so the next lookup is usually
+    // in the same section as the last one.
+    size_t hit = lastSectionHit.load(std::memory_order_relaxed);
+    if (hit < sectionIntervals.size() && addr >= sectionIntervals[hit].start && addr < sectionIntervals[hit].end) {
+        return sectionIntervals[hit].sect;
+    }
+
+    auto it = std::upper_bound(sectionIntervals.begin(), sectionIntervals.end(), addr,
+        [](uint64_t addr, const SectionInterval &interval) { return addr < interval.start; });
+    if (it == sectionIntervals.begin() || addr >= (it - 1)->end) {
+        return nullptr;
+    }
+    --it;
+    lastSectionHit.store(it - sectionIntervals.begin(), std::memory_order_relaxed);
+    return it->sect;
+}
+
+void MachoImage::buildSectionIntervals() {
+    for (auto sect : sections) {
+        // A section whose end wraps around never contains any address.
+        if (sect->size > 0 && sect->addr + sect->size > sect->addr) {
+            sectionIntervals.push_back({sect->addr, sect->addr + sect->size, sect});
+        }
+    }
+    std::stable_sort(sectionIntervals.begin(), sectionIntervals.end(),
+        [](const SectionInterval &a, const SectionInterval &b) { return a.start < b.start; });
+
+    uint64_t maxEnd = 0;
+    for (const SectionInterval &interval : sectionIntervals) {
+        if (interval.start < maxEnd) {
+            sectionsOverlap = true;
+            break;
+        }
+        maxEnd = interval.end;
+    }
+}
+
+std::string MachoImage::getDylibNameByOrdinal(int ordinal, bool basename) const {
+    if (ordinal > 0 && ordinal <= MAX_LIBRARY_ORDINAL) { // 0 ~ 253
+        if (ordinal > dylibCommands.size()) {
+            return "invalid ordinal";
+        }
+        struct dylib_command *dylibCmd = dylibCommands[ordinal - 1];
+        std::filesystem::path dylibPath = std::filesystem::path((char *)dylibCmd + dylibCmd->dylib.name.offset);
+        if (basename) {
+            dylibPath = dylibPath.filename();
+        }
+        return dylibPath.string();
+    } else if (ordinal == DYNAMIC_LOOKUP_ORDINAL) { // 254
+        return "dynamic lookup";
+    } else if (ordinal == EXECUTABLE_ORDINAL) { // 255
+        return "executable";
+    }
+    return "invalid ordinal";
+}
+
+const struct nlist_64 *MachoImage::getSymbol(uint32_t index) const {
+    if (index >= getSymbolCount()) {
+        return nullptr;
+    }
+    return (const struct nlist_64 *)(base + symtabCmd->symoff) + index;
+}
+
+SymbolRange MachoImage::getSymbols() const {
+    if (symtabCmd == nullptr) {
+        return SymbolRange();
+    }
+    return SymbolRange((const struct nlist_64 *)(base + symtabCmd->symoff), symtabCmd->nsyms,
+        (const char *)(base + symtabCmd->stroff), symtabCmd->strsize);
+}
+
+const MachoImage::SymbolsByAddress &MachoImage::getSymbolsByAddress() const {
+    std::call_once(symbolsByAddressOnce, [this]() {
+        if (cache == nullptr) {
+            buildSymbolsByAddress();
+            symbolsByAddress = {symbolAddresses.data(), symbolStrxs.data(), symbolSects.data(), symbolAddresses.size()};
+            return;
+        }
+
+        const ColumnTableReader &table = cache->table("symbols_by_address",
+            {{"address", COLUMN_U64}, {"strx", COLUMN_U32}, {"sect", COLUMN_U8}}, [this](ColumnTableWriter &writer) {
+                buildSymbolsByAddress();
+                for (size_t i = 0; i < symbolAddresses.size(); ++i) {
+                    writer.append(0, symbolAddresses[i]);
+                    writer.append(1, symbolStrxs[i]);
+                    writer.append(2, symbolSects[i]);
+                }
+            });
+        symbolsByAddress = {(const uint64_t *)table.columnData(0), (const uint32_t *)table.columnData(1),
+            (const uint8_t *)table.columnData(2), table.rowCount()};
+    });
+
+    return symbolsByAddress;
+}
+
+void MachoImage::buildSymbolsByAddress() const {
+    if (symtabCmd == nullptr) {
+        return;
+    }
+
+    struct nlist_64 *nlists = (struct nlist_64 *)(base + symtabCmd->symoff);
+    const char *strTable = (const char *)(base + symtabCmd->stroff);
+
+    std::vector<uint32_t> indexes;
+    indexes.reserve(symtabCmd->nsyms);
+    for (int i = 0; i < symtabCmd->nsyms; ++i) {
+        struct nlist_64 *nlist = nlists + i;
+        // Only the symbols defined in a section have a meaningful address.
+        if ((nlist->n_type & N_STAB) || (nlist->n_type & N_TYPE) != N_SECT) {
+            continue;
+        }
+        if (nlist->n_un.n_strx == 0 || nlist->n_un.n_strx >= symtabCmd->strsize || strTable[nlist->n_un.n_strx] == '\0') {
+            continue;
+        }
+        indexes.push_back(i);
+    }
+
+    // Stable sort so that the first symbol in the symbol table wins if multiple symbols share an address.
+    std::stable_sort(indexes.begin(), indexes.end(),
+        [nlists](uint32_t a, uint32_t b) { return nlists[a].n_value < nlists[b].n_value; });
+
+    symbolAddresses.reserve(indexes.size());
+    symbolStrxs.reserve(indexes.size());
+    symbolSects.reserve(indexes.size());
+    for (uint32_t i : indexes) {
+        symbolAddresses.push_back(nlists[i].n_value);
+        symbolStrxs.push_back(nlists[i].n_un.n_strx);
+        symbolSects.push_back(nlists[i].n_sect);
+    }
+}
+
+size_t MachoImage::upperBoundByAddress(uint64_t addr) const {
+    const SymbolsByAddress &symbols = getSymbolsByAddress();
+    return std::upper_bound(symbols.addresses, symbols.addresses + symbols.count, addr) - symbols.addresses;
+}
+
+const char *MachoImage::lookupSymbolByAddress(uint64_t addr) const {
+    const SymbolsByAddress &symbols = getSymbolsByAddress();
+    size_t i = std::lower_bound(symbols.addresses, symbols.addresses + symbols.count, addr) - symbols.addresses;
+
+    if (i == symbols.count || symbols.addresses[i] != addr) {
+        return nullptr;
+    }
+    return getString(symbols.strxs[i]);
+}
+
+std::string MachoImage::symbolicateAddress(uint64_t addr) const {
+    const SymbolsByAddress &symbols = getSymbolsByAddress();
+    size_t i = upperBoundByAddress(addr);
+    if (i == 0) {
+        return "";
+    }
+
+    // Step back to the nearest preceding symbol, then to the first one at that address.
+    uint64_t symbolAddr = symbols.addresses[--i];
+    while (i > 0 && symbols.addresses[i - 1] == symbolAddr) {
+        --i;
+    }
+
+    // Don't symbolicate an address that is beyond the section of the preceding symbol.
+    uint8_t sectOrdinal = symbols.sects[i];
+    if (sectOrdinal == NO_SECT || sectOrdinal > sections.size()) {
+        return "";
+    }
+    struct section_64 *sect = sections[sectOrdinal - 1];
+    if (addr >= sect->addr + sect->size && addr != symbolAddr) {
+        return "";
+    }
+
+    std::string symbol(getString(symbols.strxs[i]));
+    if (addr == symbolAddr) {
+        return symbol;
+    }
+
+    char offset[32];
+    snprintf(offset, sizeof(offset), "+0x%llx", (unsigned long long)(addr - symbolAddr));
+    return symbol + offset;
+}
+
+// FNV-1a, which is good enough for symbol names and cheap to compute.
+static uint64_t hashSymbolName(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : name) {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool MachoImage::symbolNameEquals(uint32_t strx, std::string_view name) const {
+    if (strx >= symtabCmd->strsize) {
+        return false;
+    }
+    const char *symbol = (const char *)(base + symtabCmd->stroff + strx);
+    uint64_t available = symtabCmd->strsize - strx;
+    return name.size() < available && memcmp(symbol, name.data(), name.size()) == 0 && symbol[name.size()] == '\0';
+}
+
+void MachoImage::getSymbolsByName() const {
+    std::call_once(symbolsByNameOnce, [this]() {
+        if (cache == nullptr) {
+            buildSymbolsByName();
+            symbolsByName = symbolNameSlots.data();
+            symbolsByNameCapacity = symbolNameSlots.size();
+            return;
+        }
+
+        const ColumnTableReader &table = cache->table("symbols_by_name", {{"slot", COLUMN_U32}},
+            [this](ColumnTableWriter &writer) {
+                buildSymbolsByName();
+                for (uint32_t slot : symbolNameSlots) {
+                    writer.append(0, slot);
+                }
+            });
+        symbolsByName = (const uint32_t *)table.columnData(0);
+        symbolsByNameCapacity = table.rowCount();
+    });
+}
+
+void MachoImage::buildSymbolsByName() const {
+    if (symtabCmd == nullptr || symtabCmd->nsyms == 0) {
+        return;
+    }
+
+    struct nlist_64 *nlists = (struct nlist_64 *)(base + symtabCmd->symoff);
+    const char *strTable = (const char *)(base + symtabCmd->stroff);
+
+    // Keep the load factor at or below 0.5 so probe sequences stay short.
+    size_t capacity = 16;
+    while (capacity < (size_t)symtabCmd->nsyms * 2) {
+        capacity *= 2;
+    }
+    symbolNameSlots.assign(capacity, 0);
+
+    for (uint32_t i = 0; i < symtabCmd->nsyms; ++i) {
+        struct nlist_64 *nlist = nlists + i;
+        uint32_t strx = nlist->n_un.n_strx;
+        if ((nlist->n_type & N_STAB) || strx == 0 || strx >= symtabCmd->strsize) {
+            continue;
+        }
+
+        std::string_view name(strTable + strx, strnlen(strTable + strx, symtabCmd->strsize - strx));
+        if (name.empty()) {
+            continue;
+        }
+
+        // linear probing
+        size_t slot = hashSymbolName(name) & (capacity - 1);
+        while (symbolNameSlots[slot] != 0) {
+            if (symbolNameEquals(nlists[symbolNameSlots[slot] - 1].n_un.n_strx, name)) {
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (symbolNameSlots[slot] == 0) {
+            symbolNameSlots[slot] = i + 1;
+        }
+    }
+}
+
+int MachoImage::lookupSymbolByName(std::string_view name) const {
+    getSymbolsByName();
+    // The capacity is a power of two, or zero if there are no symbols.
+    if (symbolsByNameCapacity == 0 || (symbolsByNameCapacity & (symbolsByNameCapacity - 1)) != 0) {
+        return -1;
+    }
+
+    struct nlist_64 *nlists = (struct nlist_64 *)(base + symtabCmd->symoff);
+    size_t mask = symbolsByNameCapacity - 1;
+    size_t slot = hashSymbolName(name) & mask;
+    // A cached table without an empty slot would never end the probe sequence, so visit each slot at most once.
+    for (size_t probe = 0; probe < symbolsByNameCapacity && symbolsByName[slot] != 0; ++probe, slot = (slot + 1) & mask) {
+        // A cached table may belong to a corrupted entry, don't trust the slots blindly.
+        if (symbolsByName[slot] > symtabCmd->nsyms) {
+            break;
+        }
+        if (symbolNameEquals(nlists[symbolsByName[slot] - 1].n_un.n_strx, name)) {
+            return symbolsByName[slot] - 1;
+        }
+    }
+    return -1;
+}
+
+const MachoImage::FunctionStarts &MachoImage::getFunctionStarts() const {
+    std::call_once(functionStartsOnce, [this]() {
+        if (cache == nullptr) {
+            buildFunctionStarts();
+            functionStarts = {functionStartAddresses.data(), functionStartAddresses.size()};
+            return;
+        }
+
+        const ColumnTableReader &table = cache->table("function_starts", {{"address", COLUMN_U64}},
+            [this](ColumnTableWriter &writer) {
+                buildFunctionStarts();
+                for (uint64_t address : functionStartAddresses) {
+                    writer.append(0, address);
+                }
+            });
+        functionStarts = {(const uint64_t *)table.columnData(0), table.rowCount()};
+    });
+
+    return functionStarts;
+}
+
+void MachoImage::buildFunctionStarts() const {
+    struct segment_command_64 *textSegment = getSegmentByName("__TEXT");
+    if (functionStartsCmd == nullptr || textSegment == nullptr) {
+        return;
+    }
+
+    // ULEB128 deltas from the start of __TEXT, terminated by a zero.
+    DataCursor funcStarts = getData(functionStartsCmd->dataoff, functionStartsCmd->datasize);
+    uint64_t address = textSegment->vmaddr;
+    while (!funcStarts.atEnd()) {
+        uint64_t delta = funcStarts.readULEB128();
+        if (delta == 0) {
+            break;
+        }
+        address += delta;
+        functionStartAddresses.push_back(address);
+    }
+}
+
+std::string_view MachoImage::getChainedFixupsSymbols() const {
+    std::call_once(chainedFixupsSymbolsOnce, [this]() {
+        if (chainedFixupsCmd == nullptr) {
+            return;
+        }
+
+        uint8_t *fixupBase = base + chainedFixupsCmd->dataoff;
+        struct dyld_chained_fixups_header *header = (struct dyld_chained_fixups_header *)fixupBase;
+        if (chainedFixupsCmd->datasize < sizeof(struct dyld_chained_fixups_header)
+            || header->symbols_offset > chainedFixupsCmd->datasize) {
+            throw std::runtime_error("Chained fixups symbols are out of bounds");
+        }
+
+        // The pool runs to the end of the payload.
+        uint8_t *symbols = fixupBase + header->symbols_offset;
+        size_t size = chainedFixupsCmd->datasize - header->symbols_offset;
+        switch (header->symbols_format) {
+            case 0: {
+                // Drop whatever follows the last null, so every name in the pool is terminated inside it.
+                std::string_view pool((const char *)symbols, size);
+                size_t lastNull = pool.rfind('\0');
+                chainedFixupsSymbols = pool.substr(0, lastNull == std::string_view::npos ? 0 : lastNull + 1);
+                break;
+            }
+            case 1:
+                chainedFixupsSymbolArena = decompressZlibData(symbols, size);
+                chainedFixupsSymbolArena.push_back('\0');
+                chainedFixupsSymbols = std::string_view((const char *)chainedFixupsSymbolArena.data(), chainedFixupsSymbolArena.size() - 1);
+                break;
+            default:
+                throw std::runtime_error("Unknown chained fixups symbols format " + std::to_string(header->symbols_format));
+        }
+    });
+
+    return chainedFixupsSymbols;
+}
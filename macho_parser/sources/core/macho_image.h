@@ -0,0 +1,171 @@
+#ifndef MACHO_IMAGE_H
+#define MACHO_IMAGE_H
+
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/utils.h"
+#include "core/views.h"
+
+class ImageCache;
+
+// A parsed 64-bit Mach-O image (one arch slice or one object file in an archive).
+//
+// All the load commands are walked once in the constructor and indexed, so printers and
+// queries never need to rescan them. The image doesn't own the underlying bytes, which
+// are typically mmapped by the caller, and it is never mutated after construction,
+// so multiple images can be alive at the same time and read from different threads.
+// The only exceptions are the symbol indexes, which are built once on first use.
+class MachoImage {
+public:
+    // `size` is the number of readable bytes at `base`. Throw std::runtime_error if they don't start with
+    // a 64-bit Mach-O header, or if a load command or a range of the file it refers to is out of bounds.
+    // After that, every segment, section and linkedit range of the commands below is inside the image.
+    MachoImage(uint8_t *base, uint64_t size);
+    ~MachoImage();
+
+    uint8_t *base;
+    uint64_t size;
+    struct mach_header_64 *header;
+
+    std::vector<struct load_command *> allLoadCommands;
+    std::vector<struct segment_command_64 *> segmentCommands;
+    // All sections in load command order. Section ordinal N is at index N - 1.
+    std::vector<struct section_64 *> sections;
+    // LC_LOAD_DYLIB and friends. Dylib ordinal N is at index N - 1.
+    std::vector<struct dylib_command *> dylibCommands;
+
+    // The commands below are nullptr if they are absent in the image.
+    struct uuid_command *uuidCmd = nullptr;
+    struct symtab_command *symtabCmd = nullptr;
+    struct dysymtab_command *dysymtabCmd = nullptr;
+    struct dyld_info_command *dyldInfoCmd = nullptr;
+    struct linkedit_data_command *functionStartsCmd = nullptr;
+    struct linkedit_data_command *chainedFixupsCmd = nullptr;
+    struct linkedit_data_command *exportsTrieCmd = nullptr;
+    struct linkedit_data_command *codeSignatureCmd = nullptr;
+
+    // Set by the caller right after construction if --cache-dir is given, otherwise nullptr.
+    // The symbol indexes and the decoders load what they build from it.
+    std::unique_ptr<ImageCache> cache;
+
+    // A cursor over [offset, offset + length) of the image. Throw std::runtime_error if it's out of bounds.
+    DataCursor getData(uint64_t offset, uint64_t length) const;
+
+    // The string at `strx` in the string table, or an empty string if `strx` is out of bounds.
+    const char *getString(uint32_t strx) const;
+    // Whether a NUL-terminated string starts at `offset` of the image, like a name whose offset is cached.
+    bool hasCString(uint64_t offset) const;
+
+    struct segment_command_64 *getSegmentByName(const char *segname) const;
+    // Throw std::runtime_error if the image doesn't have a segment at `index`.
+    struct segment_command_64 *getSegmentByIndex(uint64_t index) const;
+    // The section that contains `addr`, or nullptr if there is none. O(log n) in the number of sections,
+    // and O(1) when consecutive lookups are in the same section, like those of rebases and binds.
+    struct section_64 *getSectionByAddress(uint64_t addr) const;
+
+    // Views over segmentCommands and sections, e.g. `for (SectionView sect : image.getSections())`.
+    ViewRange<SegmentView, struct segment_command_64 *> getSegments() const {
+        return {segmentCommands.data(), segmentCommands.size()};
+    }
+    ViewRange<SectionView, struct section_64 *> getSections() const { return {sections.data(), sections.size()}; }
+
+    std::string getDylibNameByOrdinal(int ordinal, bool basename = true) const;
+
+    // The number of entries in the symbol table, 0 if LC_SYMTAB is absent.
+    uint32_t getSymbolCount() const { return symtabCmd != nullptr ? symtabCmd->nsyms : 0; }
+    // The entry at `index` of the symbol table, or nullptr if `index` is out of bounds.
+    const struct nlist_64 *getSymbol(uint32_t index) const;
+    // A view over the symbol table with names in the string table.
+    SymbolRange getSymbols() const;
+
+    // Return the name of the symbol defined exactly at `addr`, or nullptr if there is none.
+    const char *lookupSymbolByAddress(uint64_t addr) const;
+
+    // Return "sym" if a symbol is defined at `addr`, "sym+0x1c" if the nearest preceding symbol
+    // in the same section is 0x1c bytes before `addr`, or an empty string otherwise.
+    std::string symbolicateAddress(uint64_t addr) const;
+
+    // Return the index in the symbol table of the symbol named `name`, or -1 if there is none.
+    // Stab entries are ignored, and the first one wins if multiple symbols have the same name.
+    int lookupSymbolByName(std::string_view name) const;
+
+    // The addresses in LC_FUNCTION_STARTS, decoded on first use. Empty if the command is absent.
+    struct FunctionStarts {
+        const uint64_t *addresses = nullptr;
+        size_t count = 0;
+    };
+    const FunctionStarts &getFunctionStarts() const;
+
+    // The symbol pool of LC_DYLD_CHAINED_FIXUPS, which the imports table refers to by offset.
+    // A zlib compressed pool is decompressed once on first use. Empty if the command is absent.
+    // Throw std::runtime_error if the pool can't be decompressed.
+    std::string_view getChainedFixupsSymbols() const;
+
+private:
+    // Non-empty sections sorted by address, built in the constructor.
+    struct SectionInterval {
+        uint64_t start;
+        uint64_t end;
+        struct section_64 *sect;
+    };
+    std::vector<SectionInterval> sectionIntervals;
+    // Sections only overlap in a malformed image. The first one in load command order has always won,
+    // so getSectionByAddress() falls back to a linear scan in that case.
+    bool sectionsOverlap = false;
+    // The index in sectionIntervals of the last successful lookup.
+    mutable std::atomic<size_t> lastSectionHit{0};
+
+    // Defined symbols sorted by address, built lazily by getSymbolsByAddress(). The arrays are parallel
+    // and point either into the vectors below or into the cache.
+    struct SymbolsByAddress {
+        const uint64_t *addresses = nullptr;
+        const uint32_t *strxs = nullptr;
+        const uint8_t *sects = nullptr;
+        size_t count = 0;
+    };
+    mutable std::once_flag symbolsByAddressOnce;
+    mutable SymbolsByAddress symbolsByAddress;
+    mutable std::vector<uint64_t> symbolAddresses;
+    mutable std::vector<uint32_t> symbolStrxs;
+    mutable std::vector<uint8_t> symbolSects;
+
+    // An open addressing hash table of symbol names. Each slot holds a symbol index plus one,
+    // and zero means the slot is empty. Names stay in the string table and are never copied.
+    // The slots point either into the vector below or into the cache.
+    mutable std::once_flag symbolsByNameOnce;
+    mutable const uint32_t *symbolsByName = nullptr;
+    mutable size_t symbolsByNameCapacity = 0;
+    mutable std::vector<uint32_t> symbolNameSlots;
+
+    mutable std::once_flag functionStartsOnce;
+    mutable FunctionStarts functionStarts;
+    mutable std::vector<uint64_t> functionStartAddresses;
+
+    mutable std::once_flag chainedFixupsSymbolsOnce;
+    mutable std::string_view chainedFixupsSymbols;
+    // The decompressed pool if it's compressed, plus a terminating null.
+    mutable std::vector<uint8_t> chainedFixupsSymbolArena;
+
+    void checkRange(uint64_t offset, uint64_t length, const char *what) const;
+    void checkLoadCommand(struct load_command *lcmd) const;
+    void buildSectionIntervals();
+
+    const SymbolsByAddress &getSymbolsByAddress() const;
+    void buildSymbolsByAddress() const;
+    void getSymbolsByName() const;
+    void buildSymbolsByName() const;
+    void buildFunctionStarts() const;
+    // Whether the symbol at `strx` in the string table is named `name`.
+    bool symbolNameEquals(uint32_t strx, std::string_view name) const;
+    // The index of the first symbol whose address is greater than `addr`.
+    size_t upperBoundByAddress(uint64_t addr) const;
+};
+
+#endif /* MACHO_IMAGE_H */
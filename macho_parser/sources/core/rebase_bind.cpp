@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdexcept>
+#include <string>
+
+#include "utils/utils.h"
+#include "core/image_cache.h"
+#include "core/rebase_bind.h"
+
+template <typename Run>
+static void emitRun(const MachoImage &image, Run &run, int segmentIndex, uint64_t &location, uint64_t count, uint64_t stride,
+    std::function<void(const Run&)> const& handler);
+static uint32_t checkSegmentIndex(const MachoImage &image, uint64_t segmentIndex);
+static bool hasSegmentIndexes(const MachoImage &image, const ColumnTableReader &columns, size_t column);
+
+RebaseTable decodeRebaseTable(const MachoImage &image, uint32_t offset, uint32_t size) {
+    RebaseTable table;
+
+    if (image.cache == nullptr) {
+        forEachRebase(image, offset, size, [&table](const RebaseRecord &rebase) {
+            table.segmentIndexStorage.push_back(rebase.segmentIndex);
+            table.segmentOffsetStorage.push_back(rebase.segmentOffset);
+            table.typeStorage.push_back(rebase.type);
+        });
+
+        table.count = table.typeStorage.size();
+        table.segmentIndexes = table.segmentIndexStorage.data();
+        table.segmentOffsets = table.segmentOffsetStorage.data();
+        table.types = table.typeStorage.data();
+        return table;
+    }
+
+    // The opcodes at `offset` are decoded once and mapped from the cache afterwards.
+    std::string name = "rebase_" + std::to_string(offset) + "_" + std::to_string(size);
+    const ColumnTableReader &columns = image.cache->table(name.c_str(),
+        {{"seg_index", COLUMN_U32}, {"seg_offset", COLUMN_U64}, {"type", COLUMN_U8}}, [&](ColumnTableWriter &writer) {
+            forEachRebase(image, offset, size, [&writer](const RebaseRecord &rebase) {
+                writer.append(0, rebase.segmentIndex);
+                writer.append(1, rebase.segmentOffset);
+                writer.append(2, rebase.type);
+            });
+        }, [&image](const ColumnTableReader &columns) {
+            return hasSegmentIndexes(image, columns, 0);
+        });
+
+    table.count = columns.rowCount();
+    table.segmentIndexes = (const uint32_t *)columns.columnData(0);
+    table.segmentOffsets = (const uint64_t *)columns.columnData(1);
+    table.types = (const uint8_t *)columns.columnData(2);
+    return table;
+}
+
+void forEachRebase(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const RebaseRecord&)> const& handler) {
+    forEachRebaseRun(image, offset, size, [&handler](const RebaseRun &run) {
+        RebaseRecord record = {run.segmentIndex, run.segmentOffset, run.type};
+        for (uint64_t j = 0; j < run.count; ++j) {
+            handler(record);
+            record.segmentOffset += run.stride;
+        }
+    });
+}
+
+void forEachRebaseRun(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const RebaseRun&)> const& handler) {
+    DataCursor rebase = image.getData(offset, size);
+    uint64_t uleb = 0;
+    const int ptrSize = sizeof(void *);
+
+    RebaseRun run = {};
+
+    while (!rebase.atEnd()) {
+        uint8_t byte = rebase.readByte();
+        uint8_t opcode = byte & REBASE_OPCODE_MASK;
+        uint8_t imm = byte & REBASE_IMMEDIATE_MASK;
+
+        switch (opcode) {
+            case REBASE_OPCODE_DONE:
+                break;
+            case REBASE_OPCODE_SET_TYPE_IMM:
+                run.type = imm;
+                break;
+            case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB: {
+                uleb = rebase.readULEB128();
+                run.segmentIndex = checkSegmentIndex(image, imm);
+                run.segmentOffset = uleb;
+                break;
+            }
+            case REBASE_OPCODE_ADD_ADDR_ULEB:
+                uleb = rebase.readULEB128();
+                run.segmentOffset += uleb;
+                break;
+            case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
+                run.segmentOffset += imm * ptrSize;
+                break;
+            case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
+                emitRun(image, run, run.segmentIndex, run.segmentOffset, imm, ptrSize, handler);
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
+                uleb = rebase.readULEB128();
+                emitRun(image, run, run.segmentIndex, run.segmentOffset, uleb, ptrSize, handler);
+                break;
+            case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
+                uleb = rebase.readULEB128();
+                emitRun(image, run, run.segmentIndex, run.segmentOffset, 1, uleb + ptrSize, handler);
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB: {
+                uint64_t count, skip;
+                count = rebase.readULEB128();
+                skip = rebase.readULEB128();
+                emitRun(image, run, run.segmentIndex, run.segmentOffset, count, skip + ptrSize, handler);
+                break;
+            }
+            default: {
+                char errMsg[32];
+                snprintf(errMsg, sizeof(errMsg), "Unknown Opcode (%#x)", opcode);
+                throw std::runtime_error(errMsg);
+            }
+        }
+    }
+}
+
+BindTable decodeBindTable(const MachoImage &image, uint32_t offset, uint32_t size) {
+    BindTable table;
+    table.base = image.base;
+
+    auto symbolOffset = [&image](const BindRecord &bind) -> uint32_t {
+        return bind.symbolName != nullptr ? (const uint8_t *)bind.symbolName - image.base : 0;
+    };
+
+    if (image.cache == nullptr) {
+        forEachBind(image, offset, size, [&](const BindRecord &bind) {
+            table.segmentIndexStorage.push_back(bind.segmentIndex);
+            table.segmentOffsetStorage.push_back(bind.segmentOffset);
+            table.typeStorage.push_back(bind.type);
+            table.dylibOrdinalStorage.push_back(bind.dylibOrdinal);
+            table.symbolOffsetStorage.push_back(symbolOffset(bind));
+            table.symbolFlagStorage.push_back(bind.symbolFlags);
+            table.addendStorage.push_back(bind.addend);
+        });
+
+        table.count = table.typeStorage.size();
+        table.segmentIndexes = table.segmentIndexStorage.data();
+        table.segmentOffsets = table.segmentOffsetStorage.data();
+        table.types = table.typeStorage.data();
+        table.dylibOrdinals = table.dylibOrdinalStorage.data();
+        table.symbolOffsets = table.symbolOffsetStorage.data();
+        table.symbolFlags = table.symbolFlagStorage.data();
+        table.addends = table.addendStorage.data();
+        return table;
+    }
+
+    std::string name = "bind_" + std::to_string(offset) + "_" + std::to_string(size);
+    const ColumnTableReader &columns = image.cache->table(name.c_str(),
+        {{"seg_index", COLUMN_U32}, {"seg_offset", COLUMN_U64}, {"type", COLUMN_U8}, {"dylib_ordinal", COLUMN_I32},
+        {"symbol_offset", COLUMN_U32}, {"flags", COLUMN_U8}, {"addend", COLUMN_I64}}, [&](ColumnTableWriter &writer) {
+            forEachBind(image, offset, size, [&](const BindRecord &bind) {
+                writer.append(0, bind.segmentIndex);
+                writer.append(1, bind.segmentOffset);
+                writer.append(2, bind.type);
+                writer.append(3, bind.dylibOrdinal);
+                writer.append(4, symbolOffset(bind));
+                writer.append(5, bind.symbolFlags);
+                writer.append(6, bind.addend);
+            });
+        }, [&image](const ColumnTableReader &columns) {
+            // The symbol names are dereferenced in the image.
+            const uint32_t *symbolOffsets = (const uint32_t *)columns.columnData(4);
+            for (uint64_t i = 0; i < columns.rowCount(); ++i) {
+                if (symbolOffsets[i] != 0 && !image.hasCString(symbolOffsets[i])) {
+                    return false;
+                }
+            }
+            return hasSegmentIndexes(image, columns, 0);
+        });
+
+    table.count = columns.rowCount();
+    table.segmentIndexes = (const uint32_t *)columns.columnData(0);
+    table.segmentOffsets = (const uint64_t *)columns.columnData(1);
+    table.types = (const uint8_t *)columns.columnData(2);
+    table.dylibOrdinals = (const int32_t *)columns.columnData(3);
+    table.symbolOffsets = (const uint32_t *)columns.columnData(4);
+    table.symbolFlags = (const uint8_t *)columns.columnData(5);
+    table.addends = (const int64_t *)columns.columnData(6);
+    return table;
+}
+
+void forEachBind(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const BindRecord&)> const& handler) {
+    forEachBindRun(image, offset, size, [&handler](const BindRun &run) {
+        BindRecord record = run.bind;
+        for (uint64_t j = 0; j < run.count; ++j) {
+            handler(record);
+            record.segmentOffset += run.stride;
+        }
+    });
+}
+
+void forEachBindRun(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const BindRun&)> const& handler) {
+    DataCursor bind = image.getData(offset, size);
+    const int ptrSize = sizeof(void *);
+
+    BindRun run = {};
+    BindRecord &record = run.bind;
+
+    uint64_t uleb = 0;
+    int64_t sleb = 0;
+
+    while (!bind.atEnd()) {
+        uint8_t byte = bind.readByte();
+        uint8_t opcode = byte & BIND_OPCODE_MASK;
+        uint8_t imm = byte & BIND_IMMEDIATE_MASK;
+
+        switch (opcode) {
+            case BIND_OPCODE_DONE:
+                break;
+            case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
+                record.dylibOrdinal = imm;
+                break;
+            case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
+                uleb = bind.readULEB128();
+                record.dylibOrdinal = uleb;
+                break;
+            case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
+                // dylib special is zero or negative
+                record.dylibOrdinal = convertSignedImm(imm);
+                break;
+            case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM:
+                record.symbolFlags = imm;
+                record.symbolName = bind.readCString();
+                break;
+            case BIND_OPCODE_SET_TYPE_IMM:
+                record.type = imm;
+                break;
+            case BIND_OPCODE_SET_ADDEND_SLEB:
+                sleb = bind.readSLEB128();
+                record.addend = sleb;
+                break;
+            case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+                uleb = bind.readULEB128();
+                record.segmentIndex = checkSegmentIndex(image, imm);
+                record.segmentOffset = uleb;
+                break;
+            case BIND_OPCODE_ADD_ADDR_ULEB:
+                uleb = bind.readULEB128();
+                record.segmentOffset += uleb;
+                break;
+            case BIND_OPCODE_DO_BIND:
+                emitRun(image, run, record.segmentIndex, record.segmentOffset, 1, ptrSize, handler);
+                break;
+            case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
+                uleb = bind.readULEB128();
+                emitRun(image, run, record.segmentIndex, record.segmentOffset, 1, uleb + ptrSize, handler);
+                break;
+            case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
+                emitRun(image, run, record.segmentIndex, record.segmentOffset, 1, imm * ptrSize + ptrSize, handler);
+                break;
+            case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB: {
+                uint64_t count, skip;
+                count = bind.readULEB128();
+                skip = bind.readULEB128();
+                emitRun(image, run, record.segmentIndex, record.segmentOffset, count, skip + ptrSize, handler);
+                break;
+            }
+            case BIND_OPCODE_THREADED:
+                throw std::runtime_error("Unhandled Opcode (BIND_OPCODE_THREADED)");
+            default: {
+                char errMsg[32];
+                snprintf(errMsg, sizeof(errMsg), "Unknown Opcode (%#x)", opcode);
+                throw std::runtime_error(errMsg);
+            }
+        }
+    }
+}
+
+// Emit a run of `count` locations `stride` bytes apart starting at `location`, which is the current
+// location in `run`, and move the location past the run.
+// The count and the stride come straight from the opcodes, so throw std::runtime_error if any location
+// of the run would be past the end of the segment, before anything is expanded.
+template <typename Run>
+static void emitRun(const MachoImage &image, Run &run, int segmentIndex, uint64_t &location, uint64_t count, uint64_t stride,
+    std::function<void(const Run&)> const& handler) {
+    if (count == 0) {
+        return;
+    }
+
+    uint64_t vmsize = image.getSegmentByIndex(segmentIndex)->vmsize;
+    // The last location is location + (count - 1) * stride, which has to be computed without overflowing.
+    // A stride of 0 only comes from a skip that wrapped around and would repeat one location `count` times.
+    if (location >= vmsize || (count > 1 && (stride == 0 || count - 1 > (vmsize - 1 - location) / stride))) {
+        throw std::runtime_error("A run of " + std::to_string(count) + " locations at offset " + std::to_string(location)
+            + " is out of bounds of segment " + std::to_string(segmentIndex));
+    }
+
+    run.count = count;
+    run.stride = stride;
+    handler(run);
+    location += count * stride;
+}
+
+// Return `segmentIndex` if the image has such a segment, otherwise throw std::runtime_error.
+static uint32_t checkSegmentIndex(const MachoImage &image, uint64_t segmentIndex) {
+    image.getSegmentByIndex(segmentIndex);
+    return segmentIndex;
+}
+
+// Whether every segment index in `column` of a cached table refers to a segment of the image.
+static bool hasSegmentIndexes(const MachoImage &image, const ColumnTableReader &columns, size_t column) {
+    const uint32_t *segmentIndexes = (const uint32_t *)columns.columnData(column);
+    for (uint64_t i = 0; i < columns.rowCount(); ++i) {
+        if (segmentIndexes[i] >= image.segmentCommands.size()) {
+            return false;
+        }
+    }
+    return true;
+}
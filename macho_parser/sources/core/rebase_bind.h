@@ -0,0 +1,132 @@
+#ifndef REBASE_BIND_H
+#define REBASE_BIND_H
+
+#include "apple/mach-o/loader.h"
+#include <functional>
+#include <vector>
+
+#include "core/macho_image.h"
+
+// The rebase and bind opcodes of LC_DYLD_INFO(_ONLY), decoded without printing anything.
+
+// One pointer to rebase, produced by running the rebase opcodes.
+struct RebaseRecord {
+    int segmentIndex;
+    uint64_t segmentOffset;
+    uint8_t type;         // REBASE_TYPE_*
+};
+
+// One pointer to bind, produced by running the bind opcodes.
+struct BindRecord {
+    int segmentIndex;
+    uint64_t segmentOffset;
+    uint8_t type;         // BIND_TYPE_*
+    int dylibOrdinal;     // zero or negative for BIND_SPECIAL_DYLIB_*
+    const char *symbolName;
+    uint8_t symbolFlags;  // BIND_SYMBOL_FLAGS_*
+    int64_t addend;
+};
+
+// `count` rebases of the same type, the k-th at segmentOffset + k * stride. Every DO_REBASE opcode
+// produces one run, so strided ranges can be handled without expanding them. The next location
+// after the run is segmentOffset + count * stride, which is why single rebases can have a stride
+// larger than the pointer size.
+struct RebaseRun {
+    int segmentIndex;
+    uint64_t segmentOffset;
+    uint8_t type;
+    uint64_t count;
+    uint64_t stride;
+};
+
+// `count` binds of the same symbol, the k-th at bind.segmentOffset + k * stride. See RebaseRun.
+struct BindRun {
+    BindRecord bind;
+    uint64_t count;
+    uint64_t stride;
+};
+
+// All the rebases of an opcode stream in struct-of-arrays form, in opcode order.
+// The arrays point either into the storage vectors or into the image cache, so a table can be moved but not copied.
+struct RebaseTable {
+    size_t count = 0;
+    const uint32_t *segmentIndexes = nullptr;
+    const uint64_t *segmentOffsets = nullptr;
+    const uint8_t *types = nullptr;
+
+    std::vector<uint32_t> segmentIndexStorage;
+    std::vector<uint64_t> segmentOffsetStorage;
+    std::vector<uint8_t> typeStorage;
+
+    RebaseTable() = default;
+    RebaseTable(RebaseTable &&) = default;
+    RebaseTable(const RebaseTable &) = delete;
+
+    RebaseRecord operator[](size_t i) const { return {(int)segmentIndexes[i], segmentOffsets[i], types[i]}; }
+};
+
+// All the binds of an opcode stream in struct-of-arrays form, in opcode order.
+// Symbol names aren't copied. They are referenced by their offsets in the image, which is where the
+// opcode stream keeps them NUL-terminated. Zero means no symbol has been set.
+struct BindTable {
+    const uint8_t *base = nullptr;
+    size_t count = 0;
+    const uint32_t *segmentIndexes = nullptr;
+    const uint64_t *segmentOffsets = nullptr;
+    const uint8_t *types = nullptr;
+    const int32_t *dylibOrdinals = nullptr;
+    const uint32_t *symbolOffsets = nullptr;
+    const uint8_t *symbolFlags = nullptr;
+    const int64_t *addends = nullptr;
+
+    std::vector<uint32_t> segmentIndexStorage;
+    std::vector<uint64_t> segmentOffsetStorage;
+    std::vector<uint8_t> typeStorage;
+    std::vector<int32_t> dylibOrdinalStorage;
+    std::vector<uint32_t> symbolOffsetStorage;
+    std::vector<uint8_t> symbolFlagStorage;
+    std::vector<int64_t> addendStorage;
+
+    BindTable() = default;
+    BindTable(BindTable &&) = default;
+    BindTable(const BindTable &) = delete;
+
+    const char *symbolName(size_t i) const { return symbolOffsets[i] != 0 ? (const char *)base + symbolOffsets[i] : nullptr; }
+
+    BindRecord operator[](size_t i) const {
+        return {(int)segmentIndexes[i], segmentOffsets[i], types[i], dylibOrdinals[i], symbolName(i), symbolFlags[i], addends[i]};
+    }
+};
+
+// Decode the rebase opcodes at [offset, offset + size) of the image into a table, or load the table
+// from the image cache if the image has one. Throw std::runtime_error on an unknown opcode.
+RebaseTable decodeRebaseTable(const MachoImage &image, uint32_t offset, uint32_t size);
+
+// Decode the bind opcodes (regular, weak or lazy) at [offset, offset + size) of the image into a table,
+// or load the table from the image cache if the image has one.
+// Throw std::runtime_error on an unknown or unsupported opcode.
+BindTable decodeBindTable(const MachoImage &image, uint32_t offset, uint32_t size);
+
+// Run the rebase opcodes at [offset, offset + size) of the image and call `handler` for every rebase.
+// Throw std::runtime_error on an unknown opcode, a truncated operand, a segment index out of bounds
+// or a run of rebases that goes past the end of its segment.
+void forEachRebase(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const RebaseRecord&)> const& handler);
+
+// Like forEachRebase(), but call `handler` once per DO_REBASE opcode with the whole run,
+// so the cost is proportional to the number of opcodes instead of the number of rebases.
+void forEachRebaseRun(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const RebaseRun&)> const& handler);
+
+// Run the bind opcodes (regular, weak or lazy) at [offset, offset + size) of the image and call `handler` for every bind.
+// Throw std::runtime_error on an unknown or unsupported opcode, a truncated operand or symbol name,
+// a segment index out of bounds or a run of binds that goes past the end of its segment.
+void forEachBind(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const BindRecord&)> const& handler);
+
+// Like forEachBind(), but call `handler` once per DO_BIND opcode with the whole run.
+void forEachBindRun(const MachoImage &image, uint32_t offset, uint32_t size, std::function<void(const BindRun&)> const& handler);
+
+// The dylib ordinal of BIND_OPCODE_SET_DYLIB_SPECIAL_IMM, which is sign extended from the 4-bit immediate.
+inline int8_t convertSignedImm(uint8_t imm) {
+    return (imm & 0x08) ? (imm | 0xF0) : imm;
+}
+
+#endif /* REBASE_BIND_H */
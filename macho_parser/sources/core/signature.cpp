@@ -0,0 +1,80 @@
+#include <stdexcept>
+#include <string>
+
+#include <arpa/inet.h>
+
+#include "core/signature.h"
+
+CodeSignatureSuperBlob::CodeSignatureSuperBlob(DataCursor data) : data(data) {
+    superBlob = (const CS_SuperBlob *)data.subrange(0, sizeof(CS_SuperBlob)).data();
+    data.subrange(0, sizeof(CS_SuperBlob) + (uint64_t)count() * sizeof(CS_BlobIndex));
+}
+
+uint32_t CodeSignatureSuperBlob::magic() const {
+    return ntohl(superBlob->magic);
+}
+
+uint32_t CodeSignatureSuperBlob::length() const {
+    return ntohl(superBlob->length);
+}
+
+uint32_t CodeSignatureSuperBlob::count() const {
+    return ntohl(superBlob->count);
+}
+
+CodeSignatureBlob CodeSignatureSuperBlob::operator[](uint32_t index) const {
+    if (index >= count()) {
+        throw std::runtime_error("Code signature blob index " + std::to_string(index) + " is out of bounds");
+    }
+
+    CodeSignatureBlob blob;
+    blob.type = ntohl(superBlob->index[index].type);
+    blob.offset = ntohl(superBlob->index[index].offset);
+
+    const CS_GenericBlob *header = (const CS_GenericBlob *)data.subrange(blob.offset, sizeof(CS_GenericBlob)).data();
+    uint32_t length = ntohl(header->length);
+    if (length < sizeof(CS_GenericBlob)) {
+        throw std::runtime_error("Code signature blob at offset " + std::to_string(blob.offset) + " has an invalid length");
+    }
+    blob.magic = ntohl(header->magic);
+    blob.data = data.subrange(blob.offset, length);
+    return blob;
+}
+
+CodeSignatureSuperBlob getCodeSignature(const MachoImage &image) {
+    if (image.codeSignatureCmd == nullptr) {
+        throw std::runtime_error("The image doesn't have LC_CODE_SIGNATURE");
+    }
+    return CodeSignatureSuperBlob(image.getData(image.codeSignatureCmd->dataoff, image.codeSignatureCmd->datasize));
+}
+
+CodeDirectory decodeCodeDirectory(DataCursor blob) {
+    const CS_CodeDirectory *raw = (const CS_CodeDirectory *)blob.subrange(0, sizeof(CS_CodeDirectory)).data();
+
+    CodeDirectory directory;
+    directory.base = blob.data();
+    directory.length = blob.size();
+    directory.version = ntohl(raw->version);
+    directory.flags = ntohl(raw->flags);
+    directory.hashOffset = ntohl(raw->hashOffset);
+    directory.identOffset = ntohl(raw->identOffset);
+    directory.nSpecialSlots = ntohl(raw->nSpecialSlots);
+    directory.nCodeSlots = ntohl(raw->nCodeSlots);
+    directory.codeLimit = ntohl(raw->codeLimit);
+    directory.hashSize = raw->hashSize;
+    directory.hashType = raw->hashType;
+    directory.platform = raw->platform;
+    directory.pageSize = raw->pageSize;
+
+    blob.seek(directory.identOffset);
+    directory.identity = blob.readCString();
+
+    // Special slots are indexed backwards from hashOffset.
+    uint64_t specialSize = (uint64_t)directory.nSpecialSlots * directory.hashSize;
+    if (specialSize > directory.hashOffset) {
+        throw std::runtime_error("The special slots of the code directory are out of bounds");
+    }
+    blob.subrange(directory.hashOffset - specialSize, specialSize);
+    blob.subrange(directory.hashOffset, (uint64_t)directory.nCodeSlots * directory.hashSize);
+    return directory;
+}
@@ -0,0 +1,68 @@
+#ifndef SIGNATURE_H
+#define SIGNATURE_H
+
+#include "apple/kern/cs_blobs.h"
+
+#include "utils/utils.h"
+#include "core/macho_image.h"
+
+// The code signature of LC_CODE_SIGNATURE, decoded without printing anything. Code signatures are
+// big-endian, and everything below is in host byte order.
+
+// One blob in the index of a super blob.
+struct CodeSignatureBlob {
+    uint32_t type;      // CSSLOT_* in an embedded signature, kSecDesignatedRequirementType etc. in a requirements set
+    uint32_t offset;    // from the start of the super blob
+    uint32_t magic;     // CSMAGIC_*
+    DataCursor data;    // the whole blob including its magic and length, which is its size
+
+    // The bytes after the magic and the length.
+    DataCursor payload() const { return data.subrange(sizeof(CS_GenericBlob), data.size() - sizeof(CS_GenericBlob)); }
+};
+
+// A super blob, which is both the embedded signature that LC_CODE_SIGNATURE points to and the requirements set in it.
+class CodeSignatureSuperBlob {
+public:
+    // Throw std::runtime_error if `data` is too small for the header and the index.
+    explicit CodeSignatureSuperBlob(DataCursor data);
+
+    uint32_t magic() const;
+    uint32_t length() const;
+    uint32_t count() const;
+
+    // Throw std::runtime_error if `index` is out of bounds, or the blob doesn't fit in the super blob.
+    CodeSignatureBlob operator[](uint32_t index) const;
+
+private:
+    DataCursor data;
+    const CS_SuperBlob *superBlob;
+};
+
+// The embedded signature of the image. Throw std::runtime_error if the image doesn't have LC_CODE_SIGNATURE.
+CodeSignatureSuperBlob getCodeSignature(const MachoImage &image);
+
+// A CSMAGIC_CODEDIRECTORY blob.
+struct CodeDirectory {
+    const uint8_t *base;    // the whole directory, which is what CDHash hashes
+    uint32_t length;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t hashOffset;
+    uint32_t identOffset;
+    uint32_t nSpecialSlots;
+    uint32_t nCodeSlots;
+    uint32_t codeLimit;
+    uint8_t hashSize;
+    uint8_t hashType;       // CS_HASHTYPE_*
+    uint8_t platform;
+    uint8_t pageSize;       // log2
+    const char *identity;
+
+    // The hash of `slot`, which is -1 to -nSpecialSlots for the special slots and 0 to nCodeSlots - 1 for the pages.
+    const uint8_t *slotHash(int slot) const { return base + hashOffset + (int64_t)slot * hashSize; }
+};
+
+// Throw std::runtime_error if the header, the identity or any hash slot isn't in `blob`.
+CodeDirectory decodeCodeDirectory(DataCursor blob);
+
+#endif /* SIGNATURE_H */
@@ -0,0 +1,169 @@
+#ifndef VIEWS_H
+#define VIEWS_H
+
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include <stddef.h>
+#include <string.h>
+#include <string_view>
+#include <type_traits>
+
+// Typed read-only views over the structures of an image. A view is a pointer or two into the image
+// bytes, so it's cheap to copy and creating or iterating over views never allocates. Names are
+// string_views into the image, so they live as long as the bytes do.
+
+// Names in load commands like segname are fixed-size arrays that aren't always null-terminated.
+inline std::string_view fixedString(const char *str, size_t maxLength) {
+    return std::string_view(str, strnlen(str, maxLength));
+}
+
+class SectionView {
+public:
+    explicit SectionView(const struct section_64 *sect) : sect(sect) {}
+
+    std::string_view name() const { return fixedString(sect->sectname, sizeof(sect->sectname)); }
+    std::string_view segmentName() const { return fixedString(sect->segname, sizeof(sect->segname)); }
+    uint64_t address() const { return sect->addr; }
+    uint64_t size() const { return sect->size; }
+    uint32_t offset() const { return sect->offset; }
+    uint32_t align() const { return sect->align; }
+    uint32_t flags() const { return sect->flags; }
+    uint8_t type() const { return sect->flags & SECTION_TYPE; }
+    uint32_t reserved1() const { return sect->reserved1; }
+    uint32_t reserved2() const { return sect->reserved2; }
+
+    bool contains(uint64_t addr) const { return addr >= sect->addr && addr - sect->addr < sect->size; }
+    const struct section_64 *raw() const { return sect; }
+
+private:
+    const struct section_64 *sect;
+};
+
+// A random access range of views, usable in a range-for loop. The elements are either the structures
+// themselves, contiguous in the image like the sections of a segment, or pointers to them like
+// the vectors of MachoImage.
+template <typename View, typename Element>
+class ViewRange {
+public:
+    class Iterator {
+    public:
+        explicit Iterator(const Element *element) : element(element) {}
+        View operator*() const { return makeView(element); }
+        Iterator &operator++() { ++element; return *this; }
+        bool operator!=(const Iterator &other) const { return element != other.element; }
+
+    private:
+        const Element *element;
+    };
+
+    ViewRange(const Element *elements, size_t count) : elements(elements), count(count) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // `index` must be less than size().
+    View operator[](size_t index) const { return makeView(elements + index); }
+    Iterator begin() const { return Iterator(elements); }
+    Iterator end() const { return Iterator(elements + count); }
+
+private:
+    const Element *elements;
+    size_t count;
+
+    static View makeView(const Element *element) {
+        if constexpr (std::is_pointer_v<Element>) {
+            return View(*element);
+        } else {
+            return View(element);
+        }
+    }
+};
+
+class SegmentView {
+public:
+    explicit SegmentView(const struct segment_command_64 *segCmd) : segCmd(segCmd) {}
+
+    std::string_view name() const { return fixedString(segCmd->segname, sizeof(segCmd->segname)); }
+    uint64_t vmaddr() const { return segCmd->vmaddr; }
+    uint64_t vmsize() const { return segCmd->vmsize; }
+    uint64_t fileoff() const { return segCmd->fileoff; }
+    uint64_t filesize() const { return segCmd->filesize; }
+    vm_prot_t maxprot() const { return segCmd->maxprot; }
+    vm_prot_t initprot() const { return segCmd->initprot; }
+    uint32_t flags() const { return segCmd->flags; }
+
+    // section_64 is immediately after segment_command_64.
+    ViewRange<SectionView, struct section_64> sections() const {
+        return {(const struct section_64 *)(segCmd + 1), segCmd->nsects};
+    }
+
+    const struct segment_command_64 *raw() const { return segCmd; }
+
+private:
+    const struct segment_command_64 *segCmd;
+};
+
+// A symbol table entry together with the string table its name is in.
+class SymbolView {
+public:
+    SymbolView(const struct nlist_64 *nlist, const char *strings, uint32_t stringsSize)
+        : nlist(nlist), strings(strings), stringsSize(stringsSize) {}
+
+    // An empty name if n_strx is out of bounds of the string table.
+    std::string_view name() const {
+        uint32_t strx = nlist->n_un.n_strx;
+        if (strx >= stringsSize) {
+            return std::string_view();
+        }
+        return std::string_view(strings + strx, strnlen(strings + strx, stringsSize - strx));
+    }
+    uint8_t type() const { return nlist->n_type; }
+    uint8_t sect() const { return nlist->n_sect; }
+    uint16_t desc() const { return nlist->n_desc; }
+    uint64_t value() const { return nlist->n_value; }
+
+    bool isStab() const { return nlist->n_type & N_STAB; }
+    bool isExternal() const { return nlist->n_type & N_EXT; }
+    bool isUndefined() const { return !isStab() && (nlist->n_type & N_TYPE) == N_UNDF; }
+
+    const struct nlist_64 *raw() const { return nlist; }
+
+private:
+    const struct nlist_64 *nlist;
+    const char *strings;
+    uint32_t stringsSize;
+};
+
+// The symbol table, usable in a range-for loop. Empty if the image has no LC_SYMTAB.
+class SymbolRange {
+public:
+    class Iterator {
+    public:
+        Iterator(const SymbolRange *range, size_t index) : range(range), index(index) {}
+        SymbolView operator*() const { return (*range)[index]; }
+        Iterator &operator++() { ++index; return *this; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+
+    private:
+        const SymbolRange *range;
+        size_t index;
+    };
+
+    SymbolRange() = default;
+    SymbolRange(const struct nlist_64 *symbols, uint32_t count, const char *strings, uint32_t stringsSize)
+        : symbols(symbols), count(count), strings(strings), stringsSize(stringsSize) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // `index` must be less than size().
+    SymbolView operator[](size_t index) const { return SymbolView(symbols + index, strings, stringsSize); }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, count); }
+
+private:
+    const struct nlist_64 *symbols = nullptr;
+    uint32_t count = 0;
+    const char *strings = nullptr;
+    uint32_t stringsSize = 0;
+};
+
+#endif /* VIEWS_H */
@@ -1,12 +1,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdexcept>
 #include <string>
 
 #include "argument.h"
 #include "utils/utils.h"
-#include "macho_binary.h"
+#include "core/macho_image.h"
+#include "core/rebase_bind.h"
 #include "exports_trie.h"
+#include "dyld_info.h"
 
 enum BindType {
     regular,
@@ -14,13 +17,12 @@ enum BindType {
     lazy,
 };
 
-static void printRebaseTable(uint8_t *base, uint32_t offset, uint32_t size);
-static void printRebaseOpcodes(uint8_t *base, uint32_t offset, uint32_t size);
-static void printBindingTable(uint8_t *base, uint32_t offset, uint32_t size, enum BindType bindType);
-static void printBindingOpcodes(uint8_t *base, uint32_t offset, uint32_t size);
+static void printRebaseTable(const MachoImage &image, uint32_t offset, uint32_t size);
+static void printRebaseOpcodes(const MachoImage &image, uint32_t offset, uint32_t size);
+static void printBindingTable(const MachoImage &image, uint32_t offset, uint32_t size, enum BindType bindType);
+static void printBindingOpcodes(const MachoImage &image, uint32_t offset, uint32_t size);
 
-static int8_t convertSignedImm(uint8_t imm);
-static std::string getDylibName(int dylibOrdinal);
+static std::string getDylibName(const MachoImage &image, int dylibOrdinal);
 static std::string stringifyRebaseTypeImmForOpcode(int type);
 static std::string stringifyRebaseTypeImmForTable(int type);
 static std::string stringifyDylibSpecial(int dylibSpecial);
@@ -29,198 +31,134 @@ static std::string stringifySymbolFlagForTable(int flag);
 static std::string stringifyBindTypeImmForOpcode(int type);
 static std::string stringifyBindTypeImmForTable(int type);
 
-void printDyldInfo(uint8_t *base, struct dyld_info_command *dyldInfoCmd) {
+void printDyldInfo(const MachoImage &image, struct dyld_info_command *dyldInfoCmd) {
     const char *name = (dyldInfoCmd->cmd == LC_DYLD_INFO_ONLY ? "LC_DYLD_INFO_ONLY" : "LC_DYLD_INFO");
-    printf("%-20s cmdsize: %-6u export_size: %d\n", name, dyldInfoCmd->cmdsize, dyldInfoCmd->export_size);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u export_size: %d\n", name, dyldInfoCmd->cmdsize, dyldInfoCmd->export_size);
 
     if (args.verbosity == 0) { return; }
 
-    printf("  rebase_off   : %-10d   rebase_size   : %d\n", dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
-    printf("  bind_off     : %-10d   bind_size     : %d\n", dyldInfoCmd->bind_off, dyldInfoCmd->bind_size);
-    printf("  weak_bind_off: %-10d   weak_bind_size: %d\n", dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size);
-    printf("  lazy_bind_off: %-10d   lazy_bind_size: %d\n", dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size);
-    printf("  export_off   : %-10d   export_size   : %d\n", dyldInfoCmd->export_off, dyldInfoCmd->export_size);
+    fprintf(textOutput(), "  rebase_off   : %-10d   rebase_size   : %d\n", dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
+    fprintf(textOutput(), "  bind_off     : %-10d   bind_size     : %d\n", dyldInfoCmd->bind_off, dyldInfoCmd->bind_size);
+    fprintf(textOutput(), "  weak_bind_off: %-10d   weak_bind_size: %d\n", dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size);
+    fprintf(textOutput(), "  lazy_bind_off: %-10d   lazy_bind_size: %d\n", dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size);
+    fprintf(textOutput(), "  export_off   : %-10d   export_size   : %d\n", dyldInfoCmd->export_off, dyldInfoCmd->export_size);
 
     if (args.show_rebase) {
         if (args.show_opcode) {
-            printf("\n  Rebase Opcodes:\n");
-            printRebaseOpcodes(base, dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
+            fprintf(textOutput(), "\n  Rebase Opcodes:\n");
+            printRebaseOpcodes(image, dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
         } else {
-            printf("\n  Rebase Table:\n");
-            printRebaseTable(base, dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
+            fprintf(textOutput(), "\n  Rebase Table:\n");
+            printRebaseTable(image, dyldInfoCmd->rebase_off, dyldInfoCmd->rebase_size);
         }
     }
 
     if (args.show_bind) {
         if (args.show_opcode) {
-            printf("\n  Binding Opcodes:\n");
-            printBindingOpcodes(base, dyldInfoCmd->bind_off, dyldInfoCmd->bind_size);
+            fprintf(textOutput(), "\n  Binding Opcodes:\n");
+            printBindingOpcodes(image, dyldInfoCmd->bind_off, dyldInfoCmd->bind_size);
         } else {
-            printf("\n  Binding Table:\n");
-            printBindingTable(base, dyldInfoCmd->bind_off, dyldInfoCmd->bind_size, regular);
+            fprintf(textOutput(), "\n  Binding Table:\n");
+            printBindingTable(image, dyldInfoCmd->bind_off, dyldInfoCmd->bind_size, regular);
         }
     }
 
     if (args.show_lazy_bind) {
         if (args.show_opcode) {
-            printf("\n  Lazy Binding Opcodes:\n");
-            printBindingOpcodes(base, dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size);
+            fprintf(textOutput(), "\n  Lazy Binding Opcodes:\n");
+            printBindingOpcodes(image, dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size);
         } else {
-            printf("\n  Lazy Binding Table:\n");
-            printBindingTable(base, dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size, lazy);
+            fprintf(textOutput(), "\n  Lazy Binding Table:\n");
+            printBindingTable(image, dyldInfoCmd->lazy_bind_off, dyldInfoCmd->lazy_bind_size, lazy);
         }
     }
 
     if (args.show_weak_bind) {
         if (args.show_opcode) {
-            printf("\n  Weak Binding Opcodes:\n");
-            printBindingOpcodes(base, dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size);
+            fprintf(textOutput(), "\n  Weak Binding Opcodes:\n");
+            printBindingOpcodes(image, dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size);
         } else {
-            printf("\n  Weak Binding Table:\n");
-            printBindingTable(base, dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size, weak);
+            fprintf(textOutput(), "\n  Weak Binding Table:\n");
+            printBindingTable(image, dyldInfoCmd->weak_bind_off, dyldInfoCmd->weak_bind_size, weak);
         }
     }
 
     if (args.show_export) {
-        printf ("\n  Exported Symbols (Trie):");
-        printExportTrie(base, dyldInfoCmd->export_off, dyldInfoCmd->export_size);
+        fprintf(textOutput(), "\n  Exported Symbols (Trie):");
+        printExportTrie(image, dyldInfoCmd->export_off, dyldInfoCmd->export_size);
     }
 }
 
-static void printRebaseTable(uint8_t *base, uint32_t offset, uint32_t size) {
-    uint8_t *rebase = base + offset;
-    int i = 0;
-    uint64_t uleb = 0;
-    const int ptrSize = sizeof(void *);
-
-    int type = 0;
-    int segmentOrdinal = 0;
-    int segmentOffset = 0;
-
-    auto printTableRow = [&segmentOrdinal, &segmentOffset, &type, base]() {
-        struct segment_command_64 *segCmd = machoBinary.segmentCommands[segmentOrdinal];
-        uint64_t address = segCmd->vmaddr + segmentOffset;
+static void printRebaseTable(const MachoImage &image, uint32_t offset, uint32_t size) {
+    RebaseTable rebases = decodeRebaseTable(image, offset, size);
+    for (size_t i = 0; i < rebases.count; ++i) {
+        RebaseRecord rebase = rebases[i];
+        struct segment_command_64 *segCmd = image.getSegmentByIndex(rebase.segmentIndex);
+        uint64_t address = segCmd->vmaddr + rebase.segmentOffset;
 
-        struct section_64 *sect = machoBinary.getSectionByAddress(address);
+        struct section_64 *sect = image.getSectionByAddress(address);
 
         char segSectName[128];
         snprintf(segSectName, sizeof(segSectName), "%.16s,%.16s", segCmd->segname, sect ? sect->sectname : "(no section)");
 
-        printf("%-32s  0x%llX  ", segSectName, address);
-
-        printf("%s  value(0x%08llX)\n", stringifyRebaseTypeImmForTable(type).c_str(),
-            *(uint64_t *)(base + segCmd->fileoff + segmentOffset));
-    };
-
-    while (i < size) {
-        uint8_t opcode = *(rebase + i) & REBASE_OPCODE_MASK;
-        uint8_t imm = *(rebase + i) & REBASE_IMMEDIATE_MASK;
-        ++i;
+        fprintf(textOutput(), "%-32s  0x%llX  ", segSectName, (unsigned long long)address);
 
-        switch (opcode) {
-            case REBASE_OPCODE_DONE:
-                break;
-            case REBASE_OPCODE_SET_TYPE_IMM:
-                type = imm;
-                break;
-            case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB: {
-                i += readULEB128(rebase + i, &uleb);
-                segmentOrdinal = imm;
-                segmentOffset = uleb;
-                break;
-            }
-            case REBASE_OPCODE_ADD_ADDR_ULEB:
-                i += readULEB128(rebase + i, &uleb);
-                segmentOffset += uleb;
-                break;
-            case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
-                segmentOffset += imm * ptrSize;
-                break;
-            case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
-                for (int j = 0; j < imm; ++j) {
-                    printTableRow();
-                    segmentOffset += ptrSize;
-                }
-                break;
-            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
-                i += readULEB128(rebase + i, &uleb);
-                for (int j = 0; j < uleb; ++j) {
-                    printTableRow();
-                    segmentOffset += ptrSize;
-                }
-                break;
-            case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
-                printTableRow();
-                i += readULEB128(rebase + i, &uleb);
-                segmentOffset += uleb + ptrSize;
-                break;
-            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB: {
-                uint64_t count, skip;
-                i += readULEB128(rebase + i, &count);
-                i += readULEB128(rebase + i, &skip);
-                for (int j = 0; j < count; ++j) {
-                    printTableRow();
-                    segmentOffset += skip + ptrSize;
-                }
-                break;
-            }
-            default: {
-                char errMsg[32];
-                snprintf(errMsg, sizeof(errMsg), "Unknown Opcode (%#x)", opcode);
-                throw std::runtime_error(errMsg);
-            }
+        // The location can be past the file content of the segment in a malformed file.
+        uint64_t value = 0;
+        if (rebase.segmentOffset < segCmd->filesize && segCmd->filesize - rebase.segmentOffset >= sizeof(value)) {
+            memcpy(&value, image.base + segCmd->fileoff + rebase.segmentOffset, sizeof(value));
         }
+        fprintf(textOutput(), "%s  value(0x%08llX)\n", stringifyRebaseTypeImmForTable(rebase.type).c_str(), (unsigned long long)value);
     }
 }
 
-static void printRebaseOpcodes(uint8_t *base, uint32_t offset, uint32_t size) {
-    uint8_t *rebase = base + offset;
-    int i = 0;
+static void printRebaseOpcodes(const MachoImage &image, uint32_t offset, uint32_t size) {
+    DataCursor rebase = image.getData(offset, size);
     uint64_t uleb = 0;
 
-    while (i < size) {
-        uint8_t opcode = *(rebase + i) & REBASE_OPCODE_MASK;
-        uint8_t imm = *(rebase + i) & REBASE_IMMEDIATE_MASK;
-        printf ("0x%04X ", i);
-        ++i;
+    while (!rebase.atEnd()) {
+        fprintf(textOutput(), "0x%04zX ", rebase.offset());
+        uint8_t byte = rebase.readByte();
+        uint8_t opcode = byte & REBASE_OPCODE_MASK;
+        uint8_t imm = byte & REBASE_IMMEDIATE_MASK;
 
         switch (opcode) {
             case REBASE_OPCODE_DONE:
-                printf("REBASE_OPCODE_DONE\n");
+                fprintf(textOutput(), "REBASE_OPCODE_DONE\n");
                 break;
             case REBASE_OPCODE_SET_TYPE_IMM:
-                printf("REBASE_OPCODE_SET_TYPE_IMM (%s)\n", stringifyRebaseTypeImmForOpcode(imm).c_str());
+                fprintf(textOutput(), "REBASE_OPCODE_SET_TYPE_IMM (%s)\n", stringifyRebaseTypeImmForOpcode(imm).c_str());
                 break;
             case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB: {
-                struct segment_command_64 *segCmd = machoBinary.segmentCommands[imm];
-                i += readULEB128(rebase + i, &uleb);
-                printf("REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB (%d, 0x%08llx) -- %s\n",
-                     imm, uleb, segCmd->segname);
+                struct segment_command_64 *segCmd = image.getSegmentByIndex(imm);
+                uleb = rebase.readULEB128();
+                fprintf(textOutput(), "REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB (%d, 0x%08llx) -- %s\n",
+                     imm, (unsigned long long)uleb, segCmd->segname);
                 break;
             }
             case REBASE_OPCODE_ADD_ADDR_ULEB:
-                i += readULEB128(rebase + i, &uleb);
-                printf("REBASE_OPCODE_ADD_ADDR_ULEB (0x%08llx)\n", uleb);
+                uleb = rebase.readULEB128();
+                fprintf(textOutput(), "REBASE_OPCODE_ADD_ADDR_ULEB (0x%08llx)\n", (unsigned long long)uleb);
                 break;
             case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
-                printf("REBASE_OPCODE_ADD_ADDR_IMM_SCALED (%d)\n", imm);
+                fprintf(textOutput(), "REBASE_OPCODE_ADD_ADDR_IMM_SCALED (%d)\n", imm);
                 break;
             case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
-                printf("REBASE_OPCODE_DO_REBASE_IMM_TIMES (%d)\n", imm);
+                fprintf(textOutput(), "REBASE_OPCODE_DO_REBASE_IMM_TIMES (%d)\n", imm);
                 break;
             case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
-                i += readULEB128(rebase + i, &uleb);
-                printf("REBASE_OPCODE_DO_REBASE_ULEB_TIMES (%llu)\n", uleb);
+                uleb = rebase.readULEB128();
+                fprintf(textOutput(), "REBASE_OPCODE_DO_REBASE_ULEB_TIMES (%llu)\n", (unsigned long long)uleb);
                 break;
             case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
-                i += readULEB128(rebase + i, &uleb);
-                printf("REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB (0x%08llx)\n", uleb);
+                uleb = rebase.readULEB128();
+                fprintf(textOutput(), "REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB (0x%08llx)\n", (unsigned long long)uleb);
                 break;
             case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB: {
                 uint64_t count, skip;
-                i += readULEB128(rebase + i, &count);
-                i += readULEB128(rebase + i, &skip);
-                printf("REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB (count: %llu, skip: %llu)\n", uleb, skip);
+                count = rebase.readULEB128();
+                skip = rebase.readULEB128();
+                fprintf(textOutput(), "REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB (count: %llu, skip: %llu)\n", (unsigned long long)count, (unsigned long long)skip);
                 break;
             }
             default: {
@@ -232,193 +170,104 @@ static void printRebaseOpcodes(uint8_t *base, uint32_t offset, uint32_t size) {
     }
 }
 
-static void printBindingTable(uint8_t *base, uint32_t offset, uint32_t size, enum BindType bindType) {
-    const uint8_t *bind = base + offset;
-    const int ptrSize = sizeof(void *);
-    int i = 0;
-
-    int segmentOrdinal = 0;
-    int segmentOffset = 0;
-    int type = 0;
-    int dylibOrdinal = 0;
-    char *symbolName = NULL;
-    int symbolFlag = 0;
-    int addend = 0;
+static void printBindingTable(const MachoImage &image, uint32_t offset, uint32_t size, enum BindType bindType) {
+    BindTable binds = decodeBindTable(image, offset, size);
+    for (size_t i = 0; i < binds.count; ++i) {
+        BindRecord bind = binds[i];
+        struct segment_command_64 *segCmd = image.getSegmentByIndex(bind.segmentIndex);
+        uint64_t address = segCmd->vmaddr + bind.segmentOffset;
 
-    uint64_t uleb = 0;
-    int64_t sleb = 0;
-
-    auto printTableRow = [&segmentOrdinal, &segmentOffset, &dylibOrdinal, &symbolName, &type, &symbolFlag, &addend, bindType]() {
-        struct segment_command_64 *segCmd = machoBinary.segmentCommands[segmentOrdinal];
-        uint64_t address = segCmd->vmaddr + segmentOffset;
-
-        struct section_64 *sect = machoBinary.getSectionByAddress(address);
+        struct section_64 *sect = image.getSectionByAddress(address);
         char segSectName[128];
         snprintf(segSectName, sizeof(segSectName), "%.16s,%.16s", segCmd->segname, sect ? sect->sectname : "(no section)");
 
-        printf("%-24s  0x%llX  ", segSectName, address);
+        fprintf(textOutput(), "%-24s  0x%llX  ", segSectName, (unsigned long long)address);
 
         switch (bindType) {
             case regular:
-                printf("%s  %-20s  addend(%d)  %s %s\n", stringifyBindTypeImmForTable(type).c_str(),
-                    getDylibName(dylibOrdinal).c_str(), addend, symbolName,
-                    stringifySymbolFlagForTable(symbolFlag).c_str());
+                fprintf(textOutput(), "%s  %-20s  addend(%d)  %s %s\n", stringifyBindTypeImmForTable(bind.type).c_str(),
+                    getDylibName(image, bind.dylibOrdinal).c_str(), (int)bind.addend, bind.symbolName,
+                    stringifySymbolFlagForTable(bind.symbolFlags).c_str());
                 break;
             case lazy:
-                printf("%-20s %s %s\n", getDylibName(dylibOrdinal).c_str(), symbolName,
-                stringifySymbolFlagForTable(symbolFlag).c_str());
+                fprintf(textOutput(), "%-20s %s %s\n", getDylibName(image, bind.dylibOrdinal).c_str(), bind.symbolName,
+                stringifySymbolFlagForTable(bind.symbolFlags).c_str());
                 break;
             case weak:
-                printf("%s  addend(%d)  %s %s\n", stringifyBindTypeImmForTable(type).c_str(),
-                    addend, symbolName, stringifySymbolFlagForTable(symbolFlag).c_str());
-                break;
-        }
-    };
-
-
-    while (i < size) {
-        uint8_t opcode = *(bind + i) & BIND_OPCODE_MASK;
-        uint8_t imm = *(bind + i) & BIND_IMMEDIATE_MASK;
-        ++i;
-
-        switch (opcode) {
-            case BIND_OPCODE_DONE:
-                break;
-            case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
-                dylibOrdinal = imm;
-                break;
-            case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                dylibOrdinal = uleb;
-                break;
-            case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
-                // dylib special is zero or negative
-                dylibOrdinal = convertSignedImm(imm);
-                break;
-            case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM:
-                symbolFlag = imm;
-                symbolName = (char *)bind + i;
-                i += strlen((char *)bind + i) + 1;
-                break;
-            case BIND_OPCODE_SET_TYPE_IMM:
-                type = imm;
-                break;
-            case BIND_OPCODE_SET_ADDEND_SLEB:
-                i += readSLEB128(bind + i, &sleb);
-                addend = sleb;
-                break;
-            case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                segmentOrdinal = imm;
-                segmentOffset = uleb;
-                break;
-            case BIND_OPCODE_ADD_ADDR_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                segmentOffset += uleb;
+                fprintf(textOutput(), "%s  addend(%d)  %s %s\n", stringifyBindTypeImmForTable(bind.type).c_str(),
+                    (int)bind.addend, bind.symbolName, stringifySymbolFlagForTable(bind.symbolFlags).c_str());
                 break;
-            case BIND_OPCODE_DO_BIND:
-                printTableRow();
-                segmentOffset += ptrSize;
-                break;
-            case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
-                printTableRow();
-                i += readULEB128(bind + i, &uleb);
-                segmentOffset += uleb + ptrSize;
-                break;
-            case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
-                printTableRow();
-                segmentOffset += imm * ptrSize + ptrSize;
-                break;
-            case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB: {
-                uint64_t count, skip;
-                i += readULEB128(bind + i, &count);
-                i += readULEB128(bind + i, &skip);
-                for (int j = 0; j < count; ++j) {
-                    printTableRow();
-                    segmentOffset += skip + ptrSize;
-                }
-                break;
-            }
-            case BIND_OPCODE_THREADED:
-                throw std::runtime_error("Unhandled Opcode (BIND_OPCODE_THREADED)");
-            default: {
-                char errMsg[32];
-                snprintf(errMsg, sizeof(errMsg), "Unknown Opcode (%#x)", opcode);
-                throw std::runtime_error(errMsg);
-            }
         }
     }
 }
 
-static void printBindingOpcodes(uint8_t *base, uint32_t offset, uint32_t size) {
-    uint8_t *bind = base + offset;
-    int i = 0;
+static void printBindingOpcodes(const MachoImage &image, uint32_t offset, uint32_t size) {
+    DataCursor bind = image.getData(offset, size);
 
     uint64_t uleb = 0;
     int64_t sleb = 0;
 
-    while (i < size) {
-        uint8_t opcode = *(bind + i) & BIND_OPCODE_MASK;
-        uint8_t imm = *(bind + i) & BIND_IMMEDIATE_MASK;
-        printf ("0x%04X ", i);
-        ++i;
+    while (!bind.atEnd()) {
+        fprintf(textOutput(), "0x%04zX ", bind.offset());
+        uint8_t byte = bind.readByte();
+        uint8_t opcode = byte & BIND_OPCODE_MASK;
+        uint8_t imm = byte & BIND_IMMEDIATE_MASK;
 
         switch (opcode) {
             case BIND_OPCODE_DONE:
-                printf("BIND_OPCODE_DONE\n");
+                fprintf(textOutput(), "BIND_OPCODE_DONE\n");
                 break;
             case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
                 // dylib ordinal starts at 1
-                printf("BIND_OPCODE_SET_DYLIB_ORDINAL_IMM (%d) -- %s\n",
-                    imm, getDylibName(imm).c_str());
+                fprintf(textOutput(), "BIND_OPCODE_SET_DYLIB_ORDINAL_IMM (%d) -- %s\n",
+                    imm, getDylibName(image, imm).c_str());
                 break;
             case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                printf("BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB (%llu) -- %s\n",
-                    uleb, getDylibName(uleb).c_str());
+                uleb = bind.readULEB128();
+                fprintf(textOutput(), "BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB (%llu) -- %s\n",
+                    (unsigned long long)uleb, getDylibName(image, uleb).c_str());
                 break;
             case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
-                printf("BIND_OPCODE_SET_DYLIB_SPECIAL_IMM (%s)\n",
+                fprintf(textOutput(), "BIND_OPCODE_SET_DYLIB_SPECIAL_IMM (%s)\n",
                     stringifyDylibSpecial(convertSignedImm(imm)).c_str());
                 break;
             case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM:
-                printf("BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM (%s, %s)\n",
-                    stringifySymbolFlagForOpcode(imm).c_str(), (char *)bind + i);
-                i += strlen((char *)bind + i) + 1;
+                fprintf(textOutput(), "BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM (%s, %s)\n",
+                    stringifySymbolFlagForOpcode(imm).c_str(), bind.readCString());
                 break;
             case BIND_OPCODE_SET_TYPE_IMM:
-                printf("BIND_OPCODE_SET_TYPE_IMM (%s)\n", stringifyBindTypeImmForOpcode(imm).c_str());
+                fprintf(textOutput(), "BIND_OPCODE_SET_TYPE_IMM (%s)\n", stringifyBindTypeImmForOpcode(imm).c_str());
                 break;
             case BIND_OPCODE_SET_ADDEND_SLEB:
-                i += readSLEB128(bind + i, &sleb);
-                printf("BIND_OPCODE_SET_ADDEND_SLEB (%lld)\n", sleb);
+                sleb = bind.readSLEB128();
+                fprintf(textOutput(), "BIND_OPCODE_SET_ADDEND_SLEB (%lld)\n", (long long)sleb);
                 break;
             case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB: {
-                struct segment_command_64 *segCmd = machoBinary.segmentCommands[imm];
-                i += readULEB128(bind + i, &uleb);
-                printf("BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB (%d, 0x%08llx) -- %s\n",
-                    imm, uleb, segCmd->segname);
+                struct segment_command_64 *segCmd = image.getSegmentByIndex(imm);
+                uleb = bind.readULEB128();
+                fprintf(textOutput(), "BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB (%d, 0x%08llx) -- %s\n",
+                    imm, (unsigned long long)uleb, segCmd->segname);
                 break;
             }
             case BIND_OPCODE_ADD_ADDR_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                printf("BIND_OPCODE_ADD_ADDR_ULEB (0x%08llx)\n", uleb);
+                uleb = bind.readULEB128();
+                fprintf(textOutput(), "BIND_OPCODE_ADD_ADDR_ULEB (0x%08llx)\n", (unsigned long long)uleb);
                 break;
             case BIND_OPCODE_DO_BIND:
-                printf("BIND_OPCODE_DO_BIND ()\n");
+                fprintf(textOutput(), "BIND_OPCODE_DO_BIND ()\n");
                 break;
             case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
-                i += readULEB128(bind + i, &uleb);
-                printf("BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB (0x%08llx)\n", uleb);
+                uleb = bind.readULEB128();
+                fprintf(textOutput(), "BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB (0x%08llx)\n", (unsigned long long)uleb);
                 break;
             case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
-                printf("BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED (%d)\n", imm);
+                fprintf(textOutput(), "BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED (%d)\n", imm);
                 break;
             case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB: {
                 uint64_t count, skip;
-                i += readULEB128(bind + i, &count);
-                i += readULEB128(bind + i, &skip);
-                printf("BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB (count: %llu, skip: %llu)\n", uleb, skip);
+                count = bind.readULEB128();
+                skip = bind.readULEB128();
+                fprintf(textOutput(), "BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB (count: %llu, skip: %llu)\n", (unsigned long long)count, (unsigned long long)skip);
                 break;
             }
             case BIND_OPCODE_THREADED:
@@ -432,10 +281,6 @@ static void printBindingOpcodes(uint8_t *base, uint32_t offset, uint32_t size) {
     }
 }
 
-static int8_t convertSignedImm(uint8_t imm) {
-    return (imm & 0x08) ? (imm | 0xF0) : imm;
-}
-
 static std::string stringifySymbolFlagForOpcode(int flag) {
     switch(flag) {
         case 0:
@@ -533,7 +378,7 @@ static std::string stringifyDylibSpecial(int dylibSpecial) {
     throw std::runtime_error(std::string("Invalid or unhandled dylib special: ") + std::to_string(dylibSpecial));
 }
 
-static std::string getDylibName(int dylibOrdinal) {
+static std::string getDylibName(const MachoImage &image, int dylibOrdinal) {
     switch (dylibOrdinal) {
     case BIND_SPECIAL_DYLIB_SELF:
         return std::string("self");
@@ -547,7 +392,7 @@ static std::string getDylibName(int dylibOrdinal) {
     }
 
     if (dylibOrdinal > 0) {
-        return machoBinary.getDylibNameByOrdinal(dylibOrdinal);
+        return image.getDylibNameByOrdinal(dylibOrdinal);
     }
 
     throw std::runtime_error(std::string("Invalid or unhandled dylib ordinal: ") + std::to_string(dylibOrdinal));
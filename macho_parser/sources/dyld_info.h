@@ -0,0 +1,10 @@
+#ifndef DYLD_INFO_H
+#define DYLD_INFO_H
+
+#include "apple/mach-o/loader.h"
+
+#include "core/macho_image.h"
+
+void printDyldInfo(const MachoImage &image, struct dyld_info_command *dyldInfoCmd);
+
+#endif /* DYLD_INFO_H */
@@ -2,7 +2,7 @@
 #include <string.h>
 
 #include "utils/utils.h"
-#include "load_command.h"
+#include "core/load_command.h"
 #include "argument.h"
 
 static void printDylibDetail(struct dylib dylib);
@@ -18,7 +18,7 @@ void printDylib(const uint8_t *base, const struct dylib_command *cmd) {
     } else if (cmd->cmd == LC_REEXPORT_DYLIB) {
         cmdName = "LC_REEXPORT_DYLIB";
     }
-    printf("%-20s cmdsize: %-6u %s\n", cmdName, cmd->cmdsize, (char *)cmd + cmd->dylib.name.offset);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u %s\n", cmdName, cmd->cmdsize, (char *)cmd + cmd->dylib.name.offset);
 
     if (args.verbosity < 2) {
         return;
@@ -31,7 +31,7 @@ static void printDylibDetail(struct dylib dylib) {
     auto currentVersion = formatVersion(dylib.current_version);
     auto compatibilityVersion = formatVersion(dylib.compatibility_version);
 
-    printf("  timestamp            : %u\n", dylib.timestamp);
-    printf("  current version      : %s\n", currentVersion.c_str());
-    printf("  compatibility version : %s\n", compatibilityVersion.c_str());
+    fprintf(textOutput(), "  timestamp            : %u\n", dylib.timestamp);
+    fprintf(textOutput(), "  current version      : %s\n", currentVersion.c_str());
+    fprintf(textOutput(), "  compatibility version : %s\n", compatibilityVersion.c_str());
 }
@@ -1,8 +1,10 @@
 #include <stdio.h>
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
+
+#include "utils/utils.h"
 
 void printEncryptionInfo(uint8_t *base, struct encryption_info_command_64 *cmd) {
-    printf("%-20s cmdsize: %-5u cryptoff: %u  cryptsize: %u  (range: %#x-%#x)  cryptid: %u   pad: %u\n",
+    fprintf(textOutput(), "%-20s cmdsize: %-5u cryptoff: %u  cryptsize: %u  (range: %#x-%#x)  cryptid: %u   pad: %u\n",
         "LC_ENCRYPTION_INFO_64", cmd->cmdsize, cmd->cryptoff, cmd->cryptsize, cmd->cryptoff,
         cmd->cryptoff + cmd->cryptsize, cmd->cryptid, cmd->pad);
 }
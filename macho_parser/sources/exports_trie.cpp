@@ -2,43 +2,172 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include "apple/mach-o/loader.h"
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
 
 #include "utils/utils.h"
+#include "core/exports.h"
 #include "exports_trie.h"
 
-static void printExportRecursion(uint8_t *exportStart, uint8_t *nodePtr, int level);
+static void printExportNode(DataCursor &trie);
+static void printExportTree(DataCursor trie);
+static std::string formatExportFlags(uint64_t flags);
 
-void printExportTrie(uint8_t *base, uint32_t dataoff, uint32_t datasize) {
-    uint8_t *exportInfo = base + dataoff;
-    printExportRecursion(exportInfo, exportInfo, 0);
+void printExportTrie(const MachoImage &image, uint32_t dataoff, uint32_t datasize) {
+    printExportTree(image.getData(dataoff, datasize));
 }
 
-static void printExportRecursion(uint8_t *exportStart, uint8_t *nodePtr, int level) {
-    uint64_t terminalSize;
-    int byteCount = readULEB128(nodePtr, &terminalSize);
-    uint8_t *childrenCountPtr = nodePtr + byteCount + terminalSize;
+// Print the terminal data of the node at the cursor and leave the cursor at its children count.
+static void printExportNode(DataCursor &trie) {
+    uint64_t terminalSize = trie.readULEB128();
+    const uint8_t *terminal = trie.readBytes(terminalSize);
 
     if (terminalSize != 0) {
-        printf(" (data: ");
+        fprintf(textOutput(), " (data: ");
         for (int i = 0; i < terminalSize; ++i) {
-            printf("%02x", *(nodePtr + byteCount + i));
+            fprintf(textOutput(), "%02x", terminal[i]);
         }
-        printf(")\n");
+        fprintf(textOutput(), ")\n");
     } else {
-        printf("\n");
+        fprintf(textOutput(), "\n");
+    }
+}
+
+static void printExportTree(DataCursor trie) {
+    struct Frame {
+        size_t edge;
+        uint8_t remaining;
+        int level;
+    };
+
+    if (trie.size() == 0) {
+        fprintf(textOutput(), "\n");
+        return;
     }
 
     // According to the source code in dyld,
     // the count number is not uleb128 encoded;
-    uint8_t children_count = *childrenCountPtr;
-    uint8_t *s = childrenCountPtr + 1;
-    for (int i = 0; i < children_count; ++i) {
-        printf("  %*s%s", level * 2, "", s);
-        s += strlen((char *)s) + 1;
+    printExportNode(trie);
+    uint8_t childrenCount = trie.readByte();
+    std::vector<Frame> stack = {{trie.offset(), childrenCount, 0}};
+    while (!stack.empty()) {
+        Frame &frame = stack.back();
+        if (frame.remaining == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        trie.seek(frame.edge);
+        fprintf(textOutput(), "  %*s%s", frame.level * 2, "", trie.readCString());
+
+        uint64_t child_offset = trie.readULEB128();
+        frame.edge = trie.offset(); // now it points to the next child's edge string
+        frame.remaining--;
+
+        // A node takes at least two bytes, so a path can't be longer than half of the trie without a cycle.
+        if (stack.size() > trie.size() / 2) {
+            throw std::runtime_error("Malformed export trie, it has a cycle");
+        }
+
+        int level = frame.level + 1;
+        trie.seek(child_offset);
+        printExportNode(trie);
+        childrenCount = trie.readByte();
+        stack.push_back({trie.offset(), childrenCount, level});
+    }
+}
 
-        uint64_t child_offset;
-        byteCount = readULEB128(s, &child_offset);
-        s += byteCount; // now s points to the next child's edge string
-        printExportRecursion(exportStart, exportStart + child_offset, level + 1);
+bool printExportLookup(const MachoImage &image, const char *name) {
+    ExportRecord record;
+    try {
+        if (!exportLookup(image, name, record)) {
+            fprintf(textOutput(), "%s is not exported\n", name);
+            return false;
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        exit(1);
     }
+
+    fprintf(textOutput(), "%s\n", name);
+    fprintf(textOutput(), "    flags: 0x%llx (%s)\n", (unsigned long long)record.flags, formatExportFlags(record.flags).c_str());
+    if (record.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        fprintf(textOutput(), "    re-exported from: %s\n", image.getDylibNameByOrdinal(record.dylibOrdinal).c_str());
+        if (record.importName[0] != '\0') {
+            fprintf(textOutput(), "    as: %s\n", record.importName);
+        }
+    } else if (record.flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+        fprintf(textOutput(), "    stub: 0x%llx\n", (unsigned long long)record.address);
+        fprintf(textOutput(), "    resolver: 0x%llx\n", (unsigned long long)record.resolver);
+    } else {
+        fprintf(textOutput(), "    address: 0x%llx\n", (unsigned long long)record.address);
+    }
+    return true;
+}
+
+void printRebuiltExportTrie(const MachoImage &image, const char *hiddenSymbolsPath) {
+    std::vector<std::string> hiddenSymbols;
+    if (hiddenSymbolsPath != NULL) {
+        std::ifstream symbolList(hiddenSymbolsPath);
+        if (!symbolList) {
+            fprintf(stderr, "Cannot read symbol list %s\n", hiddenSymbolsPath);
+            exit(1);
+        }
+
+        std::string line;
+        while (std::getline(symbolList, line)) {
+            if (!line.empty()) {
+                hiddenSymbols.push_back(line);
+            }
+        }
+    }
+    std::unordered_set<std::string_view> hidden(hiddenSymbols.begin(), hiddenSymbols.end());
+
+    std::vector<ExportTrieEntry> entries;
+    size_t hiddenCount = 0;
+    uint32_t originalSize = getExportTrie(image).second;
+    std::vector<uint8_t> rebuilt;
+    try {
+        forEachExport(image, [&](const ExportRecord &record) {
+            if (hidden.count(record.name) != 0) {
+                hiddenCount++;
+                return;
+            }
+            entries.push_back({std::string(record.name), record.flags, record.address, record.resolver,
+                record.dylibOrdinal, record.importName != nullptr ? record.importName : ""});
+        });
+        rebuilt = buildExportTrie(entries);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        exit(1);
+    }
+
+    int64_t delta = (int64_t)rebuilt.size() - originalSize;
+    fprintf(textOutput(), "exports:       %zu (%zu hidden)\n", entries.size() + hiddenCount, hiddenCount);
+    fprintf(textOutput(), "original trie: %u bytes\n", originalSize);
+    fprintf(textOutput(), "rebuilt trie:  %zu bytes (%+lld bytes", rebuilt.size(), (long long)delta);
+    if (originalSize > 0) {
+        fprintf(textOutput(), ", %+.1f%%", delta * 100.0 / originalSize);
+    }
+    fprintf(textOutput(), ")\n");
+}
+
+static std::string formatExportFlags(uint64_t flags) {
+    std::string formatted;
+    switch (flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) {
+        case EXPORT_SYMBOL_FLAGS_KIND_REGULAR: formatted = "regular"; break;
+        case EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL: formatted = "thread local"; break;
+        case EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE: formatted = "absolute"; break;
+        default: formatted = "unknown kind"; break;
+    }
+
+    if (flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION) { formatted += ", weak definition"; }
+    if (flags & EXPORT_SYMBOL_FLAGS_REEXPORT) { formatted += ", re-export"; }
+    if (flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) { formatted += ", stub and resolver"; }
+    return formatted;
 }
@@ -1,6 +1,17 @@
 #ifndef EXPORTS_TRIE_H
 #define EXPORTS_TRIE_H
 
-void printExportTrie(uint8_t *base, uint32_t dataoff, uint32_t datasize);
+#include "core/macho_image.h"
+
+// Print the export trie at [dataoff, dataoff + datasize) of the image as a tree of edges.
+// Throw std::runtime_error if the trie is malformed.
+void printExportTrie(const MachoImage &image, uint32_t dataoff, uint32_t datasize);
+
+// Print how `name` is exported for --lookup-export. Return false if it isn't exported.
+bool printExportLookup(const MachoImage &image, const char *name);
+
+// Re-encode the exports of the image with buildExportTrie() and print the size against the original trie,
+// for --rebuild-exports. The names listed in `hiddenSymbolsPath`, one per line, are left out if it's not null.
+void printRebuiltExportTrie(const MachoImage &image, const char *hiddenSymbolsPath);
 
 #endif // EXPORTS_TRIE_H
@@ -0,0 +1,519 @@
+#include <stdio.h>
+#include <string.h>
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include "apple/mach-o/fixup-chains.h"
+#include <string>
+
+#include "argument.h"
+#include "utils/utils.h"
+#include "macho_header.h"
+#include "core/load_command.h"
+#include "core/fixup_chains.h"
+#include "core/rebase_bind.h"
+#include "core/exports.h"
+
+#include "json_output.h"
+
+static void beginRecord(JsonWriter &writer, const char *record);
+static void endRecord(JsonWriter &writer);
+
+static void printHeaderRecord(JsonWriter &writer, const MachoImage &image);
+static void printLoadCommandRecord(JsonWriter &writer, const MachoImage &image, struct load_command *lcmd, int index, int firstSectionIndex);
+static void printLoadCommandFields(JsonWriter &writer, const MachoImage &image, struct load_command *lcmd);
+static void printSectionRecords(JsonWriter &writer, struct segment_command_64 *segCmd, int firstSectionIndex);
+static void printSymbolRecords(JsonWriter &writer, const MachoImage &image, struct symtab_command *symtabCmd);
+static void printSymbolRecord(JsonWriter &writer, const MachoImage &image, int index);
+static void printFunctionStartRecords(JsonWriter &writer, const MachoImage &image);
+static void printChainedImportRecords(JsonWriter &writer, const MachoImage &image);
+static void printChainedFixupRecords(JsonWriter &writer, const MachoImage &image);
+static void printRebaseRecords(JsonWriter &writer, const MachoImage &image, uint32_t offset, uint32_t size);
+static void printBindRecords(JsonWriter &writer, const MachoImage &image, const char *kind, uint32_t offset, uint32_t size);
+static void printExportRecords(JsonWriter &writer, const MachoImage &image);
+static uint64_t segmentAddress(const MachoImage &image, int segmentIndex);
+
+JsonOutput::JsonOutput(FILE *file, bool continuation) : buffer(file, 1024 * 1024), jsonWriter(buffer), continuation(continuation) {
+    fflush(file);
+    if (args.format == FORMAT_JSON) {
+        if (continuation) {
+            jsonWriter.continueArray();
+        } else {
+            jsonWriter.beginArray();
+            jsonWriter.newline();
+        }
+    }
+}
+
+JsonOutput::~JsonOutput() {
+    if (args.format == FORMAT_JSON && !continuation) {
+        jsonWriter.endArray();
+        jsonWriter.newline();
+    }
+}
+
+void printJsonMember(JsonWriter &writer, const char *name) {
+    beginRecord(writer, "member");
+    writer.stringField("name", name);
+    endRecord(writer);
+}
+
+void printJsonImage(JsonWriter &writer, const MachoImage &image) {
+    // the same condition as showHeader() in the text output
+    if (args.command_count == 0) {
+        printHeaderRecord(writer, image);
+    }
+
+    int sectionIndex = 0;
+    for (int i = 0; i < image.allLoadCommands.size(); ++i) {
+        struct load_command *lcmd = image.allLoadCommands[i];
+        if (showCommand(lcmd->cmd)) {
+            printLoadCommandRecord(writer, image, lcmd, i, sectionIndex);
+        }
+
+        if (lcmd->cmd == LC_SEGMENT_64) {
+            sectionIndex += ((struct segment_command_64 *)lcmd)->nsects;
+        }
+    }
+}
+
+static void beginRecord(JsonWriter &writer, const char *record) {
+    writer.beginObject();
+    writer.stringField("record", record);
+}
+
+static void endRecord(JsonWriter &writer) {
+    writer.endObject();
+    writer.newline();
+}
+
+static void printHeaderRecord(JsonWriter &writer, const MachoImage &image) {
+    struct mach_header_64 *header = image.header;
+
+    beginRecord(writer, "header");
+    writer.hexField("magic", header->magic);
+    writer.stringField("cputype", stringifyCPUType(header->cputype));
+    writer.numberField("cpusubtype", header->cpusubtype & ~CPU_SUBTYPE_MASK);
+    writer.stringField("filetype", stringifyFileType(header->filetype));
+    writer.numberField("ncmds", header->ncmds);
+    writer.numberField("sizeofcmds", header->sizeofcmds);
+    writer.hexField("flags", header->flags);
+    endRecord(writer);
+}
+
+static void printLoadCommandRecord(JsonWriter &writer, const MachoImage &image, struct load_command *lcmd, int index, int firstSectionIndex) {
+    if (lcmd->cmd == LC_SEGMENT_64 && hasSectionSpecifed()) {
+        // Like the text output, only the sections matter if --section is specified.
+        printSectionRecords(writer, (struct segment_command_64 *)lcmd, firstSectionIndex);
+        return;
+    }
+
+    beginRecord(writer, "load_command");
+    writer.numberField("index", index);
+    const char *name = stringifyLoadCommand(lcmd->cmd);
+    if (name != NULL) {
+        writer.stringField("cmd", name);
+    } else {
+        writer.hexField("cmd", lcmd->cmd);
+    }
+    writer.numberField("cmdsize", lcmd->cmdsize);
+    printLoadCommandFields(writer, image, lcmd);
+    endRecord(writer);
+
+    if (args.verbosity == 0) {
+        return;
+    }
+
+    switch (lcmd->cmd) {
+        case LC_SEGMENT_64:
+            printSectionRecords(writer, (struct segment_command_64 *)lcmd, firstSectionIndex);
+            break;
+        case LC_SYMTAB:
+            printSymbolRecords(writer, image, (struct symtab_command *)lcmd);
+            break;
+        case LC_FUNCTION_STARTS:
+            printFunctionStartRecords(writer, image);
+            break;
+        case LC_DYLD_CHAINED_FIXUPS:
+            printChainedImportRecords(writer, image);
+            printChainedFixupRecords(writer, image);
+            break;
+        case LC_DYLD_EXPORTS_TRIE:
+            printExportRecords(writer, image);
+            break;
+        case LC_DYLD_INFO:
+        case LC_DYLD_INFO_ONLY: {
+            struct dyld_info_command *cmd = (struct dyld_info_command *)lcmd;
+            if (args.show_rebase) {
+                printRebaseRecords(writer, image, cmd->rebase_off, cmd->rebase_size);
+            }
+            if (args.show_bind) {
+                printBindRecords(writer, image, "regular", cmd->bind_off, cmd->bind_size);
+            }
+            if (args.show_lazy_bind) {
+                printBindRecords(writer, image, "lazy", cmd->lazy_bind_off, cmd->lazy_bind_size);
+            }
+            if (args.show_weak_bind) {
+                printBindRecords(writer, image, "weak", cmd->weak_bind_off, cmd->weak_bind_size);
+            }
+            if (args.show_export) {
+                printExportRecords(writer, image);
+            }
+            break;
+        }
+    }
+}
+
+// The fields of a load command record besides cmd and cmdsize.
+static void printLoadCommandFields(JsonWriter &writer, const MachoImage &image, struct load_command *lcmd) {
+    switch (lcmd->cmd) {
+        case LC_SEGMENT_64: {
+            struct segment_command_64 *cmd = (struct segment_command_64 *)lcmd;
+            writer.stringField("segname", fixedString(cmd->segname, sizeof(cmd->segname)));
+            writer.hexField("vmaddr", cmd->vmaddr);
+            writer.numberField("vmsize", cmd->vmsize);
+            writer.numberField("fileoff", cmd->fileoff);
+            writer.numberField("filesize", cmd->filesize);
+            writer.numberField("maxprot", cmd->maxprot);
+            writer.numberField("initprot", cmd->initprot);
+            writer.numberField("nsects", cmd->nsects);
+            writer.hexField("flags", cmd->flags);
+            break;
+        }
+        case LC_SYMTAB: {
+            struct symtab_command *cmd = (struct symtab_command *)lcmd;
+            writer.numberField("symoff", cmd->symoff);
+            writer.numberField("nsyms", cmd->nsyms);
+            writer.numberField("stroff", cmd->stroff);
+            writer.numberField("strsize", cmd->strsize);
+            break;
+        }
+        case LC_DYSYMTAB: {
+            struct dysymtab_command *cmd = (struct dysymtab_command *)lcmd;
+            writer.numberField("ilocalsym", cmd->ilocalsym);
+            writer.numberField("nlocalsym", cmd->nlocalsym);
+            writer.numberField("iextdefsym", cmd->iextdefsym);
+            writer.numberField("nextdefsym", cmd->nextdefsym);
+            writer.numberField("iundefsym", cmd->iundefsym);
+            writer.numberField("nundefsym", cmd->nundefsym);
+            writer.numberField("indirectsymoff", cmd->indirectsymoff);
+            writer.numberField("nindirectsyms", cmd->nindirectsyms);
+            break;
+        }
+        case LC_ID_DYLIB:
+        case LC_LOAD_DYLIB:
+        case LC_LOAD_WEAK_DYLIB:
+        case LC_REEXPORT_DYLIB:
+        case LC_LAZY_LOAD_DYLIB:
+        case LC_LOAD_UPWARD_DYLIB: {
+            struct dylib_command *cmd = (struct dylib_command *)lcmd;
+            writer.stringField("name", (char *)cmd + cmd->dylib.name.offset);
+            writer.numberField("timestamp", cmd->dylib.timestamp);
+            writer.stringField("current_version", formatVersion(cmd->dylib.current_version));
+            writer.stringField("compatibility_version", formatVersion(cmd->dylib.compatibility_version));
+            break;
+        }
+        case LC_LOAD_DYLINKER:
+        case LC_ID_DYLINKER:
+        case LC_DYLD_ENVIRONMENT: {
+            struct dylinker_command *cmd = (struct dylinker_command *)lcmd;
+            writer.stringField("name", (char *)cmd + cmd->name.offset);
+            break;
+        }
+        case LC_RPATH: {
+            struct rpath_command *cmd = (struct rpath_command *)lcmd;
+            writer.stringField("path", (char *)cmd + cmd->path.offset);
+            break;
+        }
+        case LC_MAIN: {
+            struct entry_point_command *cmd = (struct entry_point_command *)lcmd;
+            writer.numberField("entryoff", cmd->entryoff);
+            writer.numberField("stacksize", cmd->stacksize);
+            break;
+        }
+        case LC_UUID: {
+            struct uuid_command *cmd = (struct uuid_command *)lcmd;
+            char uuid[40];
+            snprintf(uuid, sizeof(uuid), "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+                cmd->uuid[0], cmd->uuid[1], cmd->uuid[2], cmd->uuid[3], cmd->uuid[4], cmd->uuid[5],
+                cmd->uuid[6], cmd->uuid[7], cmd->uuid[8], cmd->uuid[9], cmd->uuid[10], cmd->uuid[11],
+                cmd->uuid[12], cmd->uuid[13], cmd->uuid[14], cmd->uuid[15]);
+            writer.stringField("uuid", uuid);
+            break;
+        }
+        case LC_SOURCE_VERSION: {
+            struct source_version_command *cmd = (struct source_version_command *)lcmd;
+            char version[64];
+            snprintf(version, sizeof(version), "%llu.%llu.%llu.%llu.%llu",
+                (unsigned long long)(cmd->version >> 40), (unsigned long long)((cmd->version >> 30) & 0x3ff),
+                (unsigned long long)((cmd->version >> 20) & 0x3ff), (unsigned long long)((cmd->version >> 10) & 0x3ff),
+                (unsigned long long)(cmd->version & 0x3ff));
+            writer.stringField("version", version);
+            break;
+        }
+        case LC_BUILD_VERSION: {
+            struct build_version_command *cmd = (struct build_version_command *)lcmd;
+            writer.numberField("platform", cmd->platform);
+            writer.stringField("minos", formatVersion(cmd->minos));
+            writer.stringField("sdk", formatVersion(cmd->sdk));
+            writer.key("tools");
+            writer.beginArray();
+            struct build_tool_version *tools = (struct build_tool_version *)((uint8_t *)cmd + sizeof(struct build_version_command));
+            for (int i = 0; i < cmd->ntools; ++i) {
+                writer.beginObject();
+                writer.numberField("tool", tools[i].tool);
+                writer.stringField("version", formatVersion(tools[i].version));
+                writer.endObject();
+            }
+            writer.endArray();
+            break;
+        }
+        case LC_VERSION_MIN_MACOSX:
+        case LC_VERSION_MIN_IPHONEOS:
+        case LC_VERSION_MIN_WATCHOS:
+        case LC_VERSION_MIN_TVOS: {
+            struct version_min_command *cmd = (struct version_min_command *)lcmd;
+            writer.stringField("version", formatVersion(cmd->version));
+            writer.stringField("sdk", formatVersion(cmd->sdk));
+            break;
+        }
+        case LC_DYLD_INFO:
+        case LC_DYLD_INFO_ONLY: {
+            struct dyld_info_command *cmd = (struct dyld_info_command *)lcmd;
+            writer.numberField("rebase_off", cmd->rebase_off);
+            writer.numberField("rebase_size", cmd->rebase_size);
+            writer.numberField("bind_off", cmd->bind_off);
+            writer.numberField("bind_size", cmd->bind_size);
+            writer.numberField("weak_bind_off", cmd->weak_bind_off);
+            writer.numberField("weak_bind_size", cmd->weak_bind_size);
+            writer.numberField("lazy_bind_off", cmd->lazy_bind_off);
+            writer.numberField("lazy_bind_size", cmd->lazy_bind_size);
+            writer.numberField("export_off", cmd->export_off);
+            writer.numberField("export_size", cmd->export_size);
+            break;
+        }
+        case LC_CODE_SIGNATURE:
+        case LC_FUNCTION_STARTS:
+        case LC_DATA_IN_CODE:
+        case LC_DYLIB_CODE_SIGN_DRS:
+        case LC_LINKER_OPTIMIZATION_HINT:
+        case LC_DYLD_EXPORTS_TRIE:
+        case LC_DYLD_CHAINED_FIXUPS:
+        case LC_SEGMENT_SPLIT_INFO: {
+            struct linkedit_data_command *cmd = (struct linkedit_data_command *)lcmd;
+            writer.numberField("dataoff", cmd->dataoff);
+            writer.numberField("datasize", cmd->datasize);
+            break;
+        }
+        case LC_ENCRYPTION_INFO_64: {
+            struct encryption_info_command_64 *cmd = (struct encryption_info_command_64 *)lcmd;
+            writer.numberField("cryptoff", cmd->cryptoff);
+            writer.numberField("cryptsize", cmd->cryptsize);
+            writer.numberField("cryptid", cmd->cryptid);
+            break;
+        }
+        case LC_LINKER_OPTION: {
+            struct linker_option_command *cmd = (struct linker_option_command *)lcmd;
+            writer.key("options");
+            writer.beginArray();
+            const char *option = (char *)cmd + sizeof(struct linker_option_command);
+            const char *end = (char *)cmd + cmd->cmdsize;
+            for (int i = 0; i < cmd->count && option < end; ++i) {
+                std::string_view str(option, strnlen(option, end - option));
+                writer.string(str);
+                option += str.size() + 1;
+            }
+            writer.endArray();
+            break;
+        }
+    }
+}
+
+static void printSectionRecords(JsonWriter &writer, struct segment_command_64 *segCmd, int firstSectionIndex) {
+    int sectionIndex = firstSectionIndex;
+    for (SectionView sect : SegmentView(segCmd).sections()) {
+        sectionIndex += 1;
+        if (!showSection(sectionIndex - 1, sect.name())) {
+            continue;
+        }
+
+        beginRecord(writer, "section");
+        // section ordinal, the same as n_sect in nlist
+        writer.numberField("index", sectionIndex);
+        writer.stringField("segname", sect.segmentName());
+        writer.stringField("sectname", sect.name());
+        writer.hexField("addr", sect.address());
+        writer.numberField("size", sect.size());
+        writer.numberField("offset", sect.offset());
+        writer.numberField("align", sect.align());
+        writer.numberField("reloff", sect.raw()->reloff);
+        writer.numberField("nreloc", sect.raw()->nreloc);
+        writer.numberField("type", sect.type());
+        writer.hexField("attributes", sect.flags() & SECTION_ATTRIBUTES);
+        writer.numberField("reserved1", sect.reserved1());
+        writer.numberField("reserved2", sect.reserved2());
+        endRecord(writer);
+    }
+}
+
+static void printSymbolRecords(JsonWriter &writer, const MachoImage &image, struct symtab_command *symtabCmd) {
+    if (args.symbol != NULL) {
+        int index = image.lookupSymbolByName(args.symbol);
+        if (index >= 0) {
+            printSymbolRecord(writer, image, index);
+        }
+        return;
+    }
+
+    for (int i = 0; i < symtabCmd->nsyms; ++i) {
+        printSymbolRecord(writer, image, i);
+    }
+}
+
+static void printSymbolRecord(JsonWriter &writer, const MachoImage &image, int index) {
+    SymbolView symbol = image.getSymbols()[index];
+    const struct nlist_64 *nlist = symbol.raw();
+
+    const char *type = "STAB";
+    if ((nlist->n_type & N_STAB) == 0) {
+        switch (nlist->n_type & N_TYPE) {
+            case N_UNDF: type = "UNDF"; break;
+            case N_ABS: type = "ABS"; break;
+            case N_SECT: type = "SECT"; break;
+            case N_PBUD: type = "PBUD"; break;
+            case N_INDR: type = "INDR"; break;
+            default: type = "UNKNOWN";
+        }
+    }
+
+    beginRecord(writer, "symbol");
+    writer.numberField("index", index);
+    writer.stringField("name", symbol.name());
+    writer.stringField("type", type);
+    writer.boolField("external", nlist->n_type & N_EXT);
+    writer.boolField("private_external", nlist->n_type & N_PEXT);
+    writer.numberField("n_type", nlist->n_type);
+    writer.numberField("n_sect", nlist->n_sect);
+    writer.numberField("n_desc", nlist->n_desc);
+    writer.hexField("n_value", nlist->n_value);
+    if ((nlist->n_type & N_STAB) == 0 && (nlist->n_type & N_TYPE) == N_UNDF && GET_LIBRARY_ORDINAL(nlist->n_desc) > 0) {
+        writer.stringField("dylib", image.getDylibNameByOrdinal(GET_LIBRARY_ORDINAL(nlist->n_desc)));
+    }
+    endRecord(writer);
+}
+
+static void printFunctionStartRecords(JsonWriter &writer, const MachoImage &image) {
+    const MachoImage::FunctionStarts &functionStarts = image.getFunctionStarts();
+    for (size_t i = 0; i < functionStarts.count; ++i) {
+        uint64_t address = functionStarts.addresses[i];
+
+        beginRecord(writer, "function_start");
+        writer.hexField("address", address);
+        writer.stringField("symbol", image.symbolicateAddress(address));
+        endRecord(writer);
+    }
+}
+
+static void printChainedImportRecords(JsonWriter &writer, const MachoImage &image) {
+    ChainedImportTable imports(image);
+    for (uint32_t i = 0; i < imports.size(); ++i) {
+        ChainedImport import = imports[i];
+        beginRecord(writer, "chained_import");
+        writer.numberField("index", i);
+        writer.numberField("lib_ordinal", import.libOrdinal);
+        writer.boolField("weak_import", import.weakImport);
+        writer.stringField("name", import.name);
+        if (imports.format() != DYLD_CHAINED_IMPORT) {
+            writer.numberField("addend", import.addend);
+        }
+        endRecord(writer);
+    }
+}
+
+static void printChainedFixupRecords(JsonWriter &writer, const MachoImage &image) {
+    for (const ChainedFixupRecord &fixup : decodeChainedFixups(image, args.jobs)) {
+        beginRecord(writer, "chained_fixup");
+        writer.numberField("seg_index", fixup.segmentIndex);
+        writer.hexField("vm_offset", fixup.vmOffset);
+        writer.boolField("bind", fixup.bind);
+        if (fixup.bind) {
+            writer.numberField("import_ordinal", fixup.importOrdinal);
+            writer.numberField("lib_ordinal", fixup.libOrdinal);
+            writer.stringField("symbol", fixup.symbolName != nullptr ? fixup.symbolName : "");
+            writer.numberField("addend", fixup.addend);
+        } else {
+            writer.hexField("target", fixup.target);
+            writer.numberField("high8", fixup.high8);
+        }
+        writer.boolField("auth", fixup.auth);
+        if (fixup.auth) {
+            writer.numberField("key", fixup.key);
+            writer.boolField("addr_div", fixup.addrDiv);
+            writer.numberField("diversity", fixup.diversity);
+        }
+        endRecord(writer);
+    }
+}
+
+static void printRebaseRecords(JsonWriter &writer, const MachoImage &image, uint32_t offset, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    RebaseTable rebases = decodeRebaseTable(image, offset, size);
+    for (size_t i = 0; i < rebases.count; ++i) {
+        beginRecord(writer, "rebase");
+        writer.numberField("seg_index", rebases.segmentIndexes[i]);
+        writer.hexField("seg_offset", rebases.segmentOffsets[i]);
+        writer.hexField("address", segmentAddress(image, rebases.segmentIndexes[i]) + rebases.segmentOffsets[i]);
+        writer.numberField("type", rebases.types[i]);
+        endRecord(writer);
+    }
+}
+
+// `kind` is "regular", "lazy" or "weak", the opcode stream the binds are from.
+static void printBindRecords(JsonWriter &writer, const MachoImage &image, const char *kind, uint32_t offset, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    BindTable binds = decodeBindTable(image, offset, size);
+    for (size_t i = 0; i < binds.count; ++i) {
+        const char *symbolName = binds.symbolName(i);
+        beginRecord(writer, "bind");
+        writer.stringField("kind", kind);
+        writer.numberField("seg_index", binds.segmentIndexes[i]);
+        writer.hexField("seg_offset", binds.segmentOffsets[i]);
+        writer.hexField("address", segmentAddress(image, binds.segmentIndexes[i]) + binds.segmentOffsets[i]);
+        writer.numberField("type", binds.types[i]);
+        writer.numberField("dylib_ordinal", binds.dylibOrdinals[i]);
+        writer.stringField("symbol", symbolName != nullptr ? symbolName : "");
+        writer.numberField("flags", binds.symbolFlags[i]);
+        writer.numberField("addend", binds.addends[i]);
+        endRecord(writer);
+    }
+}
+
+static void printExportRecords(JsonWriter &writer, const MachoImage &image) {
+    forEachExport(image, [&writer](const ExportRecord &record) {
+        beginRecord(writer, "export");
+        writer.stringField("name", record.name);
+        writer.numberField("flags", record.flags);
+        if (record.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+            writer.numberField("dylib_ordinal", record.dylibOrdinal);
+            writer.stringField("import_name", record.importName != nullptr ? record.importName : "");
+        } else {
+            writer.hexField("address", record.address);
+            if (record.flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+                writer.hexField("resolver", record.resolver);
+            }
+        }
+        endRecord(writer);
+    });
+}
+
+static uint64_t segmentAddress(const MachoImage &image, int segmentIndex) {
+    if (segmentIndex < 0 || segmentIndex >= image.segmentCommands.size()) {
+        return 0;
+    }
+    return image.segmentCommands[segmentIndex]->vmaddr;
+}
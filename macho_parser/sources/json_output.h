@@ -0,0 +1,41 @@
+#ifndef JSON_OUTPUT_H
+#define JSON_OUTPUT_H
+
+#include <stdio.h>
+
+#include "core/macho_image.h"
+#include "utils/utils.h"
+
+// Structured output for --format=json and --format=ndjson.
+//
+// An image is written as a stream of flat records, each of which is a JSON object with a "record" field
+// ("header", "load_command", "section", "symbol", ...). With ndjson every record is on its own line.
+// With json the records are the elements of one top-level array. Records are written as they are produced,
+// so memory use doesn't depend on the size of the binary.
+// The same options that select what the text output shows (--command, -v, --symbol, ...) select the records.
+
+// A JsonWriter over a buffered `file`. With json the top-level array is opened by the constructor
+// and closed by the destructor.
+// A continuation writes records that are appended to the output of another JsonOutput later,
+// like the members of an archive that are rendered in parallel. It never opens or closes the array.
+class JsonOutput {
+public:
+    explicit JsonOutput(FILE *file, bool continuation = false);
+    ~JsonOutput();
+
+    JsonWriter &writer() { return jsonWriter; }
+
+private:
+    OutputBuffer buffer;
+    JsonWriter jsonWriter;
+    bool continuation;
+};
+
+// Start an archive member. The records of the member's image follow.
+void printJsonMember(JsonWriter &writer, const char *name);
+
+// Write the records of an image. If a table is malformed, the records before it are kept
+// and the error is thrown, so the caller reports it and exits with a nonzero status as the text output does.
+void printJsonImage(JsonWriter &writer, const MachoImage &image);
+
+#endif /* JSON_OUTPUT_H */
@@ -1,37 +1,35 @@
 #include <string.h>
 
 #include "utils/utils.h"
-#include "load_command.h"
+#include "core/macho_image.h"
 #include "argument.h"
 #include "exports_trie.h"
 #include "symtab.h"
+#include "chained_fixups.h"
 
 // code_signature.cpp
-void printCodeSignature(uint8_t *base, uint32_t dataoff, uint32_t datasize);
-
-// chained_fixups.cpp
-void printChainedFixups(uint8_t *base, uint32_t dataoff, uint32_t datasize);
+void printCodeSignature(const MachoImage &image);
 
 static std::string formatCommandName(uint32_t cmd);
-static void printFunctionStarts(uint8_t *base, uint32_t dataoff, uint32_t datasize);
+static void printFunctionStarts(const MachoImage &image);
 
-void printLinkEditData(uint8_t *base, struct linkedit_data_command *linkEditDataCmd) {
-    printf("%-20s cmdsize: %-6u dataoff: 0x%x (%d)   datasize: %d\n",
+void printLinkEditData(const MachoImage &image, struct linkedit_data_command *linkEditDataCmd) {
+    fprintf(textOutput(), "%-20s cmdsize: %-6u dataoff: 0x%x (%d)   datasize: %d\n",
         formatCommandName(linkEditDataCmd->cmd).c_str(), linkEditDataCmd->cmdsize,
         linkEditDataCmd->dataoff, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
 
     if (args.verbosity == 0) { return; }
 
     if (linkEditDataCmd->cmd == LC_FUNCTION_STARTS) {
-        printFunctionStarts(base, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
+        printFunctionStarts(image);
     } else if (linkEditDataCmd->cmd == LC_DYLD_CHAINED_FIXUPS) {
-        printChainedFixups(base, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
+        printChainedFixups(image);
     } else if (linkEditDataCmd->cmd == LC_DYLD_EXPORTS_TRIE) {
-        printExportTrie(base, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
+        printExportTrie(image, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
     } else if (linkEditDataCmd->cmd == LC_CODE_SIGNATURE) {
-        printCodeSignature(base, linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
+        printCodeSignature(image);
     } else {
-        hexdump(linkEditDataCmd->dataoff, base + linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
+        hexdump(linkEditDataCmd->dataoff, image.base + linkEditDataCmd->dataoff, linkEditDataCmd->datasize);
     }
 }
 
@@ -45,46 +43,23 @@ static std::string formatCommandName(uint32_t cmd) {
     case LC_LINKER_OPTIMIZATION_HINT: return "LC_LINKER_OPTIMIZATION_HINT";
     case LC_DYLD_EXPORTS_TRIE: return "LC_DYLD_EXPORTS_TRIE";
     case LC_DYLD_CHAINED_FIXUPS: return "LC_DYLD_CHAINED_FIXUPS";
-#if __clang_major__ >= 15
     case LC_ATOM_INFO: return "LC_ATOM_INFO";
-#endif
     default: return "UNKNOWN";
     }
 }
 
-static bool textSegmentLoadCommand(struct load_command *lcmd) {
-    return lcmd->cmd == LC_SEGMENT_64 && strcmp(((struct segment_command_64 *)lcmd)->segname, "__TEXT") == 0;
-}
-
-static bool symtabLoadCommand(struct load_command *lcmd) {
-    return lcmd->cmd == LC_SYMTAB;
-}
-
-static void printFunctionStarts(uint8_t *base, uint32_t dataoff, uint32_t datasize) {
+static void printFunctionStarts(const MachoImage &image) {
     if (!args.verbosity) { return; }
 
-    struct segment_command_64 *text_segment = (struct segment_command_64 *)search_load_command(base, 0, textSegmentLoadCommand).lcmd;
-    struct symtab_command *symtab_cmd = (struct symtab_command *)search_load_command(base, 0, symtabLoadCommand).lcmd;
-
-    uint8_t *func_starts = base + dataoff;
-
-    int i = 0;
-    uint64_t address = text_segment->vmaddr;
-    int count = 0;
-    while(func_starts[i] != 0 && i < datasize) {
-        if (count > 10 && !args.no_truncate) {
-            printf("    ... more ...\n");
+    const MachoImage::FunctionStarts &functionStarts = image.getFunctionStarts();
+    for (size_t i = 0; i < functionStarts.count; ++i) {
+        if (i > 10 && !args.no_truncate) {
+            fprintf(textOutput(), "    ... more ...\n");
             break;
         }
 
-        uint64_t num = 0;
-        i += readULEB128(func_starts + i, &num);
-        address += num;
-
-        char *symbol = lookup_symbol_by_address(address, base, symtab_cmd);
-        printf("  %#llx  %s\n", address, symbol);
-
-        count++;
+        uint64_t address = functionStarts.addresses[i];
+        fprintf(textOutput(), "  %#llx  %s\n", address, image.symbolicateAddress(address).c_str());
     }
 }
 
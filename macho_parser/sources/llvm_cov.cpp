@@ -1,7 +1,9 @@
 #include <stdio.h>
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
 
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "utils/utils.h"
@@ -10,187 +12,168 @@
 
 // BEGIN __llvm_covmap
 
-static size_t printCovMapHeader(uint8_t *covMapBase);
-static size_t printFilenamesRegion(uint8_t *filenamesBase);
-static void printFilenames(uint8_t *uncompressedFileNames, int numFilenames);
+static void printCovMapHeader(DataCursor &covMap);
+static void printFilenamesRegion(DataCursor &covMap);
+static void printFilenames(DataCursor filenames, uint64_t numFilenames);
+static std::vector<uint8_t> readMaybeCompressed(DataCursor &cursor, uint64_t uncompressedSize, uint64_t compressedSize);
+static void alignTo8Bytes(DataCursor &cursor);
 
 void printCovMapSection(uint8_t *sectBase, size_t sectSize) {
+    DataCursor covMap(sectBase, sectSize);
     int index = 0;
-    size_t offset = 0;
-    while (offset < sectSize) {
-        std::cout << "  === " << index++ << " ===" << std::endl;
-        offset += printCovMapHeader(sectBase + offset);
-        offset += printFilenamesRegion(sectBase + offset);
-        std::cout << std::endl;
+    while (!covMap.atEnd()) {
+        fprintf(textOutput(), "  === %d ===\n", index++);
+        printCovMapHeader(covMap);
+        printFilenamesRegion(covMap);
+        fprintf(textOutput(), "\n");
+
+        // Each coverage map has an alignment of 8 bytes
+        alignTo8Bytes(covMap);
     }
 }
 
 // https://github.com/apple/llvm-project/blob/4305e61a0d81cc071a88090fa8579440c2220e07/llvm/include/llvm/ProfileData/Coverage/CoverageMapping.h#L990-L1007
-static size_t printCovMapHeader(uint8_t *covMapBase) {
-    uint32_t * header = (uint32_t *)covMapBase;
+static void printCovMapHeader(DataCursor &covMap) {
+    uint32_t header[4];
+    for (uint32_t &field : header) {
+        field = covMap.read<uint32_t>();
+    }
     // https://github.com/apple/llvm-project/blob/4305e61a0d81cc071a88090fa8579440c2220e07/llvm/include/llvm/ProfileData/Coverage/CoverageMapping.h#L1011-L1029
     uint32_t version = header[3] + 1;
-    printf("  CovMap Header: (NRecords: %d, FilenamesSize: %d, CoverageSize: %d, Version: %d)\n", header[0], header[1], header[2], version);
+    fprintf(textOutput(), "  CovMap Header: (NRecords: %d, FilenamesSize: %d, CoverageSize: %d, Version: %d)\n", header[0], header[1], header[2], version);
 
     if (version < 4) {
-        std::cerr << "Coverage map version lower than 4 is not supported." << std::endl;
-        exit(1);
+        throw std::runtime_error("Coverage map version lower than 4 is not supported.");
     }
-
-    return 4 * 4; // CovMap header size
 }
 
-static size_t printFilenamesRegion(uint8_t *filenamesBase) {
-    uint64_t numFilenames = 0;
-    uint64_t uncompressedLength = 0;
-    uint64_t compressedLength = 0;
+static void printFilenamesRegion(DataCursor &covMap) {
+    uint64_t numFilenames = covMap.readULEB128();
+    uint64_t uncompressedLength = covMap.readULEB128();
+    uint64_t compressedLength = covMap.readULEB128();
 
-    size_t offset = 0;
+    fprintf(textOutput(), "  Filenames: (NFilenames: %llu, UncompressedLen: %llu, CompressedLen: %llu)\n", numFilenames, uncompressedLength, compressedLength);
 
-    offset += readULEB128(filenamesBase + offset, &numFilenames);
-    offset += readULEB128(filenamesBase + offset, &uncompressedLength);
-    offset += readULEB128(filenamesBase + offset, &compressedLength);
+    std::vector<uint8_t> filenames = readMaybeCompressed(covMap, uncompressedLength, compressedLength);
+    printFilenames(DataCursor(filenames.data(), filenames.size()), numFilenames);
+}
 
-    printf("  Filenames: (NFilenames: %llu, UncompressedLen: %llu, CompressedLen: %llu)\n", numFilenames, uncompressedLength, compressedLength);
+static void printFilenames(DataCursor filenames, uint64_t numFilenames) {
+    for (uint64_t i = 0; i < numFilenames; i++) {
+        uint64_t filenameLength = filenames.readULEB128();
+        const uint8_t *filename = filenames.readBytes(filenameLength);
 
-    uint8_t *uncompressedData = (uint8_t *)malloc(uncompressedLength);;
-    if (compressedLength > 0) {
-        decompressZlibData(filenamesBase + offset, compressedLength, uncompressedData, uncompressedLength);
-        offset += compressedLength;
-    } else {
-        memcpy(uncompressedData, filenamesBase + offset, uncompressedLength);
-        offset += uncompressedLength;
+        fprintf(textOutput(), "    %2d: %.*s\n", (int)i, (int)filenameLength, filename);
     }
+}
 
-    printFilenames(uncompressedData, numFilenames);
-
-    free(uncompressedData);
+// Read the data that is zlib compressed if `compressedSize` isn't 0.
+static std::vector<uint8_t> readMaybeCompressed(DataCursor &cursor, uint64_t uncompressedSize, uint64_t compressedSize) {
+    if (compressedSize > 0) {
+        // The sizes are untrusted, so let the stream tell how much it decompresses to.
+        return decompressZlibData(cursor.readBytes(compressedSize), compressedSize);
+    }
 
-    // Each coverage map has an alignment of 8 bytes
-    return (offset + 7) / 8 * 8;
+    const uint8_t *data = cursor.readBytes(uncompressedSize);
+    return std::vector<uint8_t>(data, data + uncompressedSize);
 }
 
-static void printFilenames(uint8_t *uncompressedFileNames, int numFilenames) {
-    int offset = 0;
-    for (int i = 0; i < numFilenames; i++) {
-        uint64_t filenameLength = 0;
-        offset += readULEB128(uncompressedFileNames + offset, &filenameLength);
-
-        printf("    %2d: %.*s\n", i, (int)filenameLength, uncompressedFileNames + offset);
-        offset += filenameLength;
-    }
+static void alignTo8Bytes(DataCursor &cursor) {
+    cursor.seek(std::min<uint64_t>((cursor.offset() + 7) / 8 * 8, cursor.size()));
 }
 
 // END __llvm_covmap
 
 // BEGIN __llvm_covfun
 
-static void printFunctionEncoding(uint8_t *funcEncodingBase);
-static size_t printFileIDMapping(uint8_t *fileIDMappingBase, int *numFiles);
-static size_t parseCounterExpressions(uint8_t *counterExpressionBase, std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions);
-static size_t printMappingRegions(uint8_t *mappingRegionBase, int numFiles, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions);
-static std::string formatCounter(uint64_t counter, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions);
+static void printFunctionEncoding(DataCursor funcEncoding);
+static int printFileIDMapping(DataCursor &funcEncoding);
+static void parseCounterExpressions(DataCursor &funcEncoding, std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions);
+static void printMappingRegions(DataCursor &funcEncoding, int numFiles, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions);
+static std::string formatCounter(uint64_t counter, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions, size_t depth = 0);
 
 void printCovFunSection(uint8_t *sectBase, size_t sectSize) {
+    DataCursor covFun(sectBase, sectSize);
     int index = 0;
-    size_t offset = 0;
-    while (offset < sectSize) {
+    while (!covFun.atEnd()) {
         // The hashes here are the lower 64 bits of the MD5 hash
-        int64_t funcNameHash = *(int64_t *)(sectBase + offset);
-        offset += sizeof(int64_t);
-        int32_t dataLen = *(int32_t *)(sectBase + offset);
-        offset += sizeof(int32_t);
-        int64_t funcHash = *(int64_t *)(sectBase + offset);
-        offset += sizeof(int64_t);
-        int64_t fileNameHash = *(int64_t *)(sectBase + offset);
-        offset += sizeof(int64_t);
-
-        printf("%d: FuncNameHash: 0x%llx, DataLen: %d, FuncHash: 0x%llx, FileNameHash: 0x%llx\n", index++, funcNameHash, dataLen, funcHash, fileNameHash);
-        printFunctionEncoding(sectBase + offset);
-
-        offset += dataLen;
-        offset = (offset + 7) / 8 * 8; // align to 8 bytes
+        int64_t funcNameHash = covFun.read<int64_t>();
+        int32_t dataLen = covFun.read<int32_t>();
+        int64_t funcHash = covFun.read<int64_t>();
+        int64_t fileNameHash = covFun.read<int64_t>();
+
+        fprintf(textOutput(), "%d: FuncNameHash: 0x%llx, DataLen: %d, FuncHash: 0x%llx, FileNameHash: 0x%llx\n", index++, funcNameHash, dataLen, funcHash, fileNameHash);
+        printFunctionEncoding(covFun.subrange(covFun.offset(), (uint32_t)dataLen));
+
+        covFun.skip((uint32_t)dataLen);
+        alignTo8Bytes(covFun);
     }
 }
 
-static void printFunctionEncoding(uint8_t *funcEncodingBase) {
+static void printFunctionEncoding(DataCursor funcEncoding) {
     std::vector<std::pair<uint64_t, uint64_t>> counterExpressions;
-    int numFiles = 0;
-    size_t offset = printFileIDMapping(funcEncodingBase, &numFiles);
-    offset += parseCounterExpressions(funcEncodingBase + offset, counterExpressions);
-    offset += printMappingRegions(funcEncodingBase + offset, numFiles, counterExpressions);
+    int numFiles = printFileIDMapping(funcEncoding);
+    parseCounterExpressions(funcEncoding, counterExpressions);
+    printMappingRegions(funcEncoding, numFiles, counterExpressions);
 }
 
-static size_t printFileIDMapping(uint8_t *fileIDMappingBase, int *numFiles) {
-    uint64_t numIndices = 0;
-    size_t offset = readULEB128(fileIDMappingBase, &numIndices);
+static int printFileIDMapping(DataCursor &funcEncoding) {
+    uint64_t numIndices = funcEncoding.readULEB128();
 
-    printf("    FileIDMapping: (NFiles: %llu)\n", numIndices);
+    fprintf(textOutput(), "    FileIDMapping: (NFiles: %llu)\n", numIndices);
 
-    for (int i = 0; i < numIndices; i++) {
-        uint64_t filenameIndex = 0;
-        offset += readULEB128(fileIDMappingBase + offset, &filenameIndex);
+    for (uint64_t i = 0; i < numIndices; i++) {
+        uint64_t filenameIndex = funcEncoding.readULEB128();
 
-        printf("     %2d: %llu\n", i, filenameIndex);
+        fprintf(textOutput(), "     %2d: %llu\n", (int)i, filenameIndex);
     }
 
-    *numFiles = numIndices;
-    return offset;
+    return numIndices;
 }
 
-// Parse counter expressions into a vector of pairs of (LHS, RHS) and return the bytes that have been processed
-static size_t parseCounterExpressions(uint8_t *counterExpressionBase, std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions) {
-    uint64_t numExpressions = 0;
-    size_t offset = readULEB128(counterExpressionBase, &numExpressions);
+// Parse counter expressions into a vector of pairs of (LHS, RHS)
+static void parseCounterExpressions(DataCursor &funcEncoding, std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions) {
+    uint64_t numExpressions = funcEncoding.readULEB128();
 
-    for (int i = 0; i < numExpressions; i++) {
-        uint64_t exprLHS = 0, exprRHS = 0;
-        offset += readULEB128(counterExpressionBase + offset, &exprLHS);
-        offset += readULEB128(counterExpressionBase + offset, &exprRHS);
+    for (uint64_t i = 0; i < numExpressions; i++) {
+        uint64_t exprLHS = funcEncoding.readULEB128();
+        uint64_t exprRHS = funcEncoding.readULEB128();
 
         counterExpressions.push_back(std::make_pair(exprLHS, exprRHS));
     }
-
-    return offset;
 }
 
-static size_t printMappingRegions(uint8_t *mappingRegionBase, int numFiles, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions) {
-    size_t offset = 0;
-
-    printf("    MappingRegions: (NRegionArrays: %d)\n", numFiles);
+static void printMappingRegions(DataCursor &funcEncoding, int numFiles, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions) {
+    fprintf(textOutput(), "    MappingRegions: (NRegionArrays: %d)\n", numFiles);
 
     for (int i = 0; i < numFiles; i++) {
-        uint64_t numRegions = 0;
-        offset += readULEB128(mappingRegionBase + offset, &numRegions);
+        uint64_t numRegions = funcEncoding.readULEB128();
 
-        printf("     %2d: (NRegions: %llu)\n", i, numRegions);
+        fprintf(textOutput(), "     %2d: (NRegions: %llu)\n", i, numRegions);
 
         int prevLinStart = 0;
-        for (int j = 0; j < numRegions; j++) {
-            uint64_t counter = 0;
-            offset += readULEB128(mappingRegionBase + offset, &counter);
+        for (uint64_t j = 0; j < numRegions; j++) {
+            uint64_t counter = funcEncoding.readULEB128();
 
-            uint64_t deltaLineStart = 0, columnStart = 0, numLines = 0, columnEnd = 0;
-            offset += readULEB128(mappingRegionBase + offset, &deltaLineStart);
-            offset += readULEB128(mappingRegionBase + offset, &columnStart);
-            offset += readULEB128(mappingRegionBase + offset, &numLines);
-            offset += readULEB128(mappingRegionBase + offset, &columnEnd);
+            uint64_t deltaLineStart = funcEncoding.readULEB128();
+            uint64_t columnStart = funcEncoding.readULEB128();
+            uint64_t numLines = funcEncoding.readULEB128();
+            uint64_t columnEnd = funcEncoding.readULEB128();
 
             int lineStart = (j == 0 ? deltaLineStart : prevLinStart + deltaLineStart);
 
             // Map region to counter
-            printf("         %d: %d:%llu => %llu:%llu : ", j, lineStart, columnStart, lineStart + numLines, columnEnd);
-            std::cout << formatCounter(counter, counterExpressions) << std::endl;
+            fprintf(textOutput(), "         %d: %d:%llu => %llu:%llu : ", (int)j, lineStart, columnStart, lineStart + numLines, columnEnd);
+            fprintf(textOutput(), "%s\n", formatCounter(counter, counterExpressions).c_str());
 
             prevLinStart = lineStart;
         }
     }
-
-    return offset;
 }
 
 // Format the counter into a string.
-static std::string formatCounter(uint64_t counter, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions) {
+// An expression can't refer to itself, even indirectly, so `depth` can't exceed the number of expressions.
+static std::string formatCounter(uint64_t counter, const std::vector<std::pair<uint64_t, uint64_t>> &counterExpressions, size_t depth) {
     std::string result = "";
 
     // The lower 2 bits of the counter are used to encode the tag of the counter.
@@ -225,13 +208,16 @@ static std::string formatCounter(uint64_t counter, const std::vector<std::pair<u
         result += std::to_string(counterIndex);
     } else {
         // The counter is a subtraction or addition expression.
+        if (counterIndex >= counterExpressions.size() || depth >= counterExpressions.size()) {
+            throw std::runtime_error("Coverage counter expression " + std::to_string(counterIndex) + " is invalid");
+        }
         std::pair<uint64_t, uint64_t> expression = counterExpressions[counterIndex];
         uint64_t lhs = expression.first;
         uint64_t rhs = expression.second;
         result += "(";
-        result += formatCounter(lhs, counterExpressions);
+        result += formatCounter(lhs, counterExpressions, depth + 1);
         result += tag == 2 ? " - " : " + ";
-        result += formatCounter(rhs, counterExpressions);
+        result += formatCounter(rhs, counterExpressions, depth + 1);
         result += ")";
     }
 
@@ -244,32 +230,21 @@ static std::string formatCounter(uint64_t counter, const std::vector<std::pair<u
 std::vector<std::string> splitString(const std::string& input, char delimiter);
 
 void printPrfNamesSection(uint8_t *sectBase, size_t sectSize) {
+    DataCursor prfNames(sectBase, sectSize);
     int index = 0;
-    size_t offset = 0;
-    while (offset < sectSize) {
-        uint64_t uncompressedSize = 0;
-        offset += readULEB128(sectBase + offset, &uncompressedSize);
-
-        uint64_t compressedSize = 0;
-        offset += readULEB128(sectBase + offset, &compressedSize);
-
-        uint8_t *uncompressedData = (uint8_t *)malloc(uncompressedSize);;
-        if (compressedSize > 0) {
-            decompressZlibData(sectBase + offset, compressedSize, uncompressedData, uncompressedSize);
-            offset += compressedSize;
-        } else {
-            memcpy(uncompressedData, sectBase + offset, uncompressedSize);
-            offset += uncompressedSize;
-        }
+    while (!prfNames.atEnd()) {
+        uint64_t uncompressedSize = prfNames.readULEB128();
+        uint64_t compressedSize = prfNames.readULEB128();
+        std::vector<uint8_t> uncompressedData = readMaybeCompressed(prfNames, uncompressedSize, compressedSize);
 
-        std::cout << "  === " << index++ << " ===" << std::endl;
+        fprintf(textOutput(), "  === %d ===\n", index++);
 
-        auto names = splitString((char *)uncompressedData, '\1');
+        // The names aren't null-terminated, so they are split within the size of the data.
+        std::string joinedNames((const char *)uncompressedData.data(), uncompressedData.size());
+        auto names = splitString(joinedNames.c_str(), '\1');
         for (auto name : names) {
-            std::cout << "  " << name << std::endl;
+            fprintf(textOutput(), "  %s\n", name.c_str());
         }
-
-        free(uncompressedData);
     }
 }
 
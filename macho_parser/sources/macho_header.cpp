@@ -1,70 +1,57 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
-#include <mach-o/fat.h>
-#include <mach-o/swap.h>
 #include <string>
 #include <iomanip>
 #include <sstream>
 #include <vector>
 #include <map>
 #include <cmath>
-#include <cassert>
 
 #include "argument.h"
+#include "core/fat_macho.h"
+#include "utils/utils.h"
 
 #include "macho_header.h"
 
-#define NEEDS_SWAP(magic) (magic == FAT_CIGAM || magic == FAT_CIGAM_64 || magic == MH_CIGAM || magic == MH_CIGAM_64)
-
 static uint32_t readMagic(uint8_t *base, int offset);
-static struct fat_header readFatHeader(uint8_t *base, bool needs_swap);
-static struct fat_arch *readFatArchs(uint8_t *base, struct fat_header header, bool needs_swap);
 static struct mach_header_64 readMachHeader(uint8_t *base, uint64_t offset);
 
 static void printFatHeader(uint32_t magic, struct fat_header header);
-static void printFatArchs(struct fat_arch *archs, int nfat_arch);
+static void printFatArchs(const std::vector<struct fat_arch_64> &archs);
 static void printMachHeader(struct mach_header_64 header);
 
 static std::string stringifyMagic(uint32_t magic);
-static std::string stringifyCPUType(cpu_type_t cputype);
 static std::string stringifyCPUSubType(cpu_type_t cputype,  cpu_subtype_t cpusubtype);
-static std::string stringifyFileType(uint32_t filetype);
 static std::string stringifyHeaderFlags(uint32_t flags);
 
-bool FatMacho::isFatMacho(uint8_t *fileBase, size_t fileSize) {
-    if (fileSize < 4) return false;
-    uint32_t magic = readMagic(fileBase, 0);
-    return (magic == FAT_MAGIC || magic == FAT_CIGAM);
-}
-
-std::tuple<uint8_t*, uint32_t> FatMacho::getSliceByArch(uint8_t *fileBase, size_t fileSize, char *arch) {
-    assert(isFatMacho(fileBase, fileSize));
-
+std::tuple<uint8_t*, uint64_t> FatMacho::getSliceByArch(uint8_t *fileBase, uint64_t fileSize, char *arch) {
     uint32_t magic = readMagic(fileBase, 0);
     const char *cpuType;
-    uint32_t sliceOffset = 0;
-    uint32_t sliceSize = 0;
+    uint64_t sliceOffset = 0;
+    uint64_t sliceSize = 0;
 
-    struct fat_header header = readFatHeader(fileBase, NEEDS_SWAP(magic));
-    struct fat_arch *fat_archs = readFatArchs(fileBase, header, NEEDS_SWAP(magic));
+    struct fat_header header;
+    std::vector<struct fat_arch_64> fat_archs;
+    if (!readFatArchs(fileBase, fileSize, header, fat_archs)) {
+        fprintf (stderr, "The fat header is truncated.\n");
+        exit(1);
+    }
 
     if (showHeader()) {
         printFatHeader(magic, header);
-        printFatArchs(fat_archs, header.nfat_arch);
+        printFatArchs(fat_archs);
     }
 
-    for (int i = 0; i < header.nfat_arch; ++i) {
-        cpuType = stringifyCPUType(fat_archs[i].cputype).c_str();
-        if ((fat_archs[i].cputype & CPU_ARCH_ABI64) && isSelectedArch(cpuType)) {
-            sliceOffset = fat_archs[i].offset;
-            sliceSize = fat_archs[i].size;
+    for (const struct fat_arch_64 &fat_arch : fat_archs) {
+        cpuType = stringifyCPUType(fat_arch.cputype).c_str();
+        if ((fat_arch.cputype & CPU_ARCH_ABI64) && isSelectedArch(cpuType)) {
+            sliceOffset = fat_arch.offset;
+            sliceSize = fat_arch.size;
             break;
         }
     }
 
-    free(fat_archs);
-
     if (sliceOffset == 0) {
         if (args.arch != NULL) {
             fprintf (stderr, "The binary doesn't contain %s architecture.\n", args.arch);
@@ -77,24 +64,33 @@ std::tuple<uint8_t*, uint32_t> FatMacho::getSliceByArch(uint8_t *fileBase, size_
     return std::make_tuple(fileBase + sliceOffset, sliceSize);
 }
 
-struct mach_header_64 *parseMachHeader(uint8_t *base) {
-    uint32_t magic = readMagic(base, 0);
-    const char *cpuType;
+std::string checkMachHeader(uint8_t *base, uint64_t size) {
+    if (size < sizeof(struct mach_header_64)) {
+        return "The file is too small to be a 64-bit Mach-O binary.";
+    }
 
+    uint32_t magic = readMagic(base, 0);
     if (magic != MH_MAGIC_64) {
-        fprintf (stderr, "Magic %s is not recognized or supported. It may not be a Mach-O binary.\n", stringifyMagic(magic).c_str());
-        exit(1);
+        return "Magic " + stringifyMagic(magic) + " is not recognized or supported. It may not be a Mach-O binary.";
     }
 
     struct mach_header_64 header = readMachHeader(base, 0);
-    cpuType = stringifyCPUType(header.cputype).c_str();
-    if (!isSelectedArch(cpuType)) {
-        fprintf (stderr, "The binary doesn't contain %s architecture.\n", args.arch);
+    if (!isSelectedArch(stringifyCPUType(header.cputype).c_str())) {
+        return std::string("The binary doesn't contain ") + args.arch + " architecture.";
+    }
+
+    return "";
+}
+
+struct mach_header_64 *parseMachHeader(uint8_t *base, uint64_t size) {
+    std::string error = checkMachHeader(base, size);
+    if (!error.empty()) {
+        fprintf (stderr, "%s\n", error.c_str());
         exit(1);
     }
 
     if (showHeader()) {
-        printMachHeader(header);
+        printMachHeader(readMachHeader(base, 0));
     }
 
     return (struct mach_header_64 *)base;
@@ -105,45 +101,20 @@ static uint32_t readMagic(uint8_t *filebase, int offset) {
     return magic;
 }
 
-static struct fat_header readFatHeader(uint8_t *base, bool needs_swap) {
-    struct fat_header header = *(struct fat_header *)base;
-    if (needs_swap) {
-        #pragma clang diagnostic push
-        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-        swap_fat_header(&header, NX_UnknownByteOrder);
-        #pragma clang diagnostic pop
-    }
-    return header;
-}
-
-static struct fat_arch *readFatArchs(uint8_t *base, struct fat_header header, bool needs_swap) {
-    size_t archs_size = sizeof(struct fat_arch) * header.nfat_arch;
-    struct fat_arch *archs = (struct fat_arch *)malloc(archs_size);
-    memcpy(archs, base + sizeof(header), archs_size);
-
-    if (needs_swap) {
-        #pragma clang diagnostic push
-        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-        swap_fat_arch(archs, header.nfat_arch, NX_UnknownByteOrder);
-        #pragma clang diagnostic pop
-    }
-    return archs;
-}
-
 static struct mach_header_64 readMachHeader(uint8_t *base, uint64_t offset) {
     struct mach_header_64 header = *(struct mach_header_64 *)(base + offset);
     return header;
 }
 
 static void printFatHeader(uint32_t magic, struct fat_header header) {
-    printf("%-20s magic: %s   nfat_arch: %d\n", "FAT_HEADER", stringifyMagic(magic).c_str(), header.nfat_arch);
+    fprintf(textOutput(), "%-20s magic: %s   nfat_arch: %d\n", "FAT_HEADER", stringifyMagic(magic).c_str(), header.nfat_arch);
 }
 
-static void printFatArchs(struct fat_arch *archs, int nfat_arch) {
-    for (int i = 0; i < nfat_arch; ++i) {
-        struct fat_arch arch = archs[i];
+static void printFatArchs(const std::vector<struct fat_arch_64> &archs) {
+    for (int i = 0; i < (int)archs.size(); ++i) {
+        const struct fat_arch_64 &arch = archs[i];
 
-        printf("#%d: cputype: %-10s cpusubtype: %-8s offset: %-8d size: %-8d align: %#-10x\n",
+        fprintf(textOutput(), "#%d: cputype: %-10s cpusubtype: %-8s offset: %-8llu size: %-8llu align: %#-10x\n",
             i,
             stringifyCPUType(arch.cputype).c_str(),
             stringifyCPUSubType(arch.cputype, arch.cpusubtype).c_str(),
@@ -151,11 +122,11 @@ static void printFatArchs(struct fat_arch *archs, int nfat_arch) {
             arch.size,
             (uint32_t)pow(2, arch.align));
     }
-    printf("\n");
+    fprintf(textOutput(), "\n");
 }
 
 static void printMachHeader(struct mach_header_64 header) {
-    printf("%-20s magic: %s   cputype: %s   cpusubtype: %s   filetype: %s   ncmds: %d   sizeofcmds: %d   \n%-20s flags: %s\n",
+    fprintf(textOutput(), "%-20s magic: %s   cputype: %s   cpusubtype: %s   filetype: %s   ncmds: %d   sizeofcmds: %d   \n%-20s flags: %s\n",
         "MACHO_HEADER",
         stringifyMagic(header.magic).c_str(),
         stringifyCPUType(header.cputype).c_str(),
@@ -185,7 +156,7 @@ static std::string stringifyMagic(uint32_t magic) {
     }
 }
 
-static std::string stringifyCPUType(cpu_type_t cputype) {
+std::string stringifyCPUType(cpu_type_t cputype) {
     switch (cputype) {
         case CPU_TYPE_X86:      return std::string("X86");
         case CPU_TYPE_X86_64:   return std::string("X86_64");
@@ -219,7 +190,7 @@ static std::string stringifyCPUSubType(cpu_type_t cputype,  cpu_subtype_t cpusub
 }
 
 
-static std::string stringifyFileType(uint32_t filetype) {
+std::string stringifyFileType(uint32_t filetype) {
     switch (filetype) {
         case MH_OBJECT:     return std::string("OBJECT");
         case MH_EXECUTE:    return std::string("EXECUTE");
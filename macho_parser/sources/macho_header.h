@@ -1,14 +1,25 @@
 #ifndef MACHO_HEADER_H
 #define MACHO_HEADER_H
 
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
+#include <string>
 #include <tuple>
 
+#include "core/fat_macho.h"
+
 namespace FatMacho {
-bool isFatMacho(uint8_t *fileBase, size_t fileSize);
-std::tuple<uint8_t*, uint32_t> getSliceByArch(uint8_t *fileBase, size_t fileSize, char *arch);
+// Print the fat header unless it's excluded by the options, and return the slice of the selected architecture.
+// Exit if there is no such slice.
+std::tuple<uint8_t*, uint64_t> getSliceByArch(uint8_t *fileBase, uint64_t fileSize, char *arch);
 }
 
-struct mach_header_64 *parseMachHeader(uint8_t *base);
+// Return why `base` isn't a 64-bit Mach-O header of the selected architecture, or an empty string if it is one.
+std::string checkMachHeader(uint8_t *base, uint64_t size);
+
+// Print the header unless it's excluded by the options. Exit with the error of checkMachHeader() if it has one.
+struct mach_header_64 *parseMachHeader(uint8_t *base, uint64_t size);
+
+std::string stringifyCPUType(cpu_type_t cputype);
+std::string stringifyFileType(uint32_t filetype);
 
 #endif /* MACHO_HEADER_H */
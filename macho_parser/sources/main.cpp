@@ -2,109 +2,305 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <mach-o/loader.h>
-#include <mach-o/nlist.h>
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include <ar.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "argument.h"
 #include "symtab.h"
 
 #include "macho_header.h"
-#include "macho_binary.h"
-#include "load_command.h"
+#include "core/macho_image.h"
+#include "core/load_command.h"
 #include "small_cmds.h"
-#include "ar_parser.h"
+#include "core/ar_parser.h"
+#include "dyld_info.h"
+#include "json_output.h"
+#include "columnar_export.h"
+#include "exports_trie.h"
+#include "core/image_cache.h"
 
 // dylib.cpp
 void printDylib(const uint8_t *base, const struct dylib_command *cmd);
 
 // segment_64.cpp
-void printSegment(uint8_t *base, struct segment_command_64 *segCmd, int firstSectionIndex);
+void printSegment(const MachoImage &image, struct segment_command_64 *segCmd, int firstSectionIndex);
 
 // linkedit_data.cpp
-void printLinkEditData(uint8_t *base, struct linkedit_data_command *linkEditDataCmd);
+void printLinkEditData(const MachoImage &image, struct linkedit_data_command *linkEditDataCmd);
 
 // dysymtab.cpp
-void printDynamicSymbolTable(uint8_t *base, struct dysymtab_command *dysymtabCmd);
+void printDynamicSymbolTable(const MachoImage &image, struct dysymtab_command *dysymtabCmd);
 
 // build_version.cpp
 void printBuildVersion(const uint8_t *base, const struct build_version_command *buildVersionCmd);
 void printVersionMin(const uint8_t *base, const struct version_min_command *versionMinCmd);
 
-// dyld_info.cpp
-void printDyldInfo(uint8_t *base, struct dyld_info_command *dyldInfoCmd);
-
 // encryption_info.cpp
 void printEncryptionInfo(uint8_t *base, struct encryption_info_command_64 *cmd);
 
-static void printMacho(uint8_t *machoBase);
-static void printLoadCommands(uint8_t *base, std::vector<struct load_command *> allLoadCommands);
+// batch.cpp
+int runBatch(const char *path);
 
-struct MachoBinary machoBinary;
+static void printMacho(JsonWriter *json, uint8_t *machoBase, uint64_t machoSize);
+static void printArchive(JsonWriter *json, uint8_t *archiveBase, uint64_t archiveSize);
+static void findSymbolInArchive(JsonWriter *json, MappedFile &file, const char *symbol);
+static uint8_t *mapFileRange(MappedFile &file, uint64_t offset, uint64_t size);
+static void printLoadCommands(const MachoImage &image);
+static void printMemberName(JsonWriter *json, const char *name);
 
 int main(int argc, char **argv) {
     parseArguments(argc, argv);
 
-    int fd;
-    struct stat sb;
+    if (args.batch != NULL) {
+        return runBatch(args.batch);
+    }
 
-    fd = open(args.file_name, O_RDONLY);
-    fstat(fd, &sb);
+    // Static so that the output is closed even if the process exits because of an error.
+    static std::unique_ptr<JsonOutput> jsonOutput;
+    JsonWriter *json = NULL;
+    if (args.format != FORMAT_TEXT) {
+        jsonOutput = std::make_unique<JsonOutput>(stdout);
+        json = &jsonOutput->writer();
+    }
 
-    uint32_t fileSize = sb.st_size;
-    uint8_t *fileBase = (uint8_t *)mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (fileBase == MAP_FAILED) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(args.file_name);
+    } catch (const std::exception &) {
         fprintf(stderr, "Cannot read file %s\n", args.file_name);
         return 1;
     }
 
-    uint8_t *sliceBase = fileBase;
-    uint32_t sliceSize = fileSize;
-    if (FatMacho::isFatMacho(fileBase, fileSize)) {
-        std::tie(sliceBase, sliceSize) = FatMacho::getSliceByArch(fileBase, fileSize, args.arch);
+    if (args.find_symbol != NULL) {
+        findSymbolInArchive(json, *file, args.find_symbol);
+        return 0;
     }
 
+    // Only the selected slice of a fat file is mapped. The image is read in place, so the whole slice is mapped,
+    // but only the pages that are touched are read from disk.
+    uint64_t fileSize = file->size();
+    uint64_t headSize = std::min(fileSize, (uint64_t)getpagesize());
+    uint8_t *head = mapFileRange(*file, 0, headSize);
+
+    uint64_t sliceOffset = 0;
+    uint64_t sliceSize = fileSize;
+    if (FatMacho::isFatMacho(head, headSize)) {
+        uint8_t *sliceBase;
+        std::tie(sliceBase, sliceSize) = FatMacho::getSliceByArch(head, headSize, args.arch);
+        sliceOffset = sliceBase - head;
+    }
+    uint8_t *sliceBase = mapFileRange(*file, sliceOffset, sliceSize);
+
     if (Archive::isArchive(sliceBase, sliceSize)) { // handle static library
-        Archive::enumerateObjectFileInArchive(sliceBase, sliceSize, [](char *objectFileName, uint8_t *objectFileBase) {
-            printf("\033[0;34m%s:\033[0m\n", objectFileName);
-            printMacho(objectFileBase);
-            printf("\n");
-        });
+        if (args.export_columns != NULL) {
+            // every member would overwrite the tables of the previous one
+            fprintf(stderr, "--export-columns doesn't work with static libraries.\n");
+            return 1;
+        }
+        if (args.lookup_export != NULL || args.rebuild_exports) {
+            // object files don't have an export trie
+            fprintf(stderr, "--lookup-export and --rebuild-exports don't work with static libraries.\n");
+            return 1;
+        }
+        printArchive(json, sliceBase, sliceSize);
     } else {
-        printMacho(sliceBase);
+        printMacho(json, sliceBase, sliceSize);
     }
 
-    munmap(fileBase, fileSize);
     return 0;
 }
 
-static void printMacho(uint8_t *machoBase) {
-    struct mach_header_64 *machHeader = parseMachHeader(machoBase);
-    // the base address of a specific arch slice
-    uint8_t *base = (uint8_t *)machHeader;
-    std::vector<struct load_command *> allLoadCommands = parseLoadCommands(base, sizeof(struct mach_header_64), machHeader->ncmds);
+static void printMacho(JsonWriter *json, uint8_t *machoBase, uint64_t machoSize) {
+    // parseMachHeader() validates the magic and the architecture, exiting on failure.
+    struct mach_header_64 *machHeader = parseMachHeader(machoBase, machoSize);
+
+    // A malformed file fails with an error from the image or a decoder instead of reading out of bounds.
+    try {
+        // the image of a specific arch slice
+        MachoImage image((uint8_t *)machHeader, machoSize);
+        if (args.cache_dir != NULL) {
+            image.cache = ImageCache::open(args.cache_dir, image, args.file_name);
+        }
+
+        if (args.export_columns != NULL) {
+            exportColumns(image, args.export_columns);
+        } else if (args.lookup_export != NULL) {
+            if (!printExportLookup(image, args.lookup_export)) {
+                exit(1);
+            }
+        } else if (args.rebuild_exports) {
+            printRebuiltExportTrie(image, args.hide_exports);
+        } else if (json == NULL) {
+            printLoadCommands(image);
+        } else {
+            printJsonImage(*json, image);
+        }
+    } catch (const std::exception &e) {
+        fflush(stdout);
+        fprintf(stderr, "%s\n", e.what());
+        exit(1);
+    }
+}
+
+static void printMemberName(JsonWriter *json, const char *name) {
+    if (json == NULL) {
+        printf("\033[0;34m%s:\033[0m\n", name);
+    } else {
+        printJsonMember(*json, name);
+    }
+}
+
+// The output of a member, rendered on a worker thread. If `error` is set, it's printed after the output
+// and the process exits, as if the member had been printed directly.
+struct MemberOutput {
+    char *text = NULL;
+    size_t size = 0;
+    std::string error;
+};
+
+// Render a member with the same printers as a single image, into memory instead of stdout.
+static void renderMember(bool json, const Archive::Member &member, MemberOutput &output) {
+    FILE *file = open_memstream(&output.text, &output.size);
+    if (file == NULL) {
+        output.error = "Cannot allocate the output of " + member.name;
+        return;
+    }
+
+    {
+        TextOutputScope scope(file);
+        try {
+            output.error = checkMachHeader(member.base, member.size);
+            if (output.error.empty()) {
+                MachoImage image((uint8_t *)parseMachHeader(member.base, member.size), member.size);
+                if (json) {
+                    JsonOutput jsonOutput(file, true);
+                    printJsonImage(jsonOutput.writer(), image);
+                } else {
+                    printLoadCommands(image);
+                    fprintf(textOutput(), "\n");
+                }
+            }
+        } catch (const std::exception &e) {
+            output.error = e.what();
+        }
+    }
+    fclose(file);
+}
+
+// Object files are parsed and rendered on all cores, each into its own buffer, and then written in archive order.
+// The members are processed in batches of a few per worker. Once a batch is written, its buffers are freed
+// and its pages are released, so apart from the member index the memory used depends on the batch, not the archive.
+static void printArchive(JsonWriter *json, uint8_t *archiveBase, uint64_t archiveSize) {
+    MappedFile::adviseSequential(archiveBase, archiveSize);
+
+    std::vector<Archive::Member> members = Archive::indexMembers(archiveBase, archiveSize);
+    size_t batchSize = (size_t)args.jobs * 4;
+
+    for (size_t batchStart = 0; batchStart < members.size(); batchStart += batchSize) {
+        std::vector<Archive::Member> batch(members.begin() + batchStart,
+            members.begin() + std::min(batchStart + batchSize, members.size()));
+        std::vector<MemberOutput> outputs(batch.size());
+
+        Archive::enumerateObjectFileInArchiveParallel(batch, [json, &outputs](size_t i, const Archive::Member &member) {
+            renderMember(json != NULL, member, outputs[i]);
+        }, args.jobs);
 
-    memset(&machoBinary, 0x0, sizeof(machoBinary));
-    machoBinary.base = base;
-    machoBinary.allLoadCommands = allLoadCommands;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            printMemberName(json, batch[i].name.c_str());
+            std::string_view text(outputs[i].text, outputs[i].size);
+            if (json == NULL) {
+                fwrite(text.data(), 1, text.size(), stdout);
+            } else {
+                json->raw(text);
+            }
+            free(outputs[i].text);
 
-    // filter segment commands
-    std::vector<struct load_command *> segmentCommands;
-    std::copy_if(allLoadCommands.begin(), allLoadCommands.end(), std::back_inserter(segmentCommands),
-        [](struct load_command * lcmd){ return lcmd->cmd == LC_SEGMENT_64; });
-    std::transform(segmentCommands.begin(), segmentCommands.end(), std::back_inserter(machoBinary.segmentCommands),
-        [](struct load_command * lcmd){ return (struct segment_command_64 *)lcmd; });
+            if (!outputs[i].error.empty()) {
+                fflush(stdout);
+                fprintf(stderr, "%s\n", outputs[i].error.c_str());
+                exit(1);
+            }
+
+            MappedFile::release(batch[i].base, batch[i].size);
+        }
+    }
+}
+
+// Only the archive header, the symbol table and the member that defines the symbol are mapped,
+// so the cost doesn't grow with the size of the archive.
+static void findSymbolInArchive(JsonWriter *json, MappedFile &file, const char *symbol) {
+    uint64_t headSize = std::min(file.size(), (uint64_t)getpagesize());
+    uint8_t *head = mapFileRange(file, 0, headSize);
+
+    uint64_t sliceOffset = 0;
+    if (FatMacho::isFatMacho(head, headSize)) {
+        uint8_t *sliceBase;
+        uint64_t sliceSize;
+        std::tie(sliceBase, sliceSize) = FatMacho::getSliceByArch(head, headSize, args.arch);
+        sliceOffset = sliceBase - head;
+    }
+
+    uint8_t *archiveHead = mapFileRange(file, sliceOffset, SARMAG + sizeof(struct ar_hdr));
+    if (!Archive::isArchive(archiveHead, SARMAG)) {
+        fprintf(stderr, "--find-symbol only works with static libraries.\n");
+        exit(1);
+    }
 
-    printLoadCommands(base, allLoadCommands);
+    uint64_t symbolTableSize = SARMAG + Archive::memberSizeAt(archiveHead + SARMAG);
+    uint8_t *archiveBase = mapFileRange(file, sliceOffset, symbolTableSize);
+    Archive::SymbolTable symbolTable(archiveBase, symbolTableSize);
+    if (!symbolTable.isValid()) {
+        fprintf(stderr, "The archive doesn't have a symbol table. Run ranlib to add one.\n");
+        exit(1);
+    }
+
+    uint64_t headerOffset;
+    if (!symbolTable.findMember(symbol, &headerOffset)) {
+        fprintf(stderr, "Cannot find symbol %s in the archive.\n", symbol);
+        exit(1);
+    }
+
+    uint8_t *header = mapFileRange(file, sliceOffset + headerOffset, sizeof(struct ar_hdr));
+    uint64_t memberSize = Archive::memberSizeAt(header);
+    if (memberSize < sizeof(struct ar_hdr)) {
+        fprintf(stderr, "Malformed file %s\n", args.file_name);
+        exit(1);
+    }
+    uint8_t *memberHeader = mapFileRange(file, sliceOffset + headerOffset, memberSize);
+    Archive::Member member = Archive::memberAt(memberHeader, headerOffset);
+
+    printMemberName(json, member.name.c_str());
+    printMacho(json, member.base, member.size);
+}
+
+// Map [offset, offset + size) of the file, which stays mapped until the process exits. Exit if it's out of bounds.
+static uint8_t *mapFileRange(MappedFile &file, uint64_t offset, uint64_t size) {
+    if (offset > file.size() || size > file.size() - offset) {
+        fprintf(stderr, "Malformed file %s\n", args.file_name);
+        exit(1);
+    }
+
+    try {
+        return file.map(offset, size);
+    } catch (const std::exception &) {
+        fprintf(stderr, "Cannot read file %s\n", args.file_name);
+        exit(1);
+    }
 }
 
-static void printLoadCommands(uint8_t *base, std::vector<struct load_command *> allLoadCommands) {
+static void printLoadCommands(const MachoImage &image) {
+    uint8_t *base = image.base;
     int sectionIndex = 0;
 
-    for (struct load_command *lcmd : allLoadCommands) {
+    for (struct load_command *lcmd : image.allLoadCommands) {
 
         if (!showCommand(lcmd->cmd)) {
             continue;
@@ -112,14 +308,14 @@ static void printLoadCommands(uint8_t *base, std::vector<struct load_command *>
 
         switch (lcmd->cmd) {
             case LC_SEGMENT_64:
-                printSegment(base, (struct segment_command_64 *)lcmd, sectionIndex);
+                printSegment(image, (struct segment_command_64 *)lcmd, sectionIndex);
                 sectionIndex += ((struct segment_command_64 *)lcmd)->nsects;
                 break;
             case LC_SYMTAB:
-                printSymbolTable(base, (struct symtab_command *)lcmd);
+                printSymbolTable(image, (struct symtab_command *)lcmd);
                 break;
             case LC_DYSYMTAB:
-                printDynamicSymbolTable(base, (struct dysymtab_command *)lcmd);
+                printDynamicSymbolTable(image, (struct dysymtab_command *)lcmd);
                 break;
             case LC_LOAD_DYLINKER:
             case LC_ID_DYLINKER:
@@ -147,7 +343,7 @@ static void printLoadCommands(uint8_t *base, std::vector<struct load_command *>
                 break;
             case LC_DYLD_INFO:
             case LC_DYLD_INFO_ONLY:
-                printDyldInfo(base, (struct dyld_info_command *)lcmd);
+                printDyldInfo(image, (struct dyld_info_command *)lcmd);
                 break;
             case LC_CODE_SIGNATURE:
             case LC_FUNCTION_STARTS:
@@ -157,10 +353,8 @@ static void printLoadCommands(uint8_t *base, std::vector<struct load_command *>
             case LC_DYLD_EXPORTS_TRIE:
             case LC_DYLD_CHAINED_FIXUPS:
             case LC_SEGMENT_SPLIT_INFO:
-#if __clang_major__ >= 15
             case LC_ATOM_INFO:
-#endif
-                printLinkEditData(base, (struct linkedit_data_command *)lcmd);
+                printLinkEditData(image, (struct linkedit_data_command *)lcmd);
                 break;
             case LC_BUILD_VERSION:
                 printBuildVersion(base, (struct build_version_command *)lcmd);
@@ -181,7 +375,7 @@ static void printLoadCommands(uint8_t *base, std::vector<struct load_command *>
                 printEncryptionInfo(base, (struct encryption_info_command_64 *)lcmd);
                 break;
             default:
-                printf("LC_(%x)\n", lcmd->cmd);
+                fprintf(textOutput(), "LC_(%x)\n", lcmd->cmd);
         }
     }
 }
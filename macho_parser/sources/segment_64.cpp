@@ -7,9 +7,8 @@
 #include <iomanip>
 
 #include "argument.h"
-#include "util.h"
 #include "utils/utils.h"
-#include "load_command.h"
+#include "core/macho_image.h"
 #include "symtab.h"
 
 // llvm_cov.cpp
@@ -17,15 +16,16 @@ void printCovMapSection(uint8_t *sectBase, size_t sectSize);
 void printCovFunSection(uint8_t *sectBase, size_t sectSize);
 void printPrfNamesSection(uint8_t *sectBase, size_t sectSize);
 
-static bool hasSectionToShow(struct segment_command_64 *segCmd, int firstSectionIndex);
-static void printSection(uint8_t *base, struct section_64 sect, int sectionIndex);
+static bool hasSectionToShow(SegmentView segment, int firstSectionIndex);
+static void printSection(const MachoImage &image, SectionView sect, int sectionIndex);
 static void printCStringSection(uint8_t *sectBase, size_t sectSize);
-static void printPointerSection(uint8_t *base, struct section_64 *sect);
+static void printPointerSection(const MachoImage &image, SectionView sect);
 
 static std::string formatSectionType(uint8_t type);
 
-void printSegment(uint8_t *base, struct segment_command_64 *segCmd, int firstSectionIndex) {
-    if (hasSectionSpecifed() && !hasSectionToShow(segCmd, firstSectionIndex)) {
+void printSegment(const MachoImage &image, struct segment_command_64 *segCmd, int firstSectionIndex) {
+    SegmentView segment(segCmd);
+    if (hasSectionSpecifed() && !hasSectionToShow(segment, firstSectionIndex)) {
         // If --section is specified and no section needs to be show in this segment, just return.
         return;
     }
@@ -33,7 +33,7 @@ void printSegment(uint8_t *base, struct segment_command_64 *segCmd, int firstSec
     auto formattedFileSize = formatSize(segCmd->filesize);
     auto formattedVMSize = formatSize(segCmd->vmsize);
 
-    printf("%-20s cmdsize: %-6d segname: %-12.16s   file: 0x%08llx-0x%08llx %-9s  vm: 0x%09llx-0x%09llx %-9s prot: %d/%d\n",
+    fprintf(textOutput(), "%-20s cmdsize: %-6d segname: %-12.16s   file: 0x%08llx-0x%08llx %-9s  vm: 0x%09llx-0x%09llx %-9s prot: %d/%d\n",
         "LC_SEGMENT_64", segCmd->cmdsize, segCmd->segname,
         segCmd->fileoff, segCmd->fileoff + segCmd->filesize, formattedFileSize.c_str(),
         segCmd->vmaddr, segCmd->vmaddr + segCmd->vmsize, formattedVMSize.c_str(),
@@ -43,68 +43,68 @@ void printSegment(uint8_t *base, struct segment_command_64 *segCmd, int firstSec
         return;
     }
 
-    // section_64 is immediately after segment_command_64.
-    struct section_64 *sections = (struct section_64 *)((uint8_t *)segCmd + sizeof(struct segment_command_64));
-
-    for (int i = 0; i < segCmd->nsects; ++i) {
-        struct section_64 sect = sections[i];
-        if (showSection(firstSectionIndex + i, sect.sectname)) {
-            printSection(base, sect, firstSectionIndex + i);
+    int sectionIndex = firstSectionIndex;
+    for (SectionView sect : segment.sections()) {
+        if (showSection(sectionIndex, sect.name())) {
+            printSection(image, sect, sectionIndex);
         }
+        sectionIndex += 1;
     }
 }
 
-static bool hasSectionToShow(struct segment_command_64 *segCmd, int firstSectionIndex) {
-    struct section_64 *sections = (struct section_64 *)((uint8_t *)segCmd + sizeof(struct segment_command_64));
-    for (int i = 0; i < segCmd->nsects; ++i) {
-        struct section_64 sect = sections[i];
-        if (showSection(firstSectionIndex + i, sect.sectname)) {
+static bool hasSectionToShow(SegmentView segment, int firstSectionIndex) {
+    int sectionIndex = firstSectionIndex;
+    for (SectionView sect : segment.sections()) {
+        if (showSection(sectionIndex, sect.name())) {
             return true;
         }
+        sectionIndex += 1;
     }
     return false;
 }
 
-static void printSection(uint8_t *base, struct section_64 sect, int sectionIndex) {
+static void printSection(const MachoImage &image, SectionView sect, int sectionIndex) {
+    uint8_t *base = image.base;
     char formattedSegSec[64];
 
-    const uint8_t type = sect.flags & SECTION_TYPE;
+    const uint8_t type = sect.type();
 
     auto formattedType = formatSectionType(type);
-    snprintf(formattedSegSec, sizeof(formattedSegSec), "(%.16s,%.16s)", sect.segname, sect.sectname);
-    auto formattedSize = formatSize(sect.size);
+    snprintf(formattedSegSec, sizeof(formattedSegSec), "(%.*s,%.*s)",
+        (int)sect.segmentName().size(), sect.segmentName().data(), (int)sect.name().size(), sect.name().data());
+    auto formattedSize = formatSize(sect.size());
 
-    printf("  %2d: 0x%09x-0x%09llx %-11s %-32s  type: %s  offset: %d",
-        sectionIndex, sect.offset, sect.offset + sect.size, formattedSize.c_str(), formattedSegSec, formattedType.c_str(), sect.offset);
+    fprintf(textOutput(), "  %2d: 0x%09x-0x%09llx %-11s %-32s  type: %s  offset: %d",
+        sectionIndex, sect.offset(), sect.offset() + sect.size(), formattedSize.c_str(), formattedSegSec, formattedType.c_str(), sect.offset());
 
-    if (sect.reserved1 > 0) {
-        printf("   reserved1: %2d", sect.reserved1);
+    if (sect.reserved1() > 0) {
+        fprintf(textOutput(), "   reserved1: %2d", sect.reserved1());
     }
 
-    if (sect.reserved2 > 0) {
-        printf("   reserved1: %2d", sect.reserved2);
+    if (sect.reserved2() > 0) {
+        fprintf(textOutput(), "   reserved1: %2d", sect.reserved2());
     }
 
-    printf("\n");
+    fprintf(textOutput(), "\n");
 
     if (args.verbosity < 2) {
         return;
     }
 
-    if (strncmp(sect.sectname, "__llvm_covmap", 16) == 0) {
-        printCovMapSection(base + sect.offset, sect.size);
-    } else if (strncmp(sect.sectname, "__llvm_covfun", 16) == 0) {
-        printCovFunSection(base + sect.offset, sect.size);
-    } else if (strncmp(sect.sectname, "__llvm_prf_names", 16) == 0) {
-        printPrfNamesSection(base + sect.offset, sect.size);
+    if (sect.name() == "__llvm_covmap") {
+        printCovMapSection(base + sect.offset(), sect.size());
+    } else if (sect.name() == "__llvm_covfun") {
+        printCovFunSection(base + sect.offset(), sect.size());
+    } else if (sect.name() == "__llvm_prf_names") {
+        printPrfNamesSection(base + sect.offset(), sect.size());
     } else if (type == S_CSTRING_LITERALS) {
         // (__TEXT,__cstring), (__TEXT,__objc_classname__TEXT), (__TEXT,__objc_methname), etc..
-        printCStringSection(base + sect.offset, sect.size);
+        printCStringSection(base + sect.offset(), sect.size());
     } else if (type == S_MOD_INIT_FUNC_POINTERS
         || type == S_NON_LAZY_SYMBOL_POINTERS
         || type == S_LAZY_SYMBOL_POINTERS) {
         // (__DATA_CONST,__mod_init_func)
-        printPointerSection(base, &sect);
+        printPointerSection(image, sect);
     }
 }
 
@@ -112,10 +112,12 @@ static void printCStringSection(uint8_t *sectBase, size_t sectSize) {
     int count = 0;
     char *ptr = (char *)sectBase;
     while(ptr < (char *)(sectBase + sectSize)) {
-        if (strlen(ptr) > 0) {
-            auto formatted = formatStringLiteral(ptr);
-            printf("    \"%s\"\n", formatted.c_str());
-            ptr += strlen(ptr);
+        // The last string may not be terminated inside the section.
+        size_t length = strnlen(ptr, (char *)(sectBase + sectSize) - ptr);
+        if (length > 0) {
+            auto formatted = formatStringLiteral(std::string(ptr, length).c_str());
+            fprintf(textOutput(), "    \"%s\"\n", formatted.c_str());
+            ptr += length;
 
             if (count >= 10 && !args.no_truncate) {
                 break;
@@ -126,25 +128,23 @@ static void printCStringSection(uint8_t *sectBase, size_t sectSize) {
     }
 
     if (!args.no_truncate && ptr < (char *)(sectBase + sectSize)) {
-        printf("    ... more ...\n");
+        fprintf(textOutput(), "    ... more ...\n");
     }
 }
 
-static void printPointerSection(uint8_t *base, struct section_64 *sect) {
-    void *section = base + sect->offset;
+static void printPointerSection(const MachoImage &image, SectionView sect) {
+    void *section = image.base + sect.offset();
 
-    const size_t count = sect->size / sizeof(uintptr_t);
+    const size_t count = sect.size() / sizeof(uintptr_t);
     int max_count = args.no_truncate ? count : std::min<size_t>(count, 10);
 
-    struct symtab_command *symtab_cmd = (struct symtab_command *)search_load_command(base, 0, is_symtab_load_command).lcmd;
-
     for (int i = 0; i < max_count; ++i) {
-        char *symbol = lookup_symbol_by_address(*((uintptr_t *)section + i), base, symtab_cmd);
-        printf("    0x%lx  %s\n", *((uintptr_t *)section + i), (symbol == NULL ? "" : symbol));
+        uintptr_t pointer = *((uintptr_t *)section + i);
+        fprintf(textOutput(), "    0x%lx  %s\n", pointer, image.symbolicateAddress(pointer).c_str());
     }
 
     if (!args.no_truncate && count > 10) {
-        printf("    ... %lu more ...\n", count - 10);
+        fprintf(textOutput(), "    ... %lu more ...\n", count - 10);
     }
 }
 
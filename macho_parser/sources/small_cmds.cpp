@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "utils/utils.h"
+
 #include "small_cmds.h"
 
 void printDyLinker(void *base, struct dylinker_command *dylinker_cmd) {
@@ -18,13 +20,13 @@ void printDyLinker(void *base, struct dylinker_command *dylinker_cmd) {
             break;
     }
 
-    printf("%-20s cmdsize: %-6u %s\n", cmd_name,
+    fprintf(textOutput(), "%-20s cmdsize: %-6u %s\n", cmd_name,
         dylinker_cmd->cmdsize, (char *)dylinker_cmd + dylinker_cmd->name.offset);
 }
 
 void printEntryPoint(void *base, struct entry_point_command *entry_point_cmd) {
     uint64_t entryoff = entry_point_cmd->entryoff;
-    printf("%-20s cmdsize: %-6u entryoff: %llu (%#llx)  stacksize: %llu\n", "LC_MAIN",
+    fprintf(textOutput(), "%-20s cmdsize: %-6u entryoff: %llu (%#llx)  stacksize: %llu\n", "LC_MAIN",
         entry_point_cmd->cmdsize, entryoff, entryoff, entry_point_cmd->stacksize);
 }
 
@@ -40,20 +42,20 @@ void printLinkerOption(void *base, struct linker_option_command *cmd) {
         opt = opt + len;
     }
 
-    printf("%-20s cmdsize: %-6u count: %d   %s\n", "LC_LINKER_OPTION", cmd->cmdsize, cmd->count, options);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u count: %d   %s\n", "LC_LINKER_OPTION", cmd->cmdsize, cmd->count, options);
     free(options);
 }
 
 void printRpath(void *base, struct rpath_command *cmd) {
-    printf("%-20s cmdsize: %-6u %s\n", "LC_RPATH", cmd->cmdsize, (char *)cmd + cmd->path.offset);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u %s\n", "LC_RPATH", cmd->cmdsize, (char *)cmd + cmd->path.offset);
 }
 
 void printUUID(void *base, struct uuid_command *cmd) {
-    printf("%-20s cmdsize: %-6u ", "LC_UUID", cmd->cmdsize);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u ", "LC_UUID", cmd->cmdsize);
     for (int i = 0; i < sizeof(cmd->uuid); ++i) {
-        printf("%X", cmd->uuid[i]);
+        fprintf(textOutput(), "%X", cmd->uuid[i]);
     }
-    printf("\n");
+    fprintf(textOutput(), "\n");
 }
 
 void printSourceVersion(void *base, struct source_version_command *cmd) {
@@ -62,7 +64,7 @@ void printSourceVersion(void *base, struct source_version_command *cmd) {
     int c = (0x000000003FF00000 & cmd->version) >> 20;
     int d = (0x00000000000FFC00 & cmd->version) >> 10;
     int e = (0x00000000000003FF & cmd->version);
-    printf("%-20s cmdsize: %-6u %d.%d.%d.%d.%d\n", "LC_SOURCE_VERSION", cmd->cmdsize,
+    fprintf(textOutput(), "%-20s cmdsize: %-6u %d.%d.%d.%d.%d\n", "LC_SOURCE_VERSION", cmd->cmdsize,
         a, b, c, d, e);
 }
 
@@ -77,5 +79,5 @@ void printThread(uint8_t *base, struct thread_command *cmd) {
             break;
     }
 
-    printf("%-20s cmdsize: %-6u\n", cmd_name, cmd->cmdsize);
+    fprintf(textOutput(), "%-20s cmdsize: %-6u\n", cmd_name, cmd->cmdsize);
 }
@@ -1,7 +1,7 @@
 #ifndef SMALL_CMDS_H
 #define SMALL_CMDS_H
 
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
 
 void printDyLinker(void *base, struct dylinker_command *);
 void printEntryPoint(void *base, struct entry_point_command *);
@@ -1,120 +1,154 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <mach-o/nlist.h>
-#include <mach-o/stab.h>
+#include "apple/mach-o/nlist.h"
+#include "apple/mach-o/stab.h"
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iterator>
 
 #include "argument.h"
-#include "macho_binary.h"
+#include "utils/utils.h"
 
 #include "symtab.h"
 
-static std::string formatSymbol(struct nlist_64 *nlist, uint8_t *strTable);
+// Everything printSymbol() needs besides the symbol itself. The labels are computed up front
+// so that formatting a symbol doesn't allocate, which matters for tables with millions of symbols.
+struct SymbolPrinter {
+    SymbolPrinter(const MachoImage &image, struct symtab_command *symtabCmd, OutputBuffer &out)
+        : image(image), symtabCmd(symtabCmd), out(out) {}
+
+    const MachoImage &image;
+    struct symtab_command *symtabCmd;
+    OutputBuffer &out;
+    // "from libfoo.dylib" for each library ordinal, filled on the first undefined symbol
+    std::vector<std::string> dylibLabels;
+
+    void print(int indent, int index);
+    void printDescription(const struct nlist_64 *nlist);
+    const std::string &dylibLabel(int libraryOrdinal);
+};
+
+// "[SECT EXT]" for each n_type and the stab name for each stab type. They don't depend on the image.
+struct TypeLabels {
+    std::string types[256];
+    std::string stabTypes[256];
+};
+
+static const TypeLabels &getTypeLabels();
 static std::string stringifyType(uint8_t type);
-static std::string stringifyDescription(struct nlist_64 *nlist);
 static std::string stringifyStabType(uint8_t type);
 
-void printSymbolTable(uint8_t *base, struct symtab_command *symtabCmd) {
-    printf("%-20s cmdsize: %-6d symoff: %d   nsyms: %d   (symsize: %lu)   stroff: %d   strsize: %u\n",
+void printSymbolTable(const MachoImage &image, struct symtab_command *symtabCmd) {
+    fprintf(textOutput(), "%-20s cmdsize: %-6d symoff: %d   nsyms: %d   (symsize: %lu)   stroff: %d   strsize: %u\n",
         "LC_SYMTAB", symtabCmd->cmdsize, symtabCmd->symoff, symtabCmd->nsyms,
         symtabCmd->nsyms * sizeof(struct nlist_64), symtabCmd->stroff, symtabCmd->strsize);
 
     if (args.verbosity == 0) { return; }
 
+    if (args.symbol != NULL) {
+        int index = image.lookupSymbolByName(args.symbol);
+        if (index < 0) {
+            fprintf(textOutput(), "  Cannot find symbol %s\n", args.symbol);
+        } else {
+            printSymbol(2, image, symtabCmd, index);
+        }
+        return;
+    }
+
+    fflush(textOutput());
+    OutputBuffer out(textOutput(), 1024 * 1024);
+    SymbolPrinter printer(image, symtabCmd, out);
     for (int i = 0; i < symtabCmd->nsyms; ++i) {
-        printSymbol(2, base, symtabCmd, i);
+        printer.print(2, i);
     }
 }
 
-void printSymbol(int indent, uint8_t *base, struct symtab_command *symtabCmd, int index) {
+void printSymbol(int indent, const MachoImage &image, struct symtab_command *symtabCmd, int index) {
+    OutputBuffer out(textOutput(), 4096);
+    SymbolPrinter printer(image, symtabCmd, out);
+    printer.print(indent, index);
+}
+
+void SymbolPrinter::print(int indent, int index) {
     if (index < 0 || index >= symtabCmd->nsyms) {
-        puts("Error: %d is out of bounds of symtab.");
-        exit(0);
+        throw std::runtime_error("Symbol " + std::to_string(index) + " is out of bounds of symtab.");
     }
 
-    uint8_t *symTable = base + symtabCmd->symoff;
-    uint8_t *strTable = base + symtabCmd->stroff;
+    const struct nlist_64 *nlist = image.getSymbol(index);
+    const TypeLabels &labels = getTypeLabels();
 
-    struct nlist_64 *nlist = (struct nlist_64 *)(symTable + sizeof(struct nlist_64) * index);
+    out.appendSpaces(indent);
+    out.appendDecimal(index, -4);
+    out.append(": ");
 
-    char formatted_value[32] = {'\0'};
     if ((nlist->n_type & N_TYPE) != N_UNDF) {
-        snprintf(formatted_value, sizeof(formatted_value), "%016llx", nlist->n_value);
+        out.appendHex(nlist->n_value, 16);
+    } else {
+        out.appendSpaces(16);
     }
 
-    printf("%*s%-4d: %16s  %-10s  %-60s  %s\n",
-        indent, "", index, formatted_value,
-        stringifyType(nlist->n_type).c_str(),
-        formatSymbol(nlist, strTable).c_str(),
-        stringifyDescription(nlist).c_str());
-}
+    out.append("  ");
+    out.append(labels.types[nlist->n_type], -10);
+    out.append("  ");
 
-static std::string formatSymbol(struct nlist_64 *nlist, uint8_t *strTable) {
-    char buf[1024];
-    char *symbol = (char *)(strTable + nlist->n_un.n_strx);
+    const char *symbol = image.getString(nlist->n_un.n_strx);
     if (nlist->n_type & N_STAB) {
-        snprintf(buf, sizeof(buf), "%04d %5s %s \033[0;34m\033[0m", nlist->n_desc, stringifyStabType(nlist->n_type).c_str(), symbol);
+        char buf[1024];
+        snprintf(buf, sizeof(buf), "%04d %5s %s \033[0;34m\033[0m", nlist->n_desc, labels.stabTypes[nlist->n_type].c_str(), symbol);
+        out.append(buf, -60);
     } else {
-        snprintf(buf, sizeof(buf), "\033[0;34m%s\033[0m", symbol);
+        // The color codes count towards the column width.
+        std::string_view name(symbol);
+        out.append("\033[0;34m");
+        out.append(name);
+        out.append("\033[0m");
+        int width = strlen("\033[0;34m") + name.size() + strlen("\033[0m");
+        if (width < 60) {
+            out.appendSpaces(60 - width);
+        }
     }
 
-    return std::string(buf);
+    out.append("  ");
+    printDescription(nlist);
+    out.append('\n');
 }
 
-static std::string stringifyType(uint8_t type) {
-    std::vector<std::string> attrs;
-
-    if (type & N_STAB) {
-        // If any of the N_STAB is set, the whole type becomes a stab type which is defined in stab.h
-        attrs.push_back("STAB");
-    } else {
-        switch (type & N_TYPE) {
-            case N_UNDF:
-                attrs.push_back("UNDF");
-                break;
-            case N_ABS:
-                attrs.push_back("ABS");
-                break;
-            case N_SECT:
-                attrs.push_back("SECT");
-                break;
-            case N_PBUD:
-                attrs.push_back("PBUD");
-                break;
-            case N_INDR:
-                attrs.push_back("INDR");
-                break;
-        }
-
-        if (type & N_EXT) {
-            attrs.push_back("EXT"); // global symbols
-        }
-
-        if (type & N_PEXT) {
-            attrs.push_back("PEXT"); // private external symbols
+const std::string &SymbolPrinter::dylibLabel(int libraryOrdinal) {
+    if (dylibLabels.empty()) {
+        dylibLabels.resize(256);
+        for (int ordinal = 1; ordinal < 256; ++ordinal) {
+            dylibLabels[ordinal] = std::string("from ") + image.getDylibNameByOrdinal(ordinal);
         }
     }
-
-    std::ostringstream formattedStream;
-    std::copy(attrs.begin(), attrs.end(), std::ostream_iterator<std::string>(formattedStream, " "));
-    std::string formatted = formattedStream.str();
-    formatted.pop_back(); // remove the last space
-    return std::string("[") + formatted + "]";
+    return dylibLabels[libraryOrdinal];
 }
 
-static std::string stringifyDescription(struct nlist_64 *nlist) {
+void SymbolPrinter::printDescription(const struct nlist_64 *nlist) {
     uint8_t type = nlist->n_type;
     uint16_t desc = nlist->n_desc;
-
-    std::vector<std::string> attrs;
-
-    if (nlist->n_sect != NO_SECT) {
-        if (nlist->n_sect <= MAX_SECT) {
-            attrs.push_back(machoBinary.getSectionNameByOrdinal(nlist->n_sect));
+    bool first = true;
+
+    auto appendAttribute = [this, &first](std::string_view attr) {
+        out.append(first ? "// " : ", ");
+        out.append(attr);
+        first = false;
+    };
+
+    if (nlist->n_sect != NO_SECT && nlist->n_sect <= MAX_SECT) {
+        // "(segname, sectname)" straight from the section header, or an empty attribute for a bad ordinal.
+        auto sections = image.getSections();
+        if (nlist->n_sect <= sections.size()) {
+            SectionView sect = sections[nlist->n_sect - 1];
+            appendAttribute("(");
+            out.append(sect.segmentName());
+            out.append(", ");
+            out.append(sect.name());
+            out.append(")");
+        } else {
+            appendAttribute("");
         }
     }
 
@@ -122,57 +156,101 @@ static std::string stringifyDescription(struct nlist_64 *nlist) {
         if ((type & N_TYPE) == N_UNDF) {
             switch (desc & REFERENCE_TYPE) {
                 case REFERENCE_FLAG_UNDEFINED_NON_LAZY:
-                    attrs.push_back("UNDEFINED_NON_LAZY");
+                    appendAttribute("UNDEFINED_NON_LAZY");
                     break;
                 case REFERENCE_FLAG_UNDEFINED_LAZY:
-                    attrs.push_back("UNDEFINED_LAZY");
+                    appendAttribute("UNDEFINED_LAZY");
                     break;
                 case REFERENCE_FLAG_DEFINED:
-                    attrs.push_back("DEFINED");
+                    appendAttribute("DEFINED");
                     break;
                 case REFERENCE_FLAG_PRIVATE_DEFINED:
-                    attrs.push_back("PRIVATE_DEFINED");
+                    appendAttribute("PRIVATE_DEFINED");
                     break;
                 case REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY:
-                    attrs.push_back("PRIVATE_UNDEFINED_NON_LAZY");
+                    appendAttribute("PRIVATE_UNDEFINED_NON_LAZY");
                     break;
                 case REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY:
-                    attrs.push_back("PRIVATE_UNDEFINED_LAZY");
+                    appendAttribute("PRIVATE_UNDEFINED_LAZY");
                     break;
             }
 
             int libraryOrdinal = GET_LIBRARY_ORDINAL(desc);
             if (libraryOrdinal > 0) {
-                attrs.push_back(std::string("from ") + machoBinary.getDylibNameByOrdinal(libraryOrdinal));
+                appendAttribute(dylibLabel(libraryOrdinal));
             }
         }
 
         if (desc & REFERENCED_DYNAMICALLY) {
-            attrs.push_back("REFERENCED_DYNAMICALLY");
+            appendAttribute("REFERENCED_DYNAMICALLY");
         }
 
         if (desc & N_NO_DEAD_STRIP) {
-            attrs.push_back("NO_DEAD_STRIP");
+            appendAttribute("NO_DEAD_STRIP");
         }
 
         if (desc & N_WEAK_REF) {
-            attrs.push_back("WEAK_REF");
+            appendAttribute("WEAK_REF");
         }
         if (desc & N_WEAK_DEF) {
-            attrs.push_back("WEAK_DEF");
+            appendAttribute("WEAK_DEF");
         }
     }
+}
 
-    if (attrs.size() == 0) {
-        return "";
+static const TypeLabels &getTypeLabels() {
+    static const TypeLabels labels = []() {
+        TypeLabels labels;
+        for (int type = 0; type < 256; ++type) {
+            labels.types[type] = stringifyType(type);
+            labels.stabTypes[type] = stringifyStabType(type);
+        }
+        return labels;
+    }();
+    return labels;
+}
+
+static std::string stringifyType(uint8_t type) {
+    std::vector<std::string> attrs;
+
+    if (type & N_STAB) {
+        // If any of the N_STAB is set, the whole type becomes a stab type which is defined in stab.h
+        attrs.push_back("STAB");
+    } else {
+        switch (type & N_TYPE) {
+            case N_UNDF:
+                attrs.push_back("UNDF");
+                break;
+            case N_ABS:
+                attrs.push_back("ABS");
+                break;
+            case N_SECT:
+                attrs.push_back("SECT");
+                break;
+            case N_PBUD:
+                attrs.push_back("PBUD");
+                break;
+            case N_INDR:
+                attrs.push_back("INDR");
+                break;
+        }
+
+        if (type & N_EXT) {
+            attrs.push_back("EXT"); // global symbols
+        }
+
+        if (type & N_PEXT) {
+            attrs.push_back("PEXT"); // private external symbols
+        }
     }
 
     std::ostringstream formattedStream;
-    std::copy(attrs.begin(), attrs.end(), std::ostream_iterator<std::string>(formattedStream, ", "));
+    std::copy(attrs.begin(), attrs.end(), std::ostream_iterator<std::string>(formattedStream, " "));
     std::string formatted = formattedStream.str();
-    formatted.pop_back(); // remove last to charaters ", "
-    formatted.pop_back();
-    return std::string("// ") + formatted;
+    if (!formatted.empty()) {
+        formatted.pop_back(); // remove the last space
+    }
+    return std::string("[") + formatted + "]";
 }
 
 static std::string stringifyStabType(uint8_t type) {
@@ -210,25 +288,3 @@ static std::string stringifyStabType(uint8_t type) {
 
     return std::to_string(type);
 }
-
-char *lookup_symbol_by_address(uint64_t address, uint8_t *base, struct symtab_command *symtabCmd) {
-    uint8_t *symTable = base + symtabCmd->symoff;
-    uint8_t *strTable = base + symtabCmd->stroff;
-
-    // This logic can be optimized if the symbols are sorted by its address.
-    for (int i = 0; i < symtabCmd->nsyms; ++i) {
-        struct nlist_64 *nlist = (struct nlist_64 *)(symTable + sizeof(struct nlist_64) * i);
-        if (nlist->n_value == address) {
-            char *symbol = (char *)(strTable + nlist->n_un.n_strx);
-            if (strlen(symbol) > 0) {
-                return symbol;
-            }
-        }
-    }
-
-    return NULL;
-}
-
-bool is_symtab_load_command(struct load_command *lcmd) {
-    return lcmd->cmd == LC_SYMTAB;
-}
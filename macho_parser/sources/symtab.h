@@ -1,15 +1,13 @@
 #ifndef SYMTAB_H
 #define SYMTAB_H
 
-#include <mach-o/loader.h>
+#include "apple/mach-o/loader.h"
 #include <stdbool.h>
 
-void printSymbolTable(uint8_t *base, struct symtab_command *cmd);
+#include "core/macho_image.h"
 
-void printSymbol(int indent, uint8_t *base, struct symtab_command *symtabCmd, int offset);
+void printSymbolTable(const MachoImage &image, struct symtab_command *cmd);
 
-char *lookup_symbol_by_address(uint64_t address, uint8_t *base, struct symtab_command *symtabCmd);
-
-bool is_symtab_load_command(struct load_command *lcmd);
+void printSymbol(int indent, const MachoImage &image, struct symtab_command *symtabCmd, int offset);
 
 #endif /* SYMTAB_H */
@@ -0,0 +1,262 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdexcept>
+
+#include "utils.h"
+
+// The file layout. All offsets are from the start of the file and 8-byte aligned.
+//
+//   ColumnFileHeader
+//   ColumnInfo[columnCount]
+//   column arrays
+//   uint64_t dictionaryOffsets[dictionaryCount + 1]   // string i is [offsets[i], offsets[i + 1]) of the bytes
+//   dictionary bytes
+#define COLUMN_FILE_MAGIC "MPCOLS01"
+
+struct ColumnFileHeader {
+    char magic[8];
+    uint32_t columnCount;
+    uint32_t reserved;
+    uint64_t rowCount;
+    uint64_t dictionaryCount;
+    uint64_t dictionaryOffsetsOffset;
+    uint64_t dictionaryBytesOffset;
+    uint64_t dictionaryBytesSize;
+};
+
+struct ColumnInfo {
+    char name[32];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+static size_t columnWidth(ColumnType type) {
+    switch (type) {
+        case COLUMN_U8: return 1;
+        case COLUMN_U16: return 2;
+        case COLUMN_U32: return 4;
+        case COLUMN_U64: return 8;
+        case COLUMN_I32: return 4;
+        case COLUMN_I64: return 8;
+        case COLUMN_STRING: return 4;
+    }
+    return 0;
+}
+
+static uint64_t alignTo8(uint64_t value) {
+    return (value + 7) & ~(uint64_t)7;
+}
+
+size_t ColumnTableWriter::addColumn(const char *name, ColumnType type) {
+    if (strlen(name) >= sizeof(ColumnInfo::name)) {
+        throw std::runtime_error(std::string("Column name is too long: ") + name);
+    }
+    columns.push_back({name, type, {}});
+    return columns.size() - 1;
+}
+
+void ColumnTableWriter::append(size_t column, uint64_t value) {
+    Column &col = columns[column];
+    size_t width = columnWidth(col.type);
+    // little-endian, truncated to the width of the column
+    for (size_t i = 0; i < width; ++i) {
+        col.data.push_back((value >> (i * 8)) & 0xff);
+    }
+}
+
+void ColumnTableWriter::appendString(size_t column, std::string_view value) {
+    auto it = stringIds.find(std::string(value));
+    uint32_t id;
+    if (it != stringIds.end()) {
+        id = it->second;
+    } else {
+        id = strings.size();
+        strings.emplace_back(value);
+        stringIds.emplace(strings.back(), id);
+    }
+    append(column, id);
+}
+
+size_t ColumnTableWriter::rowCount() const {
+    return columns.empty() ? 0 : columns[0].data.size() / columnWidth(columns[0].type);
+}
+
+void ColumnTableWriter::write(const char *path) const {
+    uint64_t rows = rowCount();
+    for (auto &col : columns) {
+        if (col.data.size() != rows * columnWidth(col.type)) {
+            throw std::runtime_error("Column " + col.name + " has a different number of rows");
+        }
+    }
+
+    ColumnFileHeader header = {};
+    memcpy(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic));
+    header.columnCount = columns.size();
+    header.rowCount = rows;
+    header.dictionaryCount = strings.size();
+
+    std::vector<ColumnInfo> infos(columns.size());
+    uint64_t offset = sizeof(ColumnFileHeader) + sizeof(ColumnInfo) * columns.size();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        strncpy(infos[i].name, columns[i].name.c_str(), sizeof(infos[i].name) - 1);
+        infos[i].type = columns[i].type;
+        infos[i].offset = offset;
+        infos[i].size = columns[i].data.size();
+        offset = alignTo8(offset + infos[i].size);
+    }
+
+    std::vector<uint64_t> dictionaryOffsets;
+    uint64_t bytes = 0;
+    for (auto &str : strings) {
+        dictionaryOffsets.push_back(bytes);
+        bytes += str.size();
+    }
+    dictionaryOffsets.push_back(bytes);
+
+    header.dictionaryOffsetsOffset = offset;
+    header.dictionaryBytesOffset = offset + sizeof(uint64_t) * dictionaryOffsets.size();
+    header.dictionaryBytesSize = bytes;
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        throw std::runtime_error(std::string("Cannot open ") + path + " for writing");
+    }
+
+    static const uint8_t zeros[8] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (infos.empty() || fwrite(infos.data(), sizeof(ColumnInfo), infos.size(), file) == infos.size());
+    for (size_t i = 0; i < columns.size() && ok; ++i) {
+        ok = fwrite(columns[i].data.data(), 1, columns[i].data.size(), file) == columns[i].data.size();
+        size_t padding = alignTo8(infos[i].size) - infos[i].size;
+        ok = ok && fwrite(zeros, 1, padding, file) == padding;
+    }
+    ok = ok && fwrite(dictionaryOffsets.data(), sizeof(uint64_t), dictionaryOffsets.size(), file) == dictionaryOffsets.size();
+    for (size_t i = 0; i < strings.size() && ok; ++i) {
+        ok = fwrite(strings[i].data(), 1, strings[i].size(), file) == strings[i].size();
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) {
+        throw std::runtime_error(std::string("Cannot write ") + path);
+    }
+}
+
+ColumnTableReader::ColumnTableReader(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Cannot open ") + path);
+    }
+
+    struct stat sb;
+    fstat(fd, &sb);
+    size = sb.st_size;
+    if (size < sizeof(ColumnFileHeader)) {
+        close(fd);
+        throw std::runtime_error(std::string("Not a column table: ") + path);
+    }
+
+    base = (uint8_t *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+
+    // Validate everything up front so that the accessors don't need to.
+    const ColumnFileHeader *header = (const ColumnFileHeader *)base;
+    bool valid = memcmp(header->magic, COLUMN_FILE_MAGIC, sizeof(header->magic)) == 0
+        && header->columnCount <= (size - sizeof(ColumnFileHeader)) / sizeof(ColumnInfo);
+    rows = header->rowCount;
+
+    const ColumnInfo *infos = (const ColumnInfo *)(base + sizeof(ColumnFileHeader));
+    for (uint32_t i = 0; valid && i < header->columnCount; ++i) {
+        size_t width = columnWidth((ColumnType)infos[i].type);
+        valid = width > 0 && infos[i].offset % 8 == 0 && infos[i].offset <= size && infos[i].size <= size - infos[i].offset
+            && infos[i].size / width == rows && infos[i].size % width == 0;
+    }
+
+    valid = valid && header->dictionaryOffsetsOffset % 8 == 0 && header->dictionaryOffsetsOffset <= size
+        && header->dictionaryCount < (size - header->dictionaryOffsetsOffset) / sizeof(uint64_t)
+        && header->dictionaryBytesOffset <= size && header->dictionaryBytesSize <= size - header->dictionaryBytesOffset;
+
+    if (valid) {
+        const uint64_t *offsets = (const uint64_t *)(base + header->dictionaryOffsetsOffset);
+        for (uint64_t i = 0; valid && i < header->dictionaryCount; ++i) {
+            valid = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= header->dictionaryBytesSize;
+        }
+    }
+
+    if (!valid) {
+        munmap(base, size);
+        base = nullptr;
+        throw std::runtime_error(std::string("Not a valid column table: ") + path);
+    }
+}
+
+ColumnTableReader::~ColumnTableReader() {
+    if (base != nullptr) {
+        munmap(base, size);
+    }
+}
+
+size_t ColumnTableReader::columnCount() const {
+    return ((const ColumnFileHeader *)base)->columnCount;
+}
+
+static const ColumnInfo *columnInfo(const uint8_t *base, size_t column) {
+    return (const ColumnInfo *)(base + sizeof(ColumnFileHeader)) + column;
+}
+
+std::string_view ColumnTableReader::columnName(size_t column) const {
+    const ColumnInfo *info = columnInfo(base, column);
+    return std::string_view(info->name, strnlen(info->name, sizeof(info->name)));
+}
+
+ColumnType ColumnTableReader::columnType(size_t column) const {
+    return (ColumnType)columnInfo(base, column)->type;
+}
+
+int ColumnTableReader::findColumn(std::string_view name) const {
+    for (size_t i = 0; i < columnCount(); ++i) {
+        if (columnName(i) == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const void *ColumnTableReader::columnData(size_t column) const {
+    return base + columnInfo(base, column)->offset;
+}
+
+int64_t ColumnTableReader::value(size_t column, uint64_t row) const {
+    const void *data = columnData(column);
+    switch (columnType(column)) {
+        case COLUMN_U8: return ((const uint8_t *)data)[row];
+        case COLUMN_U16: return ((const uint16_t *)data)[row];
+        case COLUMN_U32: return ((const uint32_t *)data)[row];
+        case COLUMN_U64: return ((const uint64_t *)data)[row];
+        case COLUMN_I32: return ((const int32_t *)data)[row];
+        case COLUMN_I64: return ((const int64_t *)data)[row];
+        case COLUMN_STRING: return ((const uint32_t *)data)[row];
+    }
+    return 0;
+}
+
+std::string_view ColumnTableReader::string(size_t column, uint64_t row) const {
+    return dictionaryString(value(column, row));
+}
+
+std::string_view ColumnTableReader::dictionaryString(uint32_t id) const {
+    const ColumnFileHeader *header = (const ColumnFileHeader *)base;
+    if (id >= header->dictionaryCount) {
+        throw std::runtime_error("String id is out of bounds of the dictionary");
+    }
+    const uint64_t *offsets = (const uint64_t *)(base + header->dictionaryOffsetsOffset);
+    return std::string_view((const char *)base + header->dictionaryBytesOffset + offsets[id], offsets[id + 1] - offsets[id]);
+}
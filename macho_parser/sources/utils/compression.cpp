@@ -1,31 +1,43 @@
 #include <zlib.h>
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
 
 #include "utils.h"
 
-// This function is mostly written by ChatGPT.
-void decompressZlibData(const uint8_t *inputData, size_t inputSize, uint8_t *outputData, size_t outputSize) {
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
+std::vector<uint8_t> decompressZlibData(const uint8_t *inputData, size_t inputSize) {
+    z_stream strm = {};
     strm.avail_in = inputSize;
     strm.next_in = (Bytef*)inputData;
-    strm.avail_out = outputSize;
-    strm.next_out = (Bytef*)outputData;
 
-    int ret = inflateInit(&strm);
-    if (ret != Z_OK) {
-        std::cerr << "Error initializing zlib inflate: " << ret << std::endl;
-        return;
+    if (inflateInit(&strm) != Z_OK) {
+        throw std::runtime_error("Error initializing zlib inflate");
     }
 
-    ret = inflate(&strm, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        std::cerr << "Error decompressing zlib data: " << ret << std::endl;
-        inflateEnd(&strm);
-        return;
+    // Text compresses to roughly a third, so start there and double until the stream ends.
+    std::vector<uint8_t> output(std::max<size_t>(inputSize * 4, 256));
+    int ret;
+    while (true) {
+        strm.next_out = (Bytef*)(output.data() + strm.total_out);
+        strm.avail_out = output.size() - strm.total_out;
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END || (ret != Z_OK && ret != Z_BUF_ERROR)) {
+            break;
+        }
+        if (strm.avail_out > 0) {
+            // No progress is possible with output space left, so the input is truncated.
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        output.resize(output.size() * 2);
     }
 
+    size_t outputSize = strm.total_out;
     inflateEnd(&strm);
+    if (ret != Z_STREAM_END) {
+        throw std::runtime_error("Error decompressing zlib data: " + std::to_string(ret));
+    }
+
+    output.resize(outputSize);
+    return output;
 }
@@ -0,0 +1,19 @@
+#include <string.h>
+#include <stdexcept>
+
+#include "utils.h"
+
+const char *DataCursor::readCString() {
+    const uint8_t *null = ptr < end ? (const uint8_t *)memchr(ptr, '\0', end - ptr) : nullptr;
+    if (null == nullptr) {
+        throw std::runtime_error("A string runs past the end of the data");
+    }
+    const char *str = (const char *)ptr;
+    ptr = null + 1;
+    return str;
+}
+
+// Out of line, so the inline checks stay a compare and a rarely taken branch.
+void DataCursor::outOfBounds() {
+    throw std::runtime_error("Data is truncated or an offset is out of bounds");
+}
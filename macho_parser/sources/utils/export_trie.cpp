@@ -0,0 +1,252 @@
+#include <string.h>
+#include "apple/mach-o/loader.h"
+#include <stdexcept>
+
+#include "utils.h"
+
+// A node of a trie being built. Children are indexes into the list of nodes, so the list can grow.
+// Nodes are laid out in the order they are created, so a node split from an edge comes after the
+// nodes created before it, which is how the tries Apple's linker emits are laid out.
+struct ExportTrieNode {
+    struct Edge {
+        std::string label;
+        size_t child;
+    };
+
+    std::vector<Edge> edges;
+    std::vector<uint8_t> terminal;  // empty if no export ends at this node
+    uint64_t offset = 0;
+};
+
+static void decodeExportTerminal(DataCursor terminal, ExportRecord &record);
+static std::vector<uint8_t> encodeExportTerminal(const ExportTrieEntry &entry);
+static void insertExport(std::vector<ExportTrieNode> &nodes, std::string_view name, std::vector<uint8_t> terminal);
+static uint64_t exportTrieNodeSize(const std::vector<ExportTrieNode> &nodes, const ExportTrieNode &node);
+
+ExportTrieIterator::ExportTrieIterator(const uint8_t *trie, size_t size)
+    : trie(trie, size), hasPendingNode(size > 0) {
+}
+
+bool ExportTrieIterator::next() {
+    while (true) {
+        if (hasPendingNode) {
+            hasPendingNode = false;
+            trie.seek(pendingNode);
+
+            uint64_t terminalSize = trie.readULEB128();
+            DataCursor terminal = trie.subrange(trie.offset(), terminalSize);
+            trie.skip(terminalSize);
+            // A node takes at least two bytes, so a path can't be longer than half of the trie without a cycle.
+            if (stack.size() > trie.size() / 2) {
+                throw std::runtime_error("Malformed export trie, it has a cycle");
+            }
+
+            // According to the source code in dyld, the children count is not uleb128 encoded.
+            uint8_t childrenCount = trie.readByte();
+            stack.push_back({trie.offset(), childrenCount, prefix.size()});
+
+            if (terminalSize != 0) {
+                current = {};
+                current.name = prefix;
+                decodeExportTerminal(terminal, current);
+                return true;
+            }
+            continue;
+        }
+
+        if (stack.empty()) {
+            return false;
+        }
+
+        Frame &frame = stack.back();
+        if (frame.remaining == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        trie.seek(frame.edge);
+        prefix.resize(frame.prefixLength);
+        prefix.append(trie.readCString());
+
+        pendingNode = trie.readULEB128();
+        hasPendingNode = true;
+        frame.edge = trie.offset();
+        frame.remaining--;
+    }
+}
+
+bool lookupExportInTrie(const uint8_t *data, size_t size, std::string_view name, ExportRecord &record) {
+    DataCursor trie(data, size);
+    if (size == 0) {
+        return false;
+    }
+
+    std::string_view rest = name;
+    // A valid path visits every node at most once, so more steps than nodes means a cycle.
+    for (size_t steps = 0; steps <= size / 2; ++steps) {
+        uint64_t terminalSize = trie.readULEB128();
+        DataCursor terminal = trie.subrange(trie.offset(), terminalSize);
+        trie.skip(terminalSize);
+
+        if (rest.empty()) {
+            if (terminalSize == 0) {
+                return false;
+            }
+            record = {};
+            record.name = name;
+            decodeExportTerminal(terminal, record);
+            return true;
+        }
+
+        // Edges of the same node never share a first character, so at most one of them can match.
+        uint8_t childrenCount = trie.readByte();
+        bool found = false;
+        for (uint8_t i = 0; i < childrenCount && !found; ++i) {
+            std::string_view edge = trie.readCString();
+            uint64_t childOffset = trie.readULEB128();
+            if (!edge.empty() && rest.compare(0, edge.size(), edge) == 0) {
+                rest.remove_prefix(edge.size());
+                trie.seek(childOffset);
+                found = true;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+    }
+
+    throw std::runtime_error("Malformed export trie, it has a cycle");
+}
+
+std::vector<uint8_t> buildExportTrie(const std::vector<ExportTrieEntry> &entries) {
+    std::vector<ExportTrieNode> nodes(1);
+    for (const ExportTrieEntry &entry : entries) {
+        insertExport(nodes, entry.name, encodeExportTerminal(entry));
+    }
+
+    // The size of a node depends on the uleb128 size of its children's offsets, which depend on the size
+    // of the nodes before them. Like dyld and ld64, start from zero and recompute the offsets until none
+    // changes. They only ever grow, so this terminates, usually after two or three passes.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        uint64_t offset = 0;
+        for (ExportTrieNode &node : nodes) {
+            if (node.offset != offset) {
+                node.offset = offset;
+                changed = true;
+            }
+            offset += exportTrieNodeSize(nodes, node);
+        }
+    }
+
+    std::vector<uint8_t> trie;
+    for (const ExportTrieNode &node : nodes) {
+        writeULEB128(node.terminal.size(), trie);
+        trie.insert(trie.end(), node.terminal.begin(), node.terminal.end());
+        // According to the source code in dyld, the children count is not uleb128 encoded.
+        trie.push_back(node.edges.size());
+        for (const ExportTrieNode::Edge &edge : node.edges) {
+            trie.insert(trie.end(), edge.label.begin(), edge.label.end());
+            trie.push_back('\0');
+            writeULEB128(nodes[edge.child].offset, trie);
+        }
+    }
+
+    // ld64 pads the trie to the pointer size.
+    while (trie.size() % 8 != 0) {
+        trie.push_back(0);
+    }
+    return trie;
+}
+
+// Decode the terminal of a node into `record`.
+static void decodeExportTerminal(DataCursor terminal, ExportRecord &record) {
+    record.flags = terminal.readULEB128();
+    if (record.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        record.dylibOrdinal = terminal.readULEB128();
+        record.importName = terminal.readCString();
+    } else {
+        record.address = terminal.readULEB128();
+        if (record.flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+            record.resolver = terminal.readULEB128();
+        }
+    }
+}
+
+// The inverse of decodeExportTerminal().
+static std::vector<uint8_t> encodeExportTerminal(const ExportTrieEntry &entry) {
+    std::vector<uint8_t> terminal;
+    writeULEB128(entry.flags, terminal);
+    if (entry.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        writeULEB128(entry.dylibOrdinal, terminal);
+        terminal.insert(terminal.end(), entry.importName.begin(), entry.importName.end());
+        terminal.push_back('\0');
+    } else {
+        writeULEB128(entry.address, terminal);
+        if (entry.flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER) {
+            writeULEB128(entry.resolver, terminal);
+        }
+    }
+    return terminal;
+}
+
+// Follow the edges that match `name` from the root and put its terminal at the end. An edge that only
+// partially matches is split at the first difference, so edges of the same node never share a first character.
+static void insertExport(std::vector<ExportTrieNode> &nodes, std::string_view name, std::vector<uint8_t> terminal) {
+    std::string_view rest = name;
+    size_t node = 0;
+    while (!rest.empty()) {
+        size_t next = 0;
+        for (ExportTrieNode::Edge &edge : nodes[node].edges) {
+            size_t common = 0;
+            while (common < edge.label.size() && common < rest.size() && edge.label[common] == rest[common]) {
+                common++;
+            }
+            if (common == 0) {
+                continue;
+            }
+
+            rest.remove_prefix(common);
+            if (common == edge.label.size()) {
+                next = edge.child;
+                break;
+            }
+
+            ExportTrieNode middle;
+            middle.edges.push_back({edge.label.substr(common), edge.child});
+            edge.label.resize(common);
+            edge.child = next = nodes.size();
+            // This invalidates `edge`, so it must be the last thing done with it.
+            nodes.push_back(std::move(middle));
+            break;
+        }
+
+        if (next == 0) {
+            // No edge shares a prefix, so the rest of the name is a new edge to a leaf.
+            if (nodes[node].edges.size() == UINT8_MAX) {
+                throw std::runtime_error("Too many children in the export trie");
+            }
+            nodes[node].edges.push_back({std::string(rest), nodes.size()});
+            nodes.emplace_back();
+            next = nodes.size() - 1;
+            rest = std::string_view();
+        }
+        node = next;
+    }
+
+    if (!nodes[node].terminal.empty()) {
+        throw std::runtime_error("Duplicate export " + std::string(name));
+    }
+    nodes[node].terminal = std::move(terminal);
+}
+
+static uint64_t exportTrieNodeSize(const std::vector<ExportTrieNode> &nodes, const ExportTrieNode &node) {
+    // terminal size, terminal and children count
+    uint64_t size = sizeOfULEB128(node.terminal.size()) + node.terminal.size() + 1;
+    for (const ExportTrieNode::Edge &edge : node.edges) {
+        size += edge.label.size() + 1 + sizeOfULEB128(nodes[edge.child].offset);
+    }
+    return size;
+}
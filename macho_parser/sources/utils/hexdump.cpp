@@ -1,31 +1,31 @@
-#include <iostream>
-#include <iomanip>
+#include "utils.h"
 
-// Hex dump a range of memory to stdout
+// Hex dump a range of memory to textOutput()
 // This method is mostly written by ChatGPT
 void hexdump(uint32_t start, const void* data, size_t size)
 {
+    FILE *out = textOutput();
     const unsigned char* bytes = static_cast<const unsigned char*>(data);
     size_t offset = 0;
 
     for (size_t i = 0; i < size; i += 16)
     {
         // Print the current offset
-        std::cout << std::hex << std::setw(8) << std::setfill('0') << start + offset << ": ";
+        fprintf(out, "%08zx: ", start + offset);
 
         // Print hex values for this row
         for (size_t j = 0; j < 16; ++j)
         {
             if (i + j < size)
-                std::cout << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(bytes[i + j]);
+                fprintf(out, "%02x", bytes[i + j]);
             else
-                std::cout << "  ";
+                fputs("  ", out);
 
             if (j % 2 == 1)
-                std::cout << ' ';
+                fputc(' ', out);
         }
 
-        std::cout << ' ';
+        fputc(' ', out);
 
         // Print ASCII values for this row
         for (size_t j = 0; j < 16; ++j)
@@ -33,17 +33,17 @@ void hexdump(uint32_t start, const void* data, size_t size)
             if (i + j < size)
             {
                 if (bytes[i + j] >= 32 && bytes[i + j] <= 126)
-                    std::cout << static_cast<char>(bytes[i + j]);
+                    fputc(bytes[i + j], out);
                 else
-                    std::cout << '.';
+                    fputc('.', out);
             }
             else
             {
-                std::cout << ' ';
+                fputc(' ', out);
             }
         }
 
-        std::cout << '\n';
+        fputc('\n', out);
         offset += 16;
     }
 }
@@ -0,0 +1,146 @@
+#include <assert.h>
+
+#include "utils.h"
+
+void JsonWriter::beforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+
+    if (depth > 0) {
+        if (hasElement[depth - 1]) {
+            out.append(',');
+        }
+        hasElement[depth - 1] = true;
+    }
+}
+
+void JsonWriter::beginObject() {
+    beforeValue();
+    assert(depth < MAX_DEPTH);
+    out.append('{');
+    hasElement[depth++] = false;
+}
+
+void JsonWriter::endObject() {
+    assert(depth > 0);
+    out.append('}');
+    depth--;
+}
+
+void JsonWriter::beginArray() {
+    beforeValue();
+    assert(depth < MAX_DEPTH);
+    out.append('[');
+    hasElement[depth++] = false;
+}
+
+void JsonWriter::endArray() {
+    assert(depth > 0);
+    out.append(']');
+    depth--;
+}
+
+void JsonWriter::continueArray() {
+    assert(depth < MAX_DEPTH);
+    hasElement[depth++] = true;
+}
+
+void JsonWriter::key(std::string_view name) {
+    beforeValue();
+    writeString(name);
+    out.append(':');
+    afterKey = true;
+}
+
+void JsonWriter::string(std::string_view value) {
+    beforeValue();
+    writeString(value);
+}
+
+// The length of the UTF-8 sequence at `index`, or 0 if it's not a valid one. Overlong encodings, surrogates
+// and code points above U+10FFFF are invalid.
+static size_t utf8SequenceLength(std::string_view value, size_t index) {
+    unsigned char lead = value[index];
+    size_t length = lead < 0xc2 ? 0 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : lead < 0xf5 ? 4 : 0;
+    if (length == 0 || length > value.size() - index) {
+        return 0;
+    }
+
+    for (size_t i = 1; i < length; ++i) {
+        if (((unsigned char)value[index + i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+
+    unsigned char second = value[index + 1];
+    if ((lead == 0xe0 && second < 0xa0) || (lead == 0xed && second > 0x9f)
+        || (lead == 0xf0 && second < 0x90) || (lead == 0xf4 && second > 0x8f)) {
+        return 0;
+    }
+    return length;
+}
+
+void JsonWriter::writeString(std::string_view value) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out.append('"');
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = value[i];
+        if (c >= 0x80) {
+            size_t length = utf8SequenceLength(value, i);
+            if (length > 0) {
+                i += length - 1;
+                continue;
+            }
+        } else if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // flush the run of characters that don't need escaping
+        out.append(value.substr(runStart, i - runStart));
+        runStart = i + 1;
+
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                // a control character or a byte that isn't valid UTF-8
+                out.append("\\u00");
+                out.append(hexDigits[c >> 4]);
+                out.append(hexDigits[c & 0xf]);
+        }
+    }
+    out.append(value.substr(runStart));
+    out.append('"');
+}
+
+void JsonWriter::number(int64_t value) {
+    beforeValue();
+    out.appendDecimal(value);
+}
+
+void JsonWriter::boolean(bool value) {
+    beforeValue();
+    out.append(value ? "true" : "false");
+}
+
+void JsonWriter::hex(uint64_t value) {
+    beforeValue();
+    out.append("\"0x");
+    out.appendHex(value);
+    out.append('"');
+}
+
+void JsonWriter::newline() {
+    out.append('\n');
+}
+
+void JsonWriter::raw(std::string_view json) {
+    out.append(json);
+}
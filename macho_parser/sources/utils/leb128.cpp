@@ -1,12 +1,22 @@
+#include <string.h>
+#include <stdexcept>
+
 #include "utils.h"
 
+static int readLEB128(const uint8_t *p, const uint8_t *end, bool isSigned, uint64_t *out, int *shift);
+static int readLEB128Bytewise(const uint8_t *p, const uint8_t *end, int i, bool isSigned, uint64_t *out, int *shift);
+static uint64_t foldLEB128Word(uint64_t word);
+
 int readULEB128(const uint8_t *p, uint64_t *out) {
     uint64_t result = 0;
     int i = 0;
 
     do {
         uint8_t byte = *p & 0x7f;
-        result |= (uint64_t)byte << (i * 7);
+        // Shifting by 64 or more is undefined, so the extra bits of an overlong number are dropped.
+        if (i * 7 < 64) {
+            result |= (uint64_t)byte << (i * 7);
+        }
         i++;
     } while (*p++ & 0x80);
 
@@ -21,15 +31,148 @@ int readSLEB128(const uint8_t *p, int64_t *out) {
 
     do {
         byte = *p & 0x7f;
-        result |= byte << (i * 7);
+        if (i * 7 < 64) {
+            result |= (uint64_t)byte << (i * 7);
+        }
         i++;
     } while (*p++ & 0x80);
 
     // The sign bit is set
-    if (byte & 0x40) {
-        result |= (~0 << (i * 7));
+    if ((byte & 0x40) && i * 7 < 64) {
+        result |= ~0ULL << (i * 7);
+    }
+
+    *out = result;
+    return i;
+}
+
+int readULEB128(const uint8_t *p, const uint8_t *end, uint64_t *out) {
+    // Most numbers in opcodes and tries are a single byte.
+    if (p < end && !(*p & 0x80)) {
+        *out = *p;
+        return 1;
     }
 
+    int shift;
+    return readLEB128(p, end, false, out, &shift);
+}
+
+int readSLEB128(const uint8_t *p, const uint8_t *end, int64_t *out) {
+    uint64_t result;
+    int shift;
+    int length = readLEB128(p, end, true, &result, &shift);
+
+    // The sign bit is the highest bit of the last byte.
+    if (shift < 64 && (result >> (shift - 1)) & 1) {
+        result |= ~0ULL << shift;
+    }
+
+    *out = (int64_t)result;
+    return length;
+}
+
+// Decode the unsigned bits of a number. `shift` is set to the number of value bits read.
+static int readLEB128(const uint8_t *p, const uint8_t *end, bool isSigned, uint64_t *out, int *shift) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (end - p >= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        // The first byte without the continuation bit ends the number.
+        uint64_t stops = ~word & 0x8080808080808080ULL;
+        if (stops != 0) {
+            int length = __builtin_ctzll(stops) / 8 + 1;
+            // Keep the bytes up to and including the last one.
+            *out = foldLEB128Word(word & (stops ^ (stops - 1)));
+            *shift = length * 7;
+            return length;
+        }
+        // Longer than 8 bytes, the first 8 of which carry 56 bits.
+        *out = foldLEB128Word(word);
+        return readLEB128Bytewise(p, end, 8, isSigned, out, shift);
+    }
+#endif
+    *out = 0;
+    return readLEB128Bytewise(p, end, 0, isSigned, out, shift);
+}
+
+// Decode one byte at a time from p[i], checking every byte against `end`. The bits of the first `i` bytes
+// are already in `out`.
+static int readLEB128Bytewise(const uint8_t *p, const uint8_t *end, int i, bool isSigned, uint64_t *out, int *shift) {
+    uint64_t result = *out;
+    uint8_t byte;
+
+    do {
+        if (p + i >= end) {
+            throw std::runtime_error("LEB128 number runs past the end of the data");
+        }
+        byte = p[i];
+        uint64_t slice = byte & 0x7f;
+        if (i >= 9) {
+            // The 10th byte can only hold the highest bit, or all sign bits for a negative sleb128.
+            bool signBits = isSigned && i == 9 && slice == 0x7f;
+            if (i > 9 || (slice > 1 && !signBits)) {
+                throw std::runtime_error("LEB128 number is too big");
+            }
+        }
+        result |= slice << (i * 7);
+        i++;
+    } while (byte & 0x80);
+
     *out = result;
+    *shift = i * 7;
+    return i;
+}
+
+// Pack the low 7 bits of every byte of `word` together, the first byte being the lowest.
+static uint64_t foldLEB128Word(uint64_t word) {
+    word &= 0x7f7f7f7f7f7f7f7fULL;
+    // Close the gaps between pairs of bytes, then pairs of 14-bit groups, then of 28-bit groups.
+    word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+    word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+    word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+    return word;
+}
+
+int writeULEB128(uint64_t value, std::vector<uint8_t> &out) {
+    int i = 0;
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        out.push_back(byte);
+        i++;
+    } while (value != 0);
+
+    return i;
+}
+
+int writeSLEB128(int64_t value, std::vector<uint8_t> &out) {
+    int i = 0;
+    bool more = true;
+    while (more) {
+        uint8_t byte = value & 0x7f;
+        // arithmetic shift, so a negative value ends up as -1
+        value >>= 7;
+        // Done when the rest is all sign bits and the sign bit of this byte agrees with them.
+        more = !((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40)));
+        if (more) {
+            byte |= 0x80;
+        }
+        out.push_back(byte);
+        i++;
+    }
+
+    return i;
+}
+
+int sizeOfULEB128(uint64_t value) {
+    int i = 0;
+    do {
+        value >>= 7;
+        i++;
+    } while (value != 0);
+
     return i;
 }
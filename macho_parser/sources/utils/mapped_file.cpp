@@ -0,0 +1,63 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "utils/utils.h"
+
+MappedFile::MappedFile(const char *path) {
+    fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+    fileSize = sb.st_size;
+}
+
+MappedFile::~MappedFile() {
+    for (auto &window : windows) {
+        munmap(window.first, window.second);
+    }
+    close(fd);
+}
+
+uint8_t *MappedFile::map(uint64_t offset, uint64_t length) {
+    if (offset > fileSize || length > fileSize - offset) {
+        throw std::runtime_error("The range at offset " + std::to_string(offset) + " is out of bounds of the file.");
+    }
+
+    // mmap() requires the offset to be page aligned, and can't map an empty range.
+    uint64_t alignedOffset = offset & ~((uint64_t)getpagesize() - 1);
+    uint64_t mappedLength = std::max<uint64_t>(length + (offset - alignedOffset), 1);
+    uint8_t *mapped = (uint8_t *)mmap(NULL, mappedLength, PROT_READ, MAP_PRIVATE, fd, alignedOffset);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + std::to_string(length) + " bytes at offset " + std::to_string(offset) + ".");
+    }
+
+    windows.emplace_back(mapped, mappedLength);
+    return mapped + (offset - alignedOffset);
+}
+
+static void advise(const uint8_t *data, uint64_t length, int advice) {
+    if (length == 0) {
+        return;
+    }
+    uintptr_t pageMask = (uintptr_t)getpagesize() - 1;
+    uintptr_t start = (uintptr_t)data & ~pageMask;
+    uintptr_t end = ((uintptr_t)data + length + pageMask) & ~pageMask;
+    // Only a hint, so a failure doesn't matter.
+    madvise((void *)start, end - start, advice);
+}
+
+void MappedFile::adviseSequential(const uint8_t *data, uint64_t length) {
+    advise(data, length, MADV_SEQUENTIAL);
+}
+
+void MappedFile::release(const uint8_t *data, uint64_t length) {
+    advise(data, length, MADV_DONTNEED);
+}
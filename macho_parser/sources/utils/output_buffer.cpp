@@ -0,0 +1,99 @@
+#include <string.h>
+#include <algorithm>
+
+#include "utils.h"
+
+OutputBuffer::OutputBuffer(FILE *file, size_t capacity) : file(file), capacity(capacity) {
+    buffer = (char *)malloc(capacity);
+}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+    free(buffer);
+}
+
+void OutputBuffer::flush() {
+    if (size > 0) {
+        fwrite(buffer, 1, size, file);
+        size = 0;
+    }
+}
+
+// Make room for `count` more bytes. Anything longer than the whole buffer is written through by the caller.
+void OutputBuffer::reserve(size_t count) {
+    if (size + count > capacity) {
+        flush();
+    }
+}
+
+void OutputBuffer::append(char c) {
+    reserve(1);
+    buffer[size++] = c;
+}
+
+void OutputBuffer::appendSpaces(size_t count) {
+    while (count > 0) {
+        reserve(1);
+        size_t n = std::min(count, capacity - size);
+        memset(buffer + size, ' ', n);
+        size += n;
+        count -= n;
+    }
+}
+
+void OutputBuffer::append(std::string_view str, int width) {
+    size_t padding = (size_t)abs(width) > str.size() ? abs(width) - str.size() : 0;
+    if (width > 0) {
+        appendSpaces(padding);
+    }
+
+    if (str.size() > capacity) {
+        flush();
+        fwrite(str.data(), 1, str.size(), file);
+    } else {
+        reserve(str.size());
+        memcpy(buffer + size, str.data(), str.size());
+        size += str.size();
+    }
+
+    if (width < 0) {
+        appendSpaces(padding);
+    }
+}
+
+void OutputBuffer::appendDecimal(int64_t value, int width) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+
+    // Negate in unsigned arithmetic so that INT64_MIN doesn't overflow.
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    do {
+        *--p = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    append(std::string_view(p, end - p), width);
+}
+
+void OutputBuffer::appendHex(uint64_t value, int digits) {
+    static const char hexDigits[] = "0123456789abcdef";
+    char hex[16];
+    char *end = hex + sizeof(hex);
+    char *p = end;
+
+    do {
+        *--p = hexDigits[value & 0xf];
+        value >>= 4;
+    } while (value > 0);
+
+    for (int i = end - p; i < digits; ++i) {
+        append('0');
+    }
+
+    append(std::string_view(p, end - p));
+}
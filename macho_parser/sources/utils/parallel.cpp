@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils.h"
+
+// Each worker owns a range of indexes. The owner takes indexes from the front,
+// and an idle worker steals the back half of a victim's range.
+struct WorkRange {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+static bool popFront(WorkRange &range, size_t *index) {
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin >= range.end) {
+        return false;
+    }
+    *index = range.begin++;
+    return true;
+}
+
+static bool stealHalf(WorkRange &victim, size_t *begin, size_t *end) {
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.begin >= victim.end) {
+        return false;
+    }
+    size_t mid = victim.begin + (victim.end - victim.begin) / 2;
+    *begin = mid;
+    *end = victim.end;
+    victim.end = mid;
+    return true;
+}
+
+unsigned int defaultThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+void parallelFor(size_t count, std::function<void(size_t)> const& task, unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = defaultThreadCount();
+    }
+    threadCount = (unsigned int)std::min<size_t>(threadCount, count);
+
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    // Deal contiguous blocks so neighbouring indexes are likely processed by the same worker.
+    std::vector<WorkRange> ranges(threadCount);
+    for (unsigned int w = 0; w < threadCount; ++w) {
+        ranges[w].begin = count * w / threadCount;
+        ranges[w].end = count * (w + 1) / threadCount;
+    }
+
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+
+    auto worker = [&](unsigned int self) {
+        while (true) {
+            size_t index;
+            if (popFront(ranges[self], &index)) {
+                try {
+                    task(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!firstException) {
+                        firstException = std::current_exception();
+                    }
+                }
+                continue;
+            }
+
+            // No new work is ever added, so once every range is empty the worker can exit.
+            bool stolen = false;
+            for (unsigned int i = 1; i < threadCount && !stolen; ++i) {
+                size_t begin, end;
+                if (stealHalf(ranges[(self + i) % threadCount], &begin, &end)) {
+                    std::lock_guard<std::mutex> lock(ranges[self].mutex);
+                    ranges[self].begin = begin;
+                    ranges[self].end = end;
+                    stolen = true;
+                }
+            }
+
+            if (!stolen) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int w = 1; w < threadCount; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    worker(0);
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (firstException) {
+        std::rethrow_exception(firstException);
+    }
+}
@@ -0,0 +1,16 @@
+#include "utils.h"
+
+// nullptr means stdout, which isn't a constant expression
+static thread_local FILE *threadTextOutput = nullptr;
+
+FILE *textOutput() {
+    return threadTextOutput != nullptr ? threadTextOutput : stdout;
+}
+
+TextOutputScope::TextOutputScope(FILE *file) : previous(threadTextOutput) {
+    threadTextOutput = file;
+}
+
+TextOutputScope::~TextOutputScope() {
+    threadTextOutput = previous;
+}
@@ -1,27 +1,423 @@
 #ifndef MACHO_PARSER_UTILS_H
 #define MACHO_PARSER_UTILS_H
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 // Read a uleb128 number int to `out` and return the number of bytes processed.
-// This method assumes the input correctness and doesn't handle error cases.
+// This method doesn't know where the data ends, so it's only for trusted input. Bits past
+// the 64th are dropped. Use the bounded versions below or DataCursor for data from a file.
 int readULEB128(const uint8_t *p, uint64_t *out);
 
 // Read a sleb128 number int to `out` and return the number of bytes processed.
-// This method assumes the input correctness and doesn't handle error cases.
+// Like readULEB128(), it's only for trusted input.
 int readSLEB128(const uint8_t *p, int64_t *out);
 
-// Decompress that data using zlib.
-void decompressZlibData(const uint8_t *inputData, size_t inputSize, uint8_t *outputData, size_t outputSize);
+// Bounds-checked versions of the above for hot decoding loops. When at least 8 bytes are left, the number
+// is decoded from one 8-byte load, using the continuation bits to find its length, instead of byte by byte.
+// Near `end`, or for the bytes after the 8th, it falls back to a byte loop that checks every byte.
+// Throw std::runtime_error if the number runs past `end` or doesn't fit in 64 bits.
+int readULEB128(const uint8_t *p, const uint8_t *end, uint64_t *out);
+int readSLEB128(const uint8_t *p, const uint8_t *end, int64_t *out);
 
-// Hex dump a range of memory to stdout.
+// Append `value` uleb128 encoded to `out` and return the number of bytes appended.
+int writeULEB128(uint64_t value, std::vector<uint8_t> &out);
+
+// Append `value` sleb128 encoded to `out` and return the number of bytes appended.
+int writeSLEB128(int64_t value, std::vector<uint8_t> &out);
+
+// The number of bytes of `value` uleb128 encoded.
+int sizeOfULEB128(uint64_t value);
+
+// A read position in a range of untrusted bytes, such as a linkedit stream of a Mach-O file.
+// Every read checks the bytes it needs against the end of the range and throws std::runtime_error
+// instead of reading past it. The checks are inline and a read of a byte or of a one-byte LEB128
+// number is a single compare, so decoders can use it in their hot loops.
+//
+//     DataCursor cursor(data, size);
+//     while (!cursor.atEnd()) {
+//         uint8_t opcode = cursor.readByte();
+//         uint64_t operand = cursor.readULEB128();
+//     }
+class DataCursor {
+public:
+    DataCursor() : begin(nullptr), ptr(nullptr), end(nullptr) {}
+    DataCursor(const uint8_t *data, size_t size) : begin(data), ptr(data), end(data + size) {}
+
+    // A cursor over [offset, offset + size) of this range. Throw std::runtime_error if it doesn't fit.
+    DataCursor subrange(uint64_t offset, uint64_t size) const {
+        if (offset > (uint64_t)(end - begin) || size > (uint64_t)(end - begin) - offset) {
+            outOfBounds();
+        }
+        return DataCursor(begin + offset, size);
+    }
+
+    const uint8_t *data() const { return begin; }
+    size_t size() const { return end - begin; }
+    // The position from the start of the range.
+    size_t offset() const { return ptr - begin; }
+    size_t remaining() const { return end - ptr; }
+    bool atEnd() const { return ptr >= end; }
+
+    void seek(uint64_t offset) {
+        if (offset > size()) {
+            outOfBounds();
+        }
+        ptr = begin + offset;
+    }
+
+    void skip(uint64_t count) {
+        if (count > remaining()) {
+            outOfBounds();
+        }
+        ptr += count;
+    }
+
+    uint8_t readByte() {
+        if (ptr >= end) {
+            outOfBounds();
+        }
+        return *ptr++;
+    }
+
+    // Copy a T at the current position, which doesn't need to be aligned.
+    template <typename T>
+    T read() {
+        T value;
+        memcpy(&value, readBytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Return a pointer to the next `count` bytes and move past them.
+    const uint8_t *readBytes(uint64_t count) {
+        if (count > remaining()) {
+            outOfBounds();
+        }
+        const uint8_t *bytes = ptr;
+        ptr += count;
+        return bytes;
+    }
+
+    uint64_t readULEB128() {
+        if (ptr < end && *ptr < 0x80) {
+            return *ptr++;
+        }
+        uint64_t value;
+        ptr += ::readULEB128(ptr, end, &value);
+        return value;
+    }
+
+    int64_t readSLEB128() {
+        int64_t value;
+        ptr += ::readSLEB128(ptr, end, &value);
+        return value;
+    }
+
+    // Return the null-terminated string at the current position and move past its null.
+    // Throw std::runtime_error if there is no null before the end of the range.
+    const char *readCString();
+
+private:
+    const uint8_t *begin;
+    const uint8_t *ptr;
+    const uint8_t *end;
+
+    [[noreturn]] static void outOfBounds();
+};
+
+// Decompress zlib data whose decompressed size isn't known up front, growing the output as needed.
+// Throw std::runtime_error if the data isn't a complete zlib stream.
+std::vector<uint8_t> decompressZlibData(const uint8_t *inputData, size_t inputSize);
+
+// The number of hardware threads, at least 1.
+unsigned int defaultThreadCount();
+
+// Run `task(i)` for every i in [0, count) on a pool of worker threads and wait for all of them.
+// Each worker starts with a contiguous block of indexes and steals from the others when it runs out,
+// so uneven tasks still keep every core busy. A `threadCount` of 0 means one worker per hardware thread.
+// The first exception thrown by a task is rethrown after all workers finish.
+void parallelFor(size_t count, std::function<void(size_t)> const& task, unsigned int threadCount = 0);
+
+// The stream that the printers write text to. It's stdout unless the calling thread renders into
+// another stream with TextOutputScope, like the members of an archive that are printed in parallel.
+FILE *textOutput();
+
+// Redirect textOutput() of the calling thread to `file` until the scope ends.
+class TextOutputScope {
+public:
+    explicit TextOutputScope(FILE *file);
+    ~TextOutputScope();
+
+    TextOutputScope(const TextOutputScope &) = delete;
+    TextOutputScope &operator=(const TextOutputScope &) = delete;
+
+private:
+    FILE *previous;
+};
+
+// Hex dump a range of memory to textOutput().
 void hexdump(uint32_t start, const void* data, size_t size);
 
+// A writer that formats into one large buffer and only writes to `file` when the buffer is full,
+// on flush() or on destruction. Nothing is allocated after construction, so it's suitable for
+// printing millions of lines. Like printf, a positive `width` right-aligns the value with spaces
+// and a negative `width` left-aligns it. The value is never truncated.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(FILE *file = stdout, size_t capacity = 64 * 1024);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    void append(char c);
+    void append(std::string_view str, int width = 0);
+    void appendSpaces(size_t count);
+    void appendDecimal(int64_t value, int width = 0);
+    // Lowercase hex without the 0x prefix, zero padded to `digits`.
+    void appendHex(uint64_t value, int digits = 0);
+
+    void flush();
+
+private:
+    FILE *file;
+    char *buffer;
+    size_t capacity;
+    size_t size = 0;
+
+    void reserve(size_t count);
+};
+
+// A streaming JSON writer on top of OutputBuffer. Values are written as soon as they are added
+// and commas are inserted automatically, so no document is ever built in memory.
+// Multiple values at the top level are allowed, which is how NDJSON is written.
+class JsonWriter {
+public:
+    explicit JsonWriter(OutputBuffer &out) : out(out) {}
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    // Write the elements of an array that another writer opened and already wrote an element to,
+    // for elements that are rendered separately and later written after that writer's output.
+    // The array is closed by the other writer, not with endArray().
+    void continueArray();
+    // The key of the next value in the current object.
+    void key(std::string_view name);
+
+    // Valid UTF-8 is written as is. Every byte that isn't part of a valid UTF-8 sequence, which
+    // a malformed symbol or path may contain, is escaped as \u00XX, so the output is always valid JSON.
+    void string(std::string_view value);
+    void number(int64_t value);
+    void boolean(bool value);
+    // "0x1f" as a string because JSON numbers can't represent every 64-bit address.
+    void hex(uint64_t value);
+    // Whitespace between values, e.g. a newline after every NDJSON record.
+    void newline();
+    // JSON text that is already formatted, like the output of a writer that used continueArray().
+    void raw(std::string_view json);
+
+    void stringField(std::string_view name, std::string_view value) { key(name); string(value); }
+    void numberField(std::string_view name, int64_t value) { key(name); number(value); }
+    void boolField(std::string_view name, bool value) { key(name); boolean(value); }
+    void hexField(std::string_view name, uint64_t value) { key(name); hex(value); }
+
+private:
+    static const int MAX_DEPTH = 32;
+
+    OutputBuffer &out;
+    // Whether the object or array at each level already has an element and needs a comma before the next one.
+    bool hasElement[MAX_DEPTH] = {};
+    int depth = 0;
+    bool afterKey = false;
+
+    void beforeValue();
+    void writeString(std::string_view value);
+};
+
+// Columnar binary tables
+//
+// A table is written to one file: a header, a column directory, the column arrays and a string dictionary.
+// Every column is a plain little-endian array of rowCount values aligned to 8 bytes, so a reader can mmap
+// the file and use the arrays in place. String columns store uint32_t ids into the dictionary, which is
+// shared by all string columns of the table and keeps every distinct string once.
+enum ColumnType : uint32_t {
+    COLUMN_U8 = 1,
+    COLUMN_U16,
+    COLUMN_U32,
+    COLUMN_U64,
+    COLUMN_I32,
+    COLUMN_I64,
+    COLUMN_STRING,
+};
+
+class ColumnTableWriter {
+public:
+    // Add a column and return its index. All columns need to be added before any value.
+    size_t addColumn(const char *name, ColumnType type);
+
+    // Append a value to a numeric column. Signed values are stored in two's complement.
+    void append(size_t column, uint64_t value);
+    void appendString(size_t column, std::string_view value);
+
+    size_t rowCount() const;
+
+    // Throw std::runtime_error if the file can't be written or the columns have different lengths.
+    void write(const char *path) const;
+
+private:
+    struct Column {
+        std::string name;
+        ColumnType type;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Column> columns;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+};
+
+class ColumnTableReader {
+public:
+    // mmap the file. Throw std::runtime_error if it isn't a valid table.
+    explicit ColumnTableReader(const char *path);
+    ~ColumnTableReader();
+
+    ColumnTableReader(const ColumnTableReader &) = delete;
+    ColumnTableReader &operator=(const ColumnTableReader &) = delete;
+
+    uint64_t rowCount() const { return rows; }
+    size_t columnCount() const;
+    std::string_view columnName(size_t column) const;
+    ColumnType columnType(size_t column) const;
+    // Return the index of the column named `name`, or -1 if there is none.
+    int findColumn(std::string_view name) const;
+
+    // The column array, rowCount() values of the column's type.
+    const void *columnData(size_t column) const;
+
+    // The value of a numeric column or the string id of a string column. Signed types are sign extended.
+    int64_t value(size_t column, uint64_t row) const;
+    std::string_view string(size_t column, uint64_t row) const;
+    std::string_view dictionaryString(uint32_t id) const;
+
+private:
+    uint8_t *base = nullptr;
+    size_t size = 0;
+    uint64_t rows = 0;
+};
+
+// A read-only file that is mapped one window at a time, so the address space and memory used grow with
+// the parts of the file that are read rather than with its size. Windows stay mapped until the file is
+// destroyed, and pages are only read from disk when they are touched.
+class MappedFile {
+public:
+    // Open `path`. Throw std::runtime_error if it can't be read.
+    explicit MappedFile(const char *path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    uint64_t size() const { return fileSize; }
+
+    // Map [offset, offset + length) of the file. Throw std::runtime_error if it's out of bounds of the file
+    // or can't be mapped.
+    uint8_t *map(uint64_t offset, uint64_t length);
+
+    // madvise() hints for a range of a window, rounded out to whole pages. The kernel reads ahead more
+    // aggressively in a range that is scanned sequentially. Released pages are dropped from memory and
+    // read from the file again if they are touched later.
+    static void adviseSequential(const uint8_t *data, uint64_t length);
+    static void release(const uint8_t *data, uint64_t length);
+
+private:
+    int fd = -1;
+    uint64_t fileSize = 0;
+    // The page aligned start and length of every window.
+    std::vector<std::pair<uint8_t *, uint64_t>> windows;
+};
+
 // formatting
 std::string formatSize(uint64_t sizeInByte);
 std::string formatBufferToHex(const uint8_t *buffer, size_t bufferSize);
 std::string formatStringLiteral(const char *str);
 std::string formatVersion(uint32_t version);
 
+// One terminal node of the export trie.
+struct ExportRecord {
+    std::string_view name;
+    uint64_t flags;          // EXPORT_SYMBOL_FLAGS_*
+    // The offset of the symbol from the start of the image, or of the stub with
+    // EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER. Zero with EXPORT_SYMBOL_FLAGS_REEXPORT.
+    uint64_t address;
+    uint64_t resolver;       // EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER only
+    int dylibOrdinal;        // EXPORT_SYMBOL_FLAGS_REEXPORT only
+    const char *importName;  // EXPORT_SYMBOL_FLAGS_REEXPORT only, empty if it's the same as `name`, otherwise nullptr
+};
+
+// Walk an export trie depth first, in the same order as the trie is laid out, with an explicit stack
+// instead of recursion, so a deep trie can't overflow the call stack. The name of the current export
+// is kept in one prefix buffer that grows and shrinks with the walk, so nothing is allocated per node.
+//
+//     ExportTrieIterator it(trie, size);
+//     while (it.next()) {
+//         const ExportRecord &record = it.record();
+//     }
+class ExportTrieIterator {
+public:
+    ExportTrieIterator(const uint8_t *trie, size_t size);
+
+    // Move to the next export and return true, or return false at the end of the trie.
+    // Throw std::runtime_error if the trie is malformed.
+    bool next();
+
+    // The current export. The name is only valid until the next call to next().
+    const ExportRecord &record() const { return current; }
+
+private:
+    // A node whose children are being visited.
+    struct Frame {
+        uint64_t edge;          // the offset of the next child edge
+        uint8_t remaining;      // the number of children not visited yet
+        size_t prefixLength;    // the length of the name up to this node
+    };
+
+    DataCursor trie;
+    uint64_t pendingNode = 0;    // the offset of the node to visit on the next call
+    bool hasPendingNode;         // false to pop the stack instead
+    std::vector<Frame> stack;
+    std::string prefix;
+    ExportRecord current = {};
+};
+
+// Look up `name` in an export trie by following the edges from the root like dyld does, which takes
+// O(|name|) and decodes nothing but the matching terminal. Return false if it isn't exported.
+// The name of `record` is `name`. Throw std::runtime_error if the trie is malformed.
+bool lookupExportInTrie(const uint8_t *trie, size_t size, std::string_view name, ExportRecord &record);
+
+// One export to put in a trie, the owning counterpart of ExportRecord.
+struct ExportTrieEntry {
+    std::string name;
+    uint64_t flags;
+    uint64_t address;
+    uint64_t resolver;
+    int dylibOrdinal;
+    std::string importName;  // EXPORT_SYMBOL_FLAGS_REEXPORT only, empty if it's the same as `name`
+};
+
+// Encode `entries` into an export trie the way the linker does. Names are inserted in order, splitting
+// edges as needed, nodes are laid out in the order they are created, child offsets are fixed up iteratively
+// until the layout is stable, and the trie is padded to 8 bytes. Entries in the order ExportTrieIterator
+// yields them re-encode a linker-built trie to the same bytes. Throw std::runtime_error on a duplicate name.
+std::vector<uint8_t> buildExportTrie(const std::vector<ExportTrieEntry> &entries);
+
+
 #endif //MACHO_PARSER_UTILS_H
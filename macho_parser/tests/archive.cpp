@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <ar.h>
+#include "apple/mach-o/ranlib.h"
+#include <string>
+#include <utility>
+#include <vector>
+#include "core/ar_parser.h"
+
+template <typename T>
+static void appendInt(std::string &bytes, T value) {
+    bytes.append((const char *)&value, sizeof(T));
+}
+
+// A member with an ar_hdr. Names that are longer than 16 characters or have spaces are stored
+// after the header like BSD ar does, with "#1/" and their padded length as the name in the header.
+static std::string buildMember(const std::string &name, const std::string &content) {
+    std::string arName = name;
+    std::string longName;
+    if (name.size() > 16 || name.find(' ') != std::string::npos) {
+        longName = name;
+        longName.resize((name.size() + 8) & ~7, '\0');
+        arName = "#1/" + std::to_string(longName.size());
+    }
+    std::string padded = content;
+    padded.resize((content.size() + 7) & ~7, '\0');
+
+    char header[sizeof(struct ar_hdr) + 1];
+    snprintf(header, sizeof(header), "%-16s%-12d%-6d%-6d%-8o%-10zu`\n", arName.c_str(), 0, 0, 0, 0644, longName.size() + padded.size());
+    return std::string(header, sizeof(struct ar_hdr)) + longName + padded;
+}
+
+// The content of a symbol table that maps `symbols` to members at `offsets`, in the given order.
+template <typename Ranlib, typename Size>
+static std::string buildSymbolTable(const std::vector<std::pair<std::string, int>> &symbols, const std::vector<uint64_t> &offsets) {
+    std::string ranlibs, strings;
+    for (const auto &[name, member] : symbols) {
+        Ranlib ranlib = {};
+        ranlib.ran_un.ran_strx = strings.size();
+        ranlib.ran_off = offsets[member];
+        appendInt(ranlibs, ranlib);
+        strings += name + '\0';
+    }
+    strings.resize((strings.size() + 7) & ~7, '\0');
+
+    std::string content;
+    appendInt<Size>(content, ranlibs.size());
+    content += ranlibs;
+    appendInt<Size>(content, strings.size());
+    return content + strings;
+}
+
+// An archive whose first member is the symbol table `symdefName`. Set `offsets` to the header offsets of `members`.
+static std::string buildArchive(const std::string &symdefName, const std::vector<std::pair<std::string, int>> &symbols,
+    const std::vector<std::pair<std::string, std::string>> &members, std::vector<uint64_t> &offsets) {
+    bool is64 = symdefName.compare(0, strlen(SYMDEF_64), SYMDEF_64) == 0;
+    auto symbolTable = [&]() {
+        return is64 ? buildSymbolTable<struct ranlib_64, uint64_t>(symbols, offsets)
+            : buildSymbolTable<struct ranlib, uint32_t>(symbols, offsets);
+    };
+
+    // The size of the symbol table doesn't depend on the offsets, so lay out the members first.
+    offsets.assign(members.size(), 0);
+    uint64_t offset = SARMAG + buildMember(symdefName, symbolTable()).size();
+    for (size_t i = 0; i < members.size(); ++i) {
+        offsets[i] = offset;
+        offset += buildMember(members[i].first, members[i].second).size();
+    }
+
+    std::string archive = std::string(ARMAG, SARMAG) + buildMember(symdefName, symbolTable());
+    for (const auto &[name, content] : members) {
+        archive += buildMember(name, content);
+    }
+    return archive;
+}
+
+static std::vector<std::pair<std::string, std::string>> members = {
+    {"a.o", "first"}, {"b.o", "second"}, {"c.o", "third"},
+};
+
+TEST(Archive, SymbolTable) {
+    std::vector<uint64_t> offsets;
+    // _b is defined twice. The linker takes the first definition.
+    std::string archive = buildArchive(SYMDEF, {{"_c", 2}, {"_a", 0}, {"_b", 1}, {"_b", 2}}, members, offsets);
+    Archive::SymbolTable table((uint8_t *)archive.data(), archive.size());
+    ASSERT_TRUE(table.isValid());
+    EXPECT_FALSE(table.isSorted());
+    EXPECT_EQ(table.size(), 4);
+
+    uint64_t headerOffset = 0;
+    ASSERT_TRUE(table.findMember("_a", &headerOffset));
+    EXPECT_EQ(headerOffset, offsets[0]);
+    ASSERT_TRUE(table.findMember("_b", &headerOffset));
+    EXPECT_EQ(headerOffset, offsets[1]);
+    ASSERT_TRUE(table.findMember("_c", &headerOffset));
+    EXPECT_EQ(headerOffset, offsets[2]);
+    EXPECT_FALSE(table.findMember("_d", &headerOffset));
+    EXPECT_FALSE(table.findMember("", &headerOffset));
+}
+
+TEST(Archive, SortedSymbolTable) {
+    std::vector<std::pair<std::string, int>> symbols = {{"_b", 0}, {"_d", 1}, {"_f", 2}, {"_h", 0}, {"_j", 1}};
+    for (const char *symdefName : {SYMDEF_SORTED, SYMDEF_64_SORTED}) {
+        std::vector<uint64_t> offsets;
+        std::string archive = buildArchive(symdefName, symbols, members, offsets);
+        Archive::SymbolTable table((uint8_t *)archive.data(), archive.size());
+        ASSERT_TRUE(table.isValid()) << symdefName;
+        EXPECT_TRUE(table.isSorted());
+        EXPECT_EQ(table.size(), symbols.size());
+
+        // Both ends and the middle of the binary search, and misses before, between and after the symbols.
+        for (const auto &[name, member] : symbols) {
+            uint64_t headerOffset = 0;
+            ASSERT_TRUE(table.findMember(name, &headerOffset)) << name;
+            EXPECT_EQ(headerOffset, offsets[member]) << name;
+        }
+        uint64_t headerOffset = 0;
+        for (const char *missing : {"_a", "_c", "_e", "_i", "_k", "_b_", ""}) {
+            EXPECT_FALSE(table.findMember(missing, &headerOffset)) << missing;
+        }
+    }
+}
+
+TEST(Archive, SymbolTable64) {
+    std::vector<uint64_t> offsets;
+    std::string archive = buildArchive(SYMDEF_64, {{"_x", 1}, {"_y", 2}}, members, offsets);
+    Archive::SymbolTable table((uint8_t *)archive.data(), archive.size());
+    ASSERT_TRUE(table.isValid());
+    EXPECT_FALSE(table.isSorted());
+
+    uint64_t headerOffset = 0;
+    ASSERT_TRUE(table.findMember("_y", &headerOffset));
+    EXPECT_EQ(headerOffset, offsets[2]);
+    EXPECT_FALSE(table.findMember("_z", &headerOffset));
+}
+
+TEST(Archive, NoSymbolTable) {
+    std::string archive = std::string(ARMAG, SARMAG) + buildMember("a.o", "first");
+    Archive::SymbolTable table((uint8_t *)archive.data(), archive.size());
+    EXPECT_FALSE(table.isValid());
+    uint64_t headerOffset = 0;
+    EXPECT_FALSE(table.findMember("_a", &headerOffset));
+
+    // A symbol table that is cut short is treated as missing.
+    std::vector<uint64_t> offsets;
+    std::string truncated = buildArchive(SYMDEF, {{"_a", 0}}, members, offsets);
+    Archive::SymbolTable truncatedTable((uint8_t *)truncated.data(), SARMAG + sizeof(struct ar_hdr) + 4);
+    EXPECT_FALSE(truncatedTable.isValid());
+}
+
+TEST(Archive, IndexMembers) {
+    // Short names are in the header. Long names and names with spaces are stored as #1/NN.
+    std::vector<std::pair<std::string, std::string>> objects = {
+        {"short.o", "one"},
+        {"a_long_object_file_name.o", "two"},
+        {"with space.o", "three"},
+    };
+    std::vector<uint64_t> offsets;
+    std::string archive = buildArchive(SYMDEF_SORTED, {{"_a", 0}}, objects, offsets);
+
+    std::vector<Archive::Member> indexed = Archive::indexMembers((uint8_t *)archive.data(), archive.size());
+    ASSERT_EQ(indexed.size(), objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        EXPECT_EQ(indexed[i].name, objects[i].first);
+        EXPECT_EQ(indexed[i].headerOffset, offsets[i]);
+        // The content starts after the long name and is padded to 8 bytes.
+        std::string content((const char *)indexed[i].base, objects[i].second.size());
+        EXPECT_EQ(content, objects[i].second);
+        EXPECT_EQ(indexed[i].size, (objects[i].second.size() + 7) & ~7);
+    }
+
+    // A member that runs past the end of the archive ends it.
+    std::vector<Archive::Member> truncated = Archive::indexMembers((uint8_t *)archive.data(), archive.size() - 1);
+    ASSERT_EQ(truncated.size(), 2);
+    EXPECT_EQ(truncated[1].name, objects[1].first);
+}
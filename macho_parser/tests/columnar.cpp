@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "utils/utils.h"
+
+static std::string tempPath(const char *name) {
+    return std::string(::testing::TempDir()) + name;
+}
+
+TEST(Columnar, RoundTrip) {
+    std::string path = tempPath("columnar_round_trip.col");
+
+    ColumnTableWriter writer;
+    size_t index = writer.addColumn("index", COLUMN_U32);
+    size_t name = writer.addColumn("name", COLUMN_STRING);
+    size_t address = writer.addColumn("address", COLUMN_U64);
+    size_t addend = writer.addColumn("addend", COLUMN_I64);
+    size_t type = writer.addColumn("type", COLUMN_U8);
+
+    const char *names[] = {"_main", "_printf", "_main"};
+    for (int i = 0; i < 3; ++i) {
+        writer.append(index, i);
+        writer.appendString(name, names[i]);
+        writer.append(address, 0x100000000ULL + i * 0x10);
+        writer.append(addend, -i);
+        writer.append(type, 0xf0 + i);
+    }
+    EXPECT_EQ(writer.rowCount(), 3);
+    writer.write(path.c_str());
+
+    ColumnTableReader reader(path.c_str());
+    EXPECT_EQ(reader.rowCount(), 3);
+    EXPECT_EQ(reader.columnCount(), 5);
+    EXPECT_EQ(reader.columnName(name), "name");
+    EXPECT_EQ(reader.columnType(address), COLUMN_U64);
+    EXPECT_EQ(reader.findColumn("addend"), addend);
+    EXPECT_EQ(reader.findColumn("missing"), -1);
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(reader.value(index, i), i);
+        EXPECT_EQ(reader.string(name, i), names[i]);
+        EXPECT_EQ(reader.value(address, i), 0x100000000LL + i * 0x10);
+        EXPECT_EQ(reader.value(addend, i), -i);
+        EXPECT_EQ(reader.value(type, i), 0xf0 + i);
+    }
+
+    // Equal strings share one dictionary entry.
+    EXPECT_EQ(reader.value(name, 0), reader.value(name, 2));
+    EXPECT_EQ(reader.dictionaryString(1), "_printf");
+
+    // Columns are usable in place.
+    const uint64_t *addresses = (const uint64_t *)reader.columnData(address);
+    EXPECT_EQ((uintptr_t)addresses % 8, 0);
+    EXPECT_EQ(addresses[2], 0x100000020ULL);
+}
+
+TEST(Columnar, EmptyTable) {
+    std::string path = tempPath("columnar_empty.col");
+
+    ColumnTableWriter writer;
+    writer.addColumn("name", COLUMN_STRING);
+    writer.write(path.c_str());
+
+    ColumnTableReader reader(path.c_str());
+    EXPECT_EQ(reader.rowCount(), 0);
+    EXPECT_EQ(reader.columnCount(), 1);
+}
+
+TEST(Columnar, UnevenColumns) {
+    ColumnTableWriter writer;
+    size_t a = writer.addColumn("a", COLUMN_U32);
+    writer.addColumn("b", COLUMN_U32);
+    writer.append(a, 1);
+    EXPECT_THROW(writer.write(tempPath("columnar_uneven.col").c_str()), std::runtime_error);
+}
+
+TEST(Columnar, InvalidFile) {
+    std::string path = tempPath("columnar_invalid.col");
+    FILE *file = fopen(path.c_str(), "wb");
+    fputs("this is not a column table, just some text", file);
+    fclose(file);
+
+    EXPECT_THROW(ColumnTableReader reader(path.c_str()), std::runtime_error);
+}
@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include "utils/utils.h"
+
+static std::vector<uint8_t> compress(const std::string &text) {
+    uLongf size = compressBound(text.size());
+    std::vector<uint8_t> compressed(size);
+    compress2(compressed.data(), &size, (const Bytef *)text.data(), text.size(), Z_BEST_COMPRESSION);
+    compressed.resize(size);
+    return compressed;
+}
+
+TEST(Compression, DecompressUnknownSize) {
+    std::string text;
+    for (int i = 0; i < 10000; ++i) {
+        text += "_symbol" + std::to_string(i) + '\0';
+    }
+    // Repetitive text compresses far better than the initial guess, so the output has to grow.
+    std::vector<uint8_t> compressed = compress(text);
+    std::vector<uint8_t> decompressed = decompressZlibData(compressed.data(), compressed.size());
+
+    EXPECT_EQ(std::string(decompressed.begin(), decompressed.end()), text);
+}
+
+TEST(Compression, DecompressEmpty) {
+    std::vector<uint8_t> compressed = compress("");
+    EXPECT_TRUE(decompressZlibData(compressed.data(), compressed.size()).empty());
+}
+
+TEST(Compression, DecompressTruncated) {
+    std::vector<uint8_t> compressed = compress(std::string(1000, 'a') + "b");
+    EXPECT_THROW(decompressZlibData(compressed.data(), compressed.size() / 2), std::runtime_error);
+    uint8_t garbage[] = {0x01, 0x02, 0x03, 0x04};
+    EXPECT_THROW(decompressZlibData(garbage, sizeof(garbage)), std::runtime_error);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "apple/mach-o/loader.h"
+#include <random>
+#include <zlib.h>
+#include "utils/utils.h"
+
+TEST(DataCursor, Reads) {
+    uint8_t bytes[] = {0x01, 0x78, 0x56, 0x34, 0x12, 0xE5, 0x8E, 0x26, 0xC0, 0xBB, 0x78, 'a', 'b', 0x00, 0xFF};
+    DataCursor cursor(bytes, sizeof(bytes));
+
+    EXPECT_EQ(cursor.readByte(), 0x01);
+    EXPECT_EQ(cursor.read<uint32_t>(), 0x12345678);
+    EXPECT_EQ(cursor.readULEB128(), 624485);
+    EXPECT_EQ(cursor.readSLEB128(), -123456);
+    EXPECT_STREQ(cursor.readCString(), "ab");
+    EXPECT_EQ(cursor.offset(), 14);
+    EXPECT_EQ(cursor.remaining(), 1);
+    EXPECT_FALSE(cursor.atEnd());
+    EXPECT_EQ(cursor.readByte(), 0xFF);
+    EXPECT_TRUE(cursor.atEnd());
+}
+
+TEST(DataCursor, OutOfBounds) {
+    uint8_t bytes[] = {0x01, 0x02, 'a', 0x80};
+    DataCursor cursor(bytes, sizeof(bytes));
+
+    EXPECT_THROW(cursor.read<uint64_t>(), std::runtime_error);
+    EXPECT_THROW(cursor.skip(5), std::runtime_error);
+    EXPECT_THROW(cursor.seek(5), std::runtime_error);
+    EXPECT_EQ(cursor.offset(), 0);
+
+    cursor.seek(2);
+    EXPECT_THROW(cursor.readCString(), std::runtime_error);
+    cursor.seek(3);
+    EXPECT_THROW(cursor.readULEB128(), std::runtime_error);
+    cursor.seek(3);
+    EXPECT_THROW(cursor.readSLEB128(), std::runtime_error);
+    cursor.seek(4);
+    EXPECT_THROW(cursor.readByte(), std::runtime_error);
+    EXPECT_THROW(DataCursor().readByte(), std::runtime_error);
+}
+
+TEST(DataCursor, Subrange) {
+    uint8_t bytes[] = {0x00, 0x01, 0x02, 0x03, 0x04};
+    DataCursor cursor(bytes, sizeof(bytes));
+
+    DataCursor sub = cursor.subrange(1, 3);
+    EXPECT_EQ(sub.data(), bytes + 1);
+    EXPECT_EQ(sub.size(), 3);
+    EXPECT_EQ(sub.readByte(), 0x01);
+    sub.skip(2);
+    EXPECT_THROW(sub.readByte(), std::runtime_error);
+
+    EXPECT_EQ(cursor.subrange(5, 0).size(), 0);
+    EXPECT_THROW(cursor.subrange(6, 0), std::runtime_error);
+    EXPECT_THROW(cursor.subrange(1, 5), std::runtime_error);
+    EXPECT_THROW(cursor.subrange(1, UINT64_MAX), std::runtime_error);
+}
+
+// A deterministic fuzzer over the decoders of untrusted data: every truncation of a valid input, then
+// random byte flips, insertions and deletions. A decoder may throw std::runtime_error, but never read
+// outside of its input, which a build with -fsanitize=address catches.
+static void fuzz(const std::vector<uint8_t> &seed, std::function<void(const std::vector<uint8_t> &)> const& decode) {
+    auto run = [&decode](const std::vector<uint8_t> &input) {
+        // Copy to a buffer of the exact size, so a read past the end is a read past the allocation.
+        std::vector<uint8_t> exact(input);
+        exact.shrink_to_fit();
+        try {
+            decode(exact);
+        } catch (const std::runtime_error &) {
+        }
+    };
+
+    for (size_t size = 0; size <= seed.size(); ++size) {
+        run(std::vector<uint8_t>(seed.begin(), seed.begin() + size));
+    }
+
+    std::mt19937 random(20);
+    for (int i = 0; i < 2000; ++i) {
+        std::vector<uint8_t> input = seed;
+        int mutations = 1 + random() % 4;
+        for (int j = 0; j < mutations && !input.empty(); ++j) {
+            size_t at = random() % input.size();
+            switch (random() % 4) {
+                case 0: input[at] ^= 1 << (random() % 8); break;
+                case 1: input[at] = random(); break;
+                case 2: input.insert(input.begin() + at, (uint8_t)random()); break;
+                case 3: input.erase(input.begin() + at); break;
+            }
+        }
+        run(input);
+    }
+}
+
+TEST(DataCursor, FuzzLEB128) {
+    std::vector<uint8_t> seed;
+    for (uint64_t value : std::vector<uint64_t>{0, 0x7F, 0x80, 624485, 0xFFFFFFFF, UINT64_MAX}) {
+        writeULEB128(value, seed);
+    }
+    for (int64_t value : std::vector<int64_t>{-1, -123456, INT64_MIN, INT64_MAX}) {
+        writeSLEB128(value, seed);
+    }
+
+    fuzz(seed, [](const std::vector<uint8_t> &input) {
+        DataCursor unsignedCursor(input.data(), input.size());
+        while (!unsignedCursor.atEnd()) {
+            unsignedCursor.readULEB128();
+        }
+        DataCursor signedCursor(input.data(), input.size());
+        while (!signedCursor.atEnd()) {
+            signedCursor.readSLEB128();
+        }
+    });
+}
+
+TEST(DataCursor, FuzzExportTrie) {
+    std::vector<uint8_t> seed = buildExportTrie({
+        {"_foo", EXPORT_SYMBOL_FLAGS_KIND_REGULAR, 0x1000, 0, 0, ""},
+        {"_foobar", EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION, 0x123456789, 0, 0, ""},
+        {"_fob", EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER, 0x2000, 0x2040, 0, ""},
+        {"_f", EXPORT_SYMBOL_FLAGS_REEXPORT, 0, 0, 2, "_other"},
+        {"_tls", EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL, 0x30, 0, 0, ""},
+    });
+
+    fuzz(seed, [](const std::vector<uint8_t> &input) {
+        ExportTrieIterator it(input.data(), input.size());
+        while (it.next()) {
+            const ExportRecord &record = it.record();
+            if (record.importName != nullptr) {
+                EXPECT_GE(record.importName, (const char *)input.data());
+                EXPECT_LT(record.importName + strlen(record.importName), (const char *)input.data() + input.size());
+            }
+        }
+
+        ExportRecord record;
+        for (const char *name : {"_foobar", "_f", "_tls", "_missing"}) {
+            lookupExportInTrie(input.data(), input.size(), name, record);
+        }
+    });
+}
+
+TEST(DataCursor, FuzzZlib) {
+    std::string text = "_main\1_foo\1_bar\1_foobar";
+    uLongf size = compressBound(text.size());
+    std::vector<uint8_t> seed(size);
+    compress2(seed.data(), &size, (const Bytef *)text.data(), text.size(), Z_BEST_COMPRESSION);
+    seed.resize(size);
+
+    fuzz(seed, [](const std::vector<uint8_t> &input) {
+        decompressZlibData(input.data(), input.size());
+    });
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "apple/mach-o/loader.h"
+#include "utils/utils.h"
+
+static std::vector<ExportTrieEntry> decode(const std::vector<uint8_t> &trie) {
+    std::vector<ExportTrieEntry> entries;
+    ExportTrieIterator it(trie.data(), trie.size());
+    while (it.next()) {
+        const ExportRecord &record = it.record();
+        entries.push_back({std::string(record.name), record.flags, record.address, record.resolver,
+            record.dylibOrdinal, record.importName != nullptr ? record.importName : ""});
+    }
+    return entries;
+}
+
+static void expectSameEntries(const std::vector<ExportTrieEntry> &actual, const std::vector<ExportTrieEntry> &expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].name, expected[i].name);
+        EXPECT_EQ(actual[i].flags, expected[i].flags);
+        EXPECT_EQ(actual[i].address, expected[i].address);
+        EXPECT_EQ(actual[i].resolver, expected[i].resolver);
+        EXPECT_EQ(actual[i].dylibOrdinal, expected[i].dylibOrdinal);
+        EXPECT_EQ(actual[i].importName, expected[i].importName);
+    }
+}
+
+// The trie of tests/fixtures/code_signature/main_sha256, as emitted by the linker.
+static const std::vector<uint8_t> linkerTrie = {
+    0x00, 0x01, 0x5f, 0x00, 0x09, 0x02, 0x00, 0x00, 0x00, 0x00, 0x02, 0x5f, 0x6d, 0x68, 0x5f, 0x65,
+    0x78, 0x65, 0x63, 0x75, 0x74, 0x65, 0x5f, 0x68, 0x65, 0x61, 0x64, 0x65, 0x72, 0x00, 0x05, 0x6d,
+    0x61, 0x69, 0x6e, 0x00, 0x25, 0x03, 0x00, 0xd4, 0x7b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+TEST(ExportTrie, DecodeLinkerTrie) {
+    expectSameEntries(decode(linkerTrie), {
+        {"__mh_execute_header", 0, 0, 0, 0, ""},
+        {"_main", 0, 0x3dd4, 0, 0, ""},
+    });
+}
+
+TEST(ExportTrie, ReencodeLinkerTrie) {
+    EXPECT_EQ(buildExportTrie(decode(linkerTrie)), linkerTrie);
+}
+
+TEST(ExportTrie, RoundTripAllKinds) {
+    std::vector<ExportTrieEntry> entries = {
+        {"_foo", EXPORT_SYMBOL_FLAGS_KIND_REGULAR, 0x1000, 0, 0, ""},
+        {"_foobar", EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION, 0x1010, 0, 0, ""},
+        {"_fob", EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER, 0x2000, 0x2040, 0, ""},
+        {"_f", EXPORT_SYMBOL_FLAGS_REEXPORT, 0, 0, 2, "_other"},
+        {"_g", EXPORT_SYMBOL_FLAGS_REEXPORT, 0, 0, 1, ""},
+        {"_tls", EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL, 0x30, 0, 0, ""},
+        {"", EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE, 0x42, 0, 0, ""},
+    };
+    std::vector<uint8_t> trie = buildExportTrie(entries);
+    EXPECT_EQ(trie.size() % 8, 0);
+
+    // The iterator yields the exports in trie order, which isn't the insertion order, so compare by lookup.
+    EXPECT_EQ(decode(trie).size(), entries.size());
+    for (const ExportTrieEntry &entry : entries) {
+        ExportRecord record;
+        ASSERT_TRUE(lookupExportInTrie(trie.data(), trie.size(), entry.name, record)) << entry.name;
+        EXPECT_EQ(record.name, entry.name);
+        EXPECT_EQ(record.flags, entry.flags);
+        EXPECT_EQ(record.address, entry.address);
+        EXPECT_EQ(record.resolver, entry.resolver);
+        EXPECT_EQ(record.dylibOrdinal, entry.dylibOrdinal);
+        if (entry.flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+            EXPECT_STREQ(record.importName, entry.importName.c_str());
+        }
+    }
+
+    // In trie order, decode(encode(x)) == x exactly.
+    std::vector<ExportTrieEntry> decoded = decode(trie);
+    expectSameEntries(decode(buildExportTrie(decoded)), decoded);
+}
+
+TEST(ExportTrie, RoundTripLargeOffsets) {
+    // Enough nodes that child offsets need 2 and 3 byte uleb128s, so the layout takes several passes.
+    std::vector<ExportTrieEntry> entries;
+    for (int i = 0; i < 20000; ++i) {
+        entries.push_back({"_symbol" + std::to_string(i * 7919 % 20000), 0, (uint64_t)i * 16, 0, 0, ""});
+    }
+    std::vector<uint8_t> trie = buildExportTrie(entries);
+    EXPECT_GT(trie.size(), (size_t)0x4000);
+
+    std::vector<ExportTrieEntry> decoded = decode(trie);
+    EXPECT_EQ(decoded.size(), entries.size());
+    expectSameEntries(decode(buildExportTrie(decoded)), decoded);
+
+    for (const ExportTrieEntry &entry : entries) {
+        ExportRecord record;
+        ASSERT_TRUE(lookupExportInTrie(trie.data(), trie.size(), entry.name, record));
+        EXPECT_EQ(record.address, entry.address);
+    }
+}
+
+TEST(ExportTrie, Lookup) {
+    ExportRecord record;
+    EXPECT_TRUE(lookupExportInTrie(linkerTrie.data(), linkerTrie.size(), "_main", record));
+    EXPECT_EQ(record.address, 0x3dd4);
+    // Prefixes and extensions of an export aren't exports.
+    EXPECT_FALSE(lookupExportInTrie(linkerTrie.data(), linkerTrie.size(), "_", record));
+    EXPECT_FALSE(lookupExportInTrie(linkerTrie.data(), linkerTrie.size(), "_mai", record));
+    EXPECT_FALSE(lookupExportInTrie(linkerTrie.data(), linkerTrie.size(), "_mainx", record));
+    EXPECT_FALSE(lookupExportInTrie(linkerTrie.data(), 0, "_main", record));
+}
+
+TEST(ExportTrie, Empty) {
+    std::vector<uint8_t> trie = buildExportTrie({});
+    EXPECT_TRUE(decode(trie).empty());
+}
+
+TEST(ExportTrie, DuplicateName) {
+    EXPECT_THROW(buildExportTrie({{"_a", 0, 1, 0, 0, ""}, {"_a", 0, 2, 0, 0, ""}}), std::runtime_error);
+}
+
+TEST(ExportTrie, Malformed) {
+    // The only child of the root points back to the root.
+    std::vector<uint8_t> cycle = {0x00, 0x01, 'a', 0x00, 0x00};
+    EXPECT_THROW(decode(cycle), std::runtime_error);
+    ExportRecord record;
+    EXPECT_THROW(lookupExportInTrie(cycle.data(), cycle.size(), "aaaaaaaa", record), std::runtime_error);
+
+    // The terminal is larger than the trie.
+    std::vector<uint8_t> truncated = {0x05, 0x00, 0x01};
+    EXPECT_THROW(decode(truncated), std::runtime_error);
+
+    // The edge isn't terminated.
+    std::vector<uint8_t> edge = {0x00, 0x01, 'a', 'b'};
+    EXPECT_THROW(decode(edge), std::runtime_error);
+}
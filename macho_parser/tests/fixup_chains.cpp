@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <zlib.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "core/fixup_chains.h"
+#include "test_image.h"
+
+template <typename T>
+static void append(std::vector<uint8_t> &bytes, T value) {
+    size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(T));
+    memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static void put(std::vector<uint8_t> &bytes, size_t offset, T value) {
+    memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+// The payload of LC_DYLD_CHAINED_FIXUPS of an image with __TEXT and __DATA, where only
+// the first page of __DATA has fixups.
+struct ChainedFixups {
+    explicit ChainedFixups(uint16_t pointerFormat) : pointerFormat(pointerFormat) {}
+
+    uint16_t pointerFormat;
+    uint64_t segmentOffset = 0;
+    // page_start[0], followed by the chain starts of a DYLD_CHAINED_PTR_START_MULTI page
+    std::vector<uint16_t> pageStarts = {0};
+    uint32_t maxValidPointer = 0;
+    uint32_t importsFormat = DYLD_CHAINED_IMPORT;
+    uint32_t importsCount = 0;
+    std::vector<uint8_t> imports;
+    uint32_t symbolsFormat = 0;
+    std::vector<uint8_t> symbols;
+
+    std::vector<uint8_t> encode() const {
+        const uint32_t startsOffset = 32;
+        const uint32_t segmentStartsOffset = 16;
+        uint32_t segmentStartsSize = offsetof(struct dyld_chained_starts_in_segment, page_start) + 2 * pageStarts.size();
+        uint32_t importsOffset = (startsOffset + segmentStartsOffset + segmentStartsSize + 7) & ~7;
+        uint32_t symbolsOffset = importsOffset + imports.size();
+
+        std::vector<uint8_t> bytes(symbolsOffset);
+        struct dyld_chained_fixups_header header = {0, startsOffset, importsOffset, symbolsOffset, importsCount, importsFormat, symbolsFormat};
+        put(bytes, 0, header);
+
+        // __TEXT has no fixups.
+        put<uint32_t>(bytes, startsOffset, 2);
+        put<uint32_t>(bytes, startsOffset + 4, 0);
+        put<uint32_t>(bytes, startsOffset + 8, segmentStartsOffset);
+
+        size_t segmentStarts = startsOffset + segmentStartsOffset;
+        put<uint32_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, size), segmentStartsSize);
+        put<uint16_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, page_size), 0x1000);
+        put<uint16_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, pointer_format), pointerFormat);
+        put<uint64_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, segment_offset), segmentOffset);
+        put<uint32_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, max_valid_pointer), maxValidPointer);
+        put<uint16_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, page_count), 1);
+        for (size_t i = 0; i < pageStarts.size(); ++i) {
+            put<uint16_t>(bytes, segmentStarts + offsetof(struct dyld_chained_starts_in_segment, page_start) + 2 * i, pageStarts[i]);
+        }
+
+        memcpy(bytes.data() + importsOffset, imports.data(), imports.size());
+        bytes.insert(bytes.end(), symbols.begin(), symbols.end());
+        return bytes;
+    }
+};
+
+// Add the segments, `chains` and the fixups to `image` and decode them. Set the segment offset of `fixups`.
+static std::vector<ChainedFixupRecord> decode(TestImage &image, ChainedFixups &fixups, const std::vector<uint8_t> &chains) {
+    image.addSegment("__TEXT", 0x100000000, 0x4000);
+    image.addSegment("__DATA", 0x100004000, 0x4000);
+    fixups.segmentOffset = image.addData(chains);
+    image.addLinkEditData(LC_DYLD_CHAINED_FIXUPS, fixups.encode());
+    return decodeChainedFixups(image.image(), 1);
+}
+
+// Two DYLD_CHAINED_IMPORT entries, _a from the first dylib and a weak _b from the second.
+static void addImports(ChainedFixups &fixups) {
+    append(fixups.imports, dyld_chained_import{1, 0, 1});
+    append(fixups.imports, dyld_chained_import{2, 1, 4});
+    fixups.importsCount = 2;
+    fixups.symbols = {0, '_', 'a', 0, '_', 'b', 0};
+}
+
+TEST(FixupChains, Arm64e) {
+    std::vector<uint8_t> chains;
+    append(chains, dyld_chained_ptr_arm64e_auth_rebase{0x1234, 0x55, 1, 2, 1, 0, 1});
+    append(chains, dyld_chained_ptr_arm64e_auth_bind{1, 0, 0x77, 0, 3, 1, 1, 1});
+    append(chains, dyld_chained_ptr_arm64e_rebase{0x100004000, 0x12, 1, 0, 0});
+    append(chains, dyld_chained_ptr_arm64e_bind{0, 0, 0x7fffd, 0, 1, 0}); // addend -3
+
+    ChainedFixups fixups(DYLD_CHAINED_PTR_ARM64E);
+    addImports(fixups);
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, chains);
+    ASSERT_EQ(records.size(), 4);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].segmentIndex, 1);
+        EXPECT_EQ(records[i].vmOffset, fixups.segmentOffset + 8 * i);
+    }
+
+    EXPECT_FALSE(records[0].bind);
+    EXPECT_TRUE(records[0].auth);
+    EXPECT_EQ(records[0].target, 0x1234);
+    EXPECT_EQ(records[0].diversity, 0x55);
+    EXPECT_TRUE(records[0].addrDiv);
+    EXPECT_EQ(records[0].key, 2);
+
+    EXPECT_TRUE(records[1].bind);
+    EXPECT_TRUE(records[1].auth);
+    EXPECT_EQ(records[1].importOrdinal, 1);
+    EXPECT_STREQ(records[1].symbolName, "_b");
+    EXPECT_EQ(records[1].libOrdinal, 2);
+    EXPECT_EQ(records[1].diversity, 0x77);
+    EXPECT_FALSE(records[1].addrDiv);
+    EXPECT_EQ(records[1].key, 3);
+    EXPECT_EQ(records[1].addend, 0);
+
+    EXPECT_FALSE(records[2].bind);
+    EXPECT_FALSE(records[2].auth);
+    EXPECT_EQ(records[2].target, 0x100004000);
+    EXPECT_EQ(records[2].high8, 0x12);
+
+    EXPECT_TRUE(records[3].bind);
+    EXPECT_FALSE(records[3].auth);
+    EXPECT_STREQ(records[3].symbolName, "_a");
+    EXPECT_EQ(records[3].libOrdinal, 1);
+    EXPECT_EQ(records[3].addend, -3);
+}
+
+TEST(FixupChains, Userland24) {
+    // An ordinal that doesn't fit in the 16 bits of the other arm64e binds.
+    const uint32_t bigOrdinal = 0x10001;
+    ChainedFixups fixups(DYLD_CHAINED_PTR_ARM64E_USERLAND24);
+    for (uint32_t i = 0; i <= bigOrdinal; ++i) {
+        append(fixups.imports, dyld_chained_import{1, 0, i == bigOrdinal ? 4u : 1u});
+    }
+    fixups.importsCount = bigOrdinal + 1;
+    fixups.symbols = {0, '_', 'a', 0, '_', 'b', 0};
+
+    std::vector<uint8_t> chains;
+    append(chains, dyld_chained_ptr_arm64e_bind24{bigOrdinal, 0, 0x10, 2, 1, 0});
+    append(chains, 0ull);
+    append(chains, dyld_chained_ptr_arm64e_auth_bind24{bigOrdinal, 0, 0x99, 1, 0, 0, 1, 1});
+
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, chains);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].importOrdinal, bigOrdinal);
+    EXPECT_STREQ(records[0].symbolName, "_b");
+    EXPECT_EQ(records[0].addend, 0x10);
+    EXPECT_FALSE(records[0].auth);
+    // next is in 8-byte units
+    EXPECT_EQ(records[1].vmOffset, fixups.segmentOffset + 16);
+    EXPECT_EQ(records[1].importOrdinal, bigOrdinal);
+    EXPECT_TRUE(records[1].auth);
+    EXPECT_EQ(records[1].diversity, 0x99);
+    EXPECT_TRUE(records[1].addrDiv);
+}
+
+TEST(FixupChains, Ptr32MultipleStarts) {
+    // Two chains in the page, listed after page_start[0]. The second rebase of the first chain
+    // is beyond max_valid_pointer, so it's a non-pointer value that only links the chain.
+    ChainedFixups fixups(DYLD_CHAINED_PTR_32);
+    fixups.pageStarts = {DYLD_CHAINED_PTR_START_MULTI | 1, 0, 0x10 | DYLD_CHAINED_PTR_START_LAST};
+    fixups.maxValidPointer = 0x100000;
+    addImports(fixups);
+
+    std::vector<uint8_t> chains;
+    append(chains, dyld_chained_ptr_32_rebase{0x1000, 1, 0});
+    append(chains, dyld_chained_ptr_32_rebase{0x200000, 1, 0});
+    append(chains, dyld_chained_ptr_32_bind{1, 3, 0, 1});
+    append(chains, 0u);
+    append(chains, dyld_chained_ptr_32_rebase{0x2000, 0, 0});
+
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, chains);
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_FALSE(records[0].bind);
+    EXPECT_EQ(records[0].target, 0x1000);
+    EXPECT_EQ(records[0].vmOffset, fixups.segmentOffset);
+    EXPECT_TRUE(records[1].bind);
+    EXPECT_STREQ(records[1].symbolName, "_b");
+    EXPECT_EQ(records[1].addend, 3);
+    EXPECT_EQ(records[1].vmOffset, fixups.segmentOffset + 8);
+    EXPECT_FALSE(records[2].bind);
+    EXPECT_EQ(records[2].target, 0x2000);
+    EXPECT_EQ(records[2].vmOffset, fixups.segmentOffset + 0x10);
+}
+
+TEST(FixupChains, KernelCache) {
+    // The same two pointers 8 bytes apart, with next in 4-byte and in 1-byte units.
+    for (auto [format, next] : {std::pair<uint16_t, uint32_t>{DYLD_CHAINED_PTR_64_KERNEL_CACHE, 2}, {DYLD_CHAINED_PTR_X86_64_KERNEL_CACHE, 8}}) {
+        std::vector<uint8_t> chains;
+        append(chains, dyld_chained_ptr_64_kernel_cache_rebase{0x4000, 1, 0, 0, 0, next, 0});
+        append(chains, dyld_chained_ptr_64_kernel_cache_rebase{0x8000, 0, 0x1234, 1, 1, 0, 1});
+
+        ChainedFixups fixups(format);
+        TestImage image;
+        std::vector<ChainedFixupRecord> records = decode(image, fixups, chains);
+        ASSERT_EQ(records.size(), 2) << format;
+        EXPECT_FALSE(records[0].bind);
+        EXPECT_EQ(records[0].target, 0x4000);
+        EXPECT_EQ(records[0].cacheLevel, 1);
+        EXPECT_FALSE(records[0].auth);
+        EXPECT_EQ(records[1].vmOffset, fixups.segmentOffset + 8);
+        EXPECT_EQ(records[1].target, 0x8000);
+        EXPECT_TRUE(records[1].auth);
+        EXPECT_EQ(records[1].key, 1);
+        EXPECT_TRUE(records[1].addrDiv);
+        EXPECT_EQ(records[1].diversity, 0x1234);
+    }
+}
+
+// Two DYLD_CHAINED_PTR_64 binds of the imports 0 and 1, the first with an addend of 2 in the pointer.
+static std::vector<uint8_t> bindBoth() {
+    std::vector<uint8_t> chains;
+    append(chains, dyld_chained_ptr_64_bind{0, 2, 0, 2, 1});
+    append(chains, dyld_chained_ptr_64_bind{1, 0, 0, 0, 1});
+    return chains;
+}
+
+TEST(FixupChains, ImportsAddend) {
+    ChainedFixups fixups(DYLD_CHAINED_PTR_64);
+    fixups.importsFormat = DYLD_CHAINED_IMPORT_ADDEND;
+    append(fixups.imports, dyld_chained_import_addend{1, 0, 1, 100});
+    append(fixups.imports, dyld_chained_import_addend{(uint8_t)BIND_SPECIAL_DYLIB_FLAT_LOOKUP, 1, 4, -5});
+    fixups.importsCount = 2;
+    fixups.symbols = {0, '_', 'a', 0, '_', 'b', 0};
+
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, bindBoth());
+    ASSERT_EQ(records.size(), 2);
+    // The addend of a bind is the one in the pointer plus the one in the import.
+    EXPECT_STREQ(records[0].symbolName, "_a");
+    EXPECT_EQ(records[0].addend, 102);
+    EXPECT_STREQ(records[1].symbolName, "_b");
+    EXPECT_EQ(records[1].libOrdinal, BIND_SPECIAL_DYLIB_FLAT_LOOKUP);
+    EXPECT_EQ(records[1].addend, -5);
+
+    ChainedImportTable imports(image.image());
+    EXPECT_EQ(imports.format(), DYLD_CHAINED_IMPORT_ADDEND);
+    EXPECT_TRUE(imports[1].weakImport);
+    EXPECT_THROW(imports[2], std::runtime_error);
+}
+
+TEST(FixupChains, ImportsAddend64) {
+    ChainedFixups fixups(DYLD_CHAINED_PTR_64);
+    fixups.importsFormat = DYLD_CHAINED_IMPORT_ADDEND64;
+    // The ordinal is 16 bits wide, so the special ordinals are 0xFFFF and below.
+    append(fixups.imports, dyld_chained_import_addend64{0xffff, 0, 0, 1, 0x100000000});
+    append(fixups.imports, dyld_chained_import_addend64{300, 1, 0, 4, (uint64_t)-1});
+    fixups.importsCount = 2;
+    fixups.symbols = {0, '_', 'a', 0, '_', 'b', 0};
+
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, bindBoth());
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_STREQ(records[0].symbolName, "_a");
+    EXPECT_EQ(records[0].libOrdinal, BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE);
+    EXPECT_EQ(records[0].addend, 0x100000002);
+    EXPECT_STREQ(records[1].symbolName, "_b");
+    EXPECT_EQ(records[1].libOrdinal, 300);
+    EXPECT_EQ(records[1].addend, -1);
+}
+
+TEST(FixupChains, CompressedSymbols) {
+    std::string pool("\0_a\0_b\0", 7);
+    uLongf size = compressBound(pool.size());
+    std::vector<uint8_t> compressed(size);
+    compress2(compressed.data(), &size, (const Bytef *)pool.data(), pool.size(), Z_BEST_COMPRESSION);
+    compressed.resize(size);
+
+    ChainedFixups fixups(DYLD_CHAINED_PTR_64);
+    addImports(fixups);
+    fixups.symbolsFormat = 1;
+    fixups.symbols = compressed;
+
+    TestImage image;
+    std::vector<ChainedFixupRecord> records = decode(image, fixups, bindBoth());
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_STREQ(records[0].symbolName, "_a");
+    EXPECT_STREQ(records[1].symbolName, "_b");
+    EXPECT_EQ(image.image().getChainedFixupsSymbols(), pool);
+
+    // A pool that isn't valid zlib data fails instead of producing names.
+    ChainedFixups corrupted(DYLD_CHAINED_PTR_64);
+    addImports(corrupted);
+    corrupted.symbolsFormat = 1;
+    corrupted.symbols = {0x01, 0x02, 0x03, 0x04};
+    TestImage other;
+    EXPECT_THROW(decode(other, corrupted, bindBoth()), std::runtime_error);
+}
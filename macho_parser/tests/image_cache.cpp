@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/image_cache.h"
+#include "test_image.h"
+
+// An image with an LC_UUID, which the cache needs, and a file to stand for it.
+class ImageCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        struct uuid_command uuidCmd = {};
+        uuidCmd.cmd = LC_UUID;
+        for (int i = 0; i < sizeof(uuidCmd.uuid); ++i) {
+            uuidCmd.uuid[i] = i;
+        }
+        testImage.addCommand(uuidCmd);
+
+        std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        dir = std::string(::testing::TempDir()) + "image_cache_" + name;
+        std::filesystem::remove_all(dir);
+        filePath = dir + ".bin";
+        FILE *file = fopen(filePath.c_str(), "wb");
+        fputs("image", file);
+        fclose(file);
+    }
+
+    std::unique_ptr<ImageCache> open() {
+        return ImageCache::open(dir.c_str(), testImage.image(), filePath.c_str());
+    }
+
+    // Return the table `name`, whose first two columns are an address and a name and any others are 0,
+    // counting the calls to build it.
+    const ColumnTableReader &table(ImageCache &cache, const char *name = "symbols",
+        std::vector<ImageCache::Column> columns = {{"address", COLUMN_U64}, {"name", COLUMN_STRING}}) {
+        return cache.table(name, columns, [this, &columns](ColumnTableWriter &writer) {
+            builds += 1;
+            writer.append(0, 0x1000);
+            writer.appendString(1, "_main");
+            writer.append(0, 0x2000);
+            writer.appendString(1, "_helper");
+            for (size_t column = 2; column < columns.size(); ++column) {
+                writer.append(column, 0);
+                writer.append(column, 0);
+            }
+        });
+    }
+
+    // The only cached table in the image's directory.
+    std::string tablePath() {
+        for (const auto &imageDir : std::filesystem::directory_iterator(dir)) {
+            return imageDir.path().string() + "/symbols.col";
+        }
+        return "";
+    }
+
+    TestImage testImage;
+    std::string dir;
+    std::string filePath;
+    int builds = 0;
+};
+
+TEST_F(ImageCacheTest, ColdThenWarm) {
+    std::unique_ptr<ImageCache> cache = open();
+    ASSERT_NE(cache, nullptr);
+    const ColumnTableReader &cold = table(*cache);
+    EXPECT_EQ(builds, 1);
+    ASSERT_EQ(cold.rowCount(), 2);
+    EXPECT_EQ(cold.value(0, 1), 0x2000);
+    EXPECT_EQ(cold.string(1, 1), "_helper");
+    EXPECT_TRUE(std::filesystem::exists(tablePath()));
+
+    // The same cache keeps the table.
+    EXPECT_EQ(&table(*cache), &cold);
+    EXPECT_EQ(builds, 1);
+
+    // A later run maps the file instead of building the table.
+    cache = open();
+    const ColumnTableReader &warm = table(*cache);
+    EXPECT_EQ(builds, 1);
+    ASSERT_EQ(warm.rowCount(), 2);
+    EXPECT_EQ(warm.value(0, 0), 0x1000);
+    EXPECT_EQ(warm.string(1, 0), "_main");
+}
+
+TEST_F(ImageCacheTest, ColumnMismatch) {
+    table(*open());
+    EXPECT_EQ(builds, 1);
+
+    // A renamed column, a column of another type and a missing column all build the table again.
+    table(*open(), "symbols", {{"addr", COLUMN_U64}, {"name", COLUMN_STRING}});
+    EXPECT_EQ(builds, 2);
+    table(*open(), "symbols", {{"address", COLUMN_U32}, {"name", COLUMN_STRING}});
+    EXPECT_EQ(builds, 3);
+    table(*open(), "symbols", {{"address", COLUMN_U64}, {"name", COLUMN_STRING}, {"size", COLUMN_U64}});
+    EXPECT_EQ(builds, 4);
+
+    // The last rebuild replaced the file.
+    table(*open(), "symbols", {{"address", COLUMN_U64}, {"name", COLUMN_STRING}, {"size", COLUMN_U64}});
+    EXPECT_EQ(builds, 4);
+}
+
+TEST_F(ImageCacheTest, CorruptFile) {
+    table(*open());
+    EXPECT_EQ(builds, 1);
+
+    // A file cut short, as by a crash while writing.
+    std::filesystem::resize_file(tablePath(), 12);
+    const ColumnTableReader &truncated = table(*open());
+    EXPECT_EQ(builds, 2);
+    EXPECT_EQ(truncated.rowCount(), 2);
+
+    FILE *file = fopen(tablePath().c_str(), "wb");
+    fputs("this is not a column table, just some text", file);
+    fclose(file);
+    std::unique_ptr<ImageCache> cache = open();
+    const ColumnTableReader &garbage = table(*cache);
+    EXPECT_EQ(builds, 3);
+    EXPECT_EQ(garbage.string(1, 0), "_main");
+
+    // The rebuilt file is used from then on.
+    table(*open());
+    EXPECT_EQ(builds, 3);
+}
+
+TEST(ImageCache, NoUUID) {
+    TestImage testImage;
+    testImage.addSegment("__TEXT", 0x0, 0x1000);
+    EXPECT_EQ(ImageCache::open(::testing::TempDir().c_str(), testImage.image(), "/"), nullptr);
+}
+
+TEST_F(ImageCacheTest, InvalidTable) {
+    table(*open());
+    EXPECT_EQ(builds, 1);
+
+    // A table that has the right columns but values that don't fit the image is built again.
+    std::vector<ImageCache::Column> columns = {{"address", COLUMN_U64}, {"name", COLUMN_STRING}};
+    auto build = [this](ColumnTableWriter &writer) {
+        builds += 1;
+        writer.append(0, 0x3000);
+        writer.appendString(1, "_rebuilt");
+    };
+    std::unique_ptr<ImageCache> cache = open();
+    const ColumnTableReader &rebuilt = cache->table("symbols", columns, build, [](const ColumnTableReader &table) {
+        return table.value(0, 0) != 0x1000;
+    });
+    EXPECT_EQ(builds, 2);
+    ASSERT_EQ(rebuilt.rowCount(), 1);
+    EXPECT_EQ(rebuilt.string(1, 0), "_rebuilt");
+
+    // A valid file is used as is.
+    open()->table("symbols", columns, build, [](const ColumnTableReader &table) { return true; });
+    EXPECT_EQ(builds, 2);
+}
+
+// Two caches in one process, e.g. for two copies of the same image, can write the same table at the same time.
+TEST_F(ImageCacheTest, ConcurrentWriters) {
+    const int rows = 1 << 20;
+    for (int round = 0; round < 10; ++round) {
+        std::filesystem::remove_all(dir);
+        std::unique_ptr<ImageCache> caches[2] = {open(), open()};
+
+        // Both build the table before either of them writes it, each with its own values.
+        std::atomic<int> building{0};
+        const ColumnTableReader *tables[2] = {};
+        auto run = [&](int i) {
+            try {
+                tables[i] = &caches[i]->table("rows", {{"row", COLUMN_U32}}, [&](ColumnTableWriter &writer) {
+                    building += 1;
+                    while (building < 2) {
+                        std::this_thread::yield();
+                    }
+                    for (int row = 0; row < rows; ++row) {
+                        writer.append(0, i * rows + row);
+                    }
+                });
+            } catch (const std::exception &e) {
+                ADD_FAILURE() << e.what();
+            }
+        };
+        std::thread other(run, 1);
+        run(0);
+        other.join();
+
+        // Either table may have won, but each is whole.
+        for (const ColumnTableReader *table : tables) {
+            ASSERT_NE(table, nullptr);
+            ASSERT_EQ(table->rowCount(), rows);
+            int64_t first = table->value(0, 0);
+            EXPECT_TRUE(first == 0 || first == rows);
+            EXPECT_EQ(table->value(0, rows - 1), first + rows - 1);
+        }
+        for (const auto &imageDir : std::filesystem::directory_iterator(dir)) {
+            for (const auto &file : std::filesystem::directory_iterator(imageDir.path())) {
+                EXPECT_EQ(file.path().filename(), "rows.col");
+            }
+        }
+    }
+}
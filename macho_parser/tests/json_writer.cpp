@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "utils/utils.h"
+
+static std::string writeJson(std::function<void(JsonWriter &)> const& write) {
+    FILE *file = tmpfile();
+    {
+        OutputBuffer out(file);
+        JsonWriter json(out);
+        write(json);
+    }
+
+    std::string content;
+    rewind(file);
+    char buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        content.append(buf, n);
+    }
+    fclose(file);
+    return content;
+}
+
+TEST(JsonWriter, Object) {
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        json.beginObject();
+        json.endObject();
+    }), "{}");
+
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        json.beginObject();
+        json.stringField("name", "_main");
+        json.numberField("index", -1);
+        json.boolField("weak", false);
+        json.hexField("addr", 0x100003dd4);
+        json.endObject();
+    }), "{\"name\":\"_main\",\"index\":-1,\"weak\":false,\"addr\":\"0x100003dd4\"}");
+}
+
+TEST(JsonWriter, Nested) {
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        json.beginArray();
+        json.beginObject();
+        json.key("tools");
+        json.beginArray();
+        json.string("ld");
+        json.string("swift");
+        json.endArray();
+        json.key("empty");
+        json.beginArray();
+        json.endArray();
+        json.endObject();
+        json.number(1);
+        json.endArray();
+    }), "[{\"tools\":[\"ld\",\"swift\"],\"empty\":[]},1]");
+}
+
+TEST(JsonWriter, TopLevelValues) {
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        for (int i = 0; i < 3; ++i) {
+            json.beginObject();
+            json.numberField("i", i);
+            json.endObject();
+            json.newline();
+        }
+    }), "{\"i\":0}\n{\"i\":1}\n{\"i\":2}\n");
+}
+
+// Elements rendered by a separate writer and spliced into an array that's already open.
+TEST(JsonWriter, ContinueArray) {
+    std::string elements = writeJson([](JsonWriter &json) {
+        json.continueArray();
+        json.number(2);
+        json.beginObject();
+        json.numberField("i", 3);
+        json.endObject();
+    });
+    EXPECT_EQ(elements, ",2,{\"i\":3}");
+
+    EXPECT_EQ(writeJson([&elements](JsonWriter &json) {
+        json.beginArray();
+        json.number(1);
+        json.raw(elements);
+        json.number(4);
+        json.endArray();
+    }), "[1,2,{\"i\":3},4]");
+}
+
+TEST(JsonWriter, Escape) {
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        json.string(std::string_view("a\"b\\c\nd\te\x01\x1f\0z", 13));
+    }), "\"a\\\"b\\\\c\\nd\\te\\u0001\\u001f\\u0000z\"");
+
+    EXPECT_EQ(writeJson([](JsonWriter &json) {
+        json.string("\xe2\x9c\x93 utf-8");
+    }), "\"\xe2\x9c\x93 utf-8\"");
+}
+
+// Bytes that aren't valid UTF-8 are escaped one by one, the valid sequences around them are kept.
+TEST(JsonWriter, InvalidUtf8) {
+    auto escape = [](std::string_view value) {
+        return writeJson([value](JsonWriter &json) { json.string(value); });
+    };
+
+    EXPECT_EQ(escape("\xf0\x9f\x8d\x8e \xc3\xa9 \xf4\x8f\xbf\xbf"), "\"\xf0\x9f\x8d\x8e \xc3\xa9 \xf4\x8f\xbf\xbf\"");
+    // a stray continuation byte and a lead byte without its continuation
+    EXPECT_EQ(escape("a\x80z\xc3"), "\"a\\u0080z\\u00c3\"");
+    // truncated in the middle of a sequence
+    EXPECT_EQ(escape("\xe2\x9c" "a"), "\"\\u00e2\\u009ca\"");
+    // overlong encodings of '/' and NUL
+    EXPECT_EQ(escape("\xc0\xaf\xe0\x80\x80"), "\"\\u00c0\\u00af\\u00e0\\u0080\\u0080\"");
+    // a UTF-16 surrogate and a code point above U+10FFFF
+    EXPECT_EQ(escape("\xed\xa0\x80\xf4\x90\x80\x80"),
+        "\"\\u00ed\\u00a0\\u0080\\u00f4\\u0090\\u0080\\u0080\"");
+    EXPECT_EQ(escape("\xff\xfe"), "\"\\u00ff\\u00fe\"");
+}
@@ -27,3 +27,133 @@ TEST(LEB128, MultiBytesSLEB128) {
     EXPECT_EQ(num, -123456);
     EXPECT_EQ(size, 3);
 }
+
+TEST(LEB128, WriteULEB128) {
+    std::vector<uint8_t> bytes;
+    EXPECT_EQ(writeULEB128(624485, bytes), 3);
+    EXPECT_EQ(bytes, std::vector<uint8_t>({0xE5, 0x8E, 0x26}));
+    EXPECT_EQ(sizeOfULEB128(624485), 3);
+
+    bytes.clear();
+    EXPECT_EQ(writeULEB128(0, bytes), 1);
+    EXPECT_EQ(bytes, std::vector<uint8_t>({0x00}));
+    EXPECT_EQ(sizeOfULEB128(0), 1);
+    EXPECT_EQ(sizeOfULEB128(127), 1);
+    EXPECT_EQ(sizeOfULEB128(128), 2);
+}
+
+TEST(LEB128, WriteSLEB128) {
+    std::vector<uint8_t> bytes;
+    EXPECT_EQ(writeSLEB128(-123456, bytes), 3);
+    EXPECT_EQ(bytes, std::vector<uint8_t>({0xC0, 0xBB, 0x78}));
+
+    bytes.clear();
+    writeSLEB128(-1, bytes);
+    EXPECT_EQ(bytes, std::vector<uint8_t>({0x7F}));
+
+    // 64 needs a second byte, otherwise its bit 6 would read as the sign
+    bytes.clear();
+    writeSLEB128(64, bytes);
+    EXPECT_EQ(bytes, std::vector<uint8_t>({0xC0, 0x00}));
+}
+
+TEST(LEB128, RoundTrip) {
+    uint64_t values[] = {0, 1, 63, 64, 127, 128, 300, 0x3fff, 0x4000, 0xffffffff, 0x123456789abcdef, UINT64_MAX};
+    for (uint64_t value : values) {
+        std::vector<uint8_t> bytes;
+        int size = writeULEB128(value, bytes);
+        EXPECT_EQ(size, sizeOfULEB128(value));
+
+        uint64_t num;
+        EXPECT_EQ(readULEB128(bytes.data(), &num), size);
+        EXPECT_EQ(num, value);
+    }
+
+    // readSLEB128() only handles values up to 32 bits for now.
+    int64_t signedValues[] = {0, 1, -1, 63, -64, 64, -65, 8191, -8192, 100000, -123456};
+    for (int64_t value : signedValues) {
+        std::vector<uint8_t> bytes;
+        int size = writeSLEB128(value, bytes);
+
+        int64_t num;
+        EXPECT_EQ(readSLEB128(bytes.data(), &num), size);
+        EXPECT_EQ(num, value);
+    }
+}
+
+TEST(LEB128, BoundedRoundTrip) {
+    std::vector<uint64_t> values = {0, 1, 127, 128, 0x3fff, 0x4000, 0x1fffff, 0x200000, 0xfffffff, 0x10000000,
+        0xffffffff, 0xffffffffffffff, 0x100000000000000, 0x7fffffffffffffff, UINT64_MAX};
+    for (uint64_t value : values) {
+        std::vector<uint8_t> bytes;
+        int size = writeULEB128(value, bytes);
+        // Decode with the number at the end of the data, which takes the byte loop, and followed by padding,
+        // which takes the 8-byte load if the number fits in it.
+        for (size_t padding : {0, 16}) {
+            std::vector<uint8_t> data = bytes;
+            data.resize(bytes.size() + padding, 0xff);
+            uint64_t num;
+            EXPECT_EQ(readULEB128(data.data(), data.data() + data.size(), &num), size) << value;
+            EXPECT_EQ(num, value);
+        }
+
+        for (int64_t signedValue : {(int64_t)value, -(int64_t)value, (int64_t)value - 1}) {
+            std::vector<uint8_t> signedBytes;
+            size = writeSLEB128(signedValue, signedBytes);
+            for (size_t padding : {0, 16}) {
+                std::vector<uint8_t> data = signedBytes;
+                data.resize(signedBytes.size() + padding, 0xff);
+                int64_t num;
+                EXPECT_EQ(readSLEB128(data.data(), data.data() + data.size(), &num), size) << signedValue;
+                EXPECT_EQ(num, signedValue);
+            }
+        }
+    }
+}
+
+TEST(LEB128, BoundedSignedLimits) {
+    for (int64_t value : {INT64_MIN, INT64_MAX, INT64_MIN + 1}) {
+        std::vector<uint8_t> bytes;
+        EXPECT_EQ(writeSLEB128(value, bytes), 10);
+        int64_t num;
+        EXPECT_EQ(readSLEB128(bytes.data(), bytes.data() + bytes.size(), &num), 10);
+        EXPECT_EQ(num, value);
+    }
+}
+
+TEST(LEB128, BoundedMatchesUnbounded) {
+    // Every length from 1 to 10 bytes with varying bit patterns.
+    uint64_t seed = 0x9e3779b97f4a7c15;
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 10000; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        writeULEB128(seed >> (i % 64), data);
+    }
+
+    const uint8_t *p = data.data();
+    const uint8_t *end = data.data() + data.size();
+    while (p < end) {
+        uint64_t expected, actual;
+        int expectedSize = readULEB128(p, &expected);
+        ASSERT_EQ(readULEB128(p, end, &actual), expectedSize);
+        ASSERT_EQ(actual, expected);
+        p += expectedSize;
+    }
+}
+
+TEST(LEB128, BoundedErrors) {
+    uint64_t num;
+    int64_t snum;
+
+    uint8_t truncated[] = {0x80, 0x80, 0x80};
+    EXPECT_THROW(readULEB128(truncated, truncated + sizeof(truncated), &num), std::runtime_error);
+    EXPECT_THROW(readSLEB128(truncated, truncated + sizeof(truncated), &snum), std::runtime_error);
+    EXPECT_THROW(readULEB128(truncated, truncated, &num), std::runtime_error);
+
+    // 2^70 doesn't fit in 64 bits.
+    uint8_t tooBig[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0, 0, 0, 0, 0, 0};
+    EXPECT_THROW(readULEB128(tooBig, tooBig + sizeof(tooBig), &num), std::runtime_error);
+
+    uint8_t tooLong[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x81, 0x00};
+    EXPECT_THROW(readULEB128(tooLong, tooLong + sizeof(tooLong), &num), std::runtime_error);
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "core/macho_image.h"
+#include "core/fat_macho.h"
+#include "core/fixup_chains.h"
+#include "core/exports.h"
+#include "core/signature.h"
+
+// The image is parsed in place, so the bytes have to outlive it.
+static std::vector<uint8_t> readFixture(const char *path) {
+    std::ifstream file(path, std::ios::binary);
+    EXPECT_TRUE(file.good()) << path;
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static std::vector<uint8_t> mainSha256 = readFixture("tests/fixtures/code_signature/main_sha256");
+
+TEST(MachoCore, LoadCommands) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    EXPECT_EQ(image.header->cputype, CPU_TYPE_ARM64);
+    EXPECT_EQ(image.header->filetype, MH_EXECUTE);
+    EXPECT_EQ(image.allLoadCommands.size(), 18);
+    ASSERT_EQ(image.segmentCommands.size(), 4);
+    EXPECT_STREQ(image.getSegmentByIndex(1)->segname, "__TEXT");
+    EXPECT_THROW(image.getSegmentByIndex(4), std::runtime_error);
+    EXPECT_EQ(image.getDylibNameByOrdinal(2), "libswiftCore.dylib");
+}
+
+TEST(MachoCore, Symbols) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    ASSERT_EQ(image.getSymbolCount(), 14);
+    EXPECT_STREQ(image.getString(image.getSymbol(6)->n_un.n_strx), "_main");
+    EXPECT_EQ(image.getSymbol(14), nullptr);
+    EXPECT_EQ(image.lookupSymbolByName("_main"), 6);
+    EXPECT_STREQ(image.lookupSymbolByAddress(0x100003dd4), "_main");
+}
+
+TEST(MachoCore, Views) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    std::vector<std::string_view> segments;
+    size_t sectionCount = 0;
+    for (SegmentView segment : image.getSegments()) {
+        segments.push_back(segment.name());
+        sectionCount += segment.sections().size();
+    }
+    EXPECT_EQ(segments, std::vector<std::string_view>({"__PAGEZERO", "__TEXT", "__DATA_CONST", "__LINKEDIT"}));
+    ASSERT_EQ(sectionCount, image.getSections().size());
+
+    SectionView text = image.getSegments()[1].sections()[0];
+    EXPECT_EQ(text.raw(), image.getSections()[0].raw());
+    EXPECT_EQ(text.segmentName(), "__TEXT");
+    EXPECT_EQ(text.name(), "__text");
+    EXPECT_EQ(text.type(), S_REGULAR);
+    EXPECT_TRUE(text.contains(0x100003dd4));
+    EXPECT_FALSE(text.contains(text.address() + text.size()));
+
+    SymbolRange symbols = image.getSymbols();
+    ASSERT_EQ(symbols.size(), image.getSymbolCount());
+    uint32_t undefined = 0;
+    for (SymbolView symbol : symbols) {
+        EXPECT_EQ(symbol.name(), image.getString(symbol.raw()->n_un.n_strx));
+        undefined += symbol.isUndefined();
+    }
+    EXPECT_EQ(undefined, 7);
+    EXPECT_EQ(symbols[6].name(), "_main");
+    EXPECT_EQ(symbols[6].value(), 0x100003dd4);
+    EXPECT_TRUE(symbols[6].isExternal());
+    EXPECT_EQ(symbols[6].sect(), 1);
+}
+
+TEST(MachoCore, SectionByAddress) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    // Compare with a linear scan at both ends of every section and in random order.
+    std::vector<uint64_t> addresses = {0, 0x100000000, UINT64_MAX};
+    for (SectionView sect : image.getSections()) {
+        addresses.insert(addresses.end(), {sect.address() - 1, sect.address(), sect.address() + sect.size() - 1, sect.address() + sect.size()});
+    }
+    std::reverse(addresses.begin(), addresses.end());
+
+    for (uint64_t addr : addresses) {
+        struct section_64 *expected = nullptr;
+        for (SectionView sect : image.getSections()) {
+            if (sect.contains(addr)) {
+                expected = (struct section_64 *)sect.raw();
+                break;
+            }
+        }
+        EXPECT_EQ(image.getSectionByAddress(addr), expected) << std::hex << addr;
+    }
+    EXPECT_STREQ(image.getSectionByAddress(0x100003dd4)->sectname, "__text");
+}
+
+TEST(MachoCore, Exports) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    std::vector<std::string> names;
+    forEachExport(image, [&names](const ExportRecord &record) {
+        names.push_back(std::string(record.name));
+    });
+    EXPECT_EQ(names, std::vector<std::string>({"__mh_execute_header", "_main"}));
+
+    ExportRecord record;
+    ASSERT_TRUE(exportLookup(image, "_main", record));
+    EXPECT_EQ(record.address, 0x3dd4);
+    EXPECT_FALSE(exportLookup(image, "_missing", record));
+}
+
+TEST(MachoCore, ChainedFixups) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    ChainedImportTable imports(image);
+    ASSERT_EQ(imports.size(), 7);
+    EXPECT_STREQ(imports[6].name, "_swift_bridgeObjectRelease");
+    EXPECT_EQ(getChainedStartsInSegment(image, 1), nullptr);
+
+    std::vector<ChainedFixupRecord> fixups = decodeChainedFixups(image, 1);
+    ASSERT_EQ(fixups.size(), 7);
+    for (uint32_t i = 0; i < fixups.size(); ++i) {
+        EXPECT_TRUE(fixups[i].bind);
+        EXPECT_EQ(fixups[i].segmentIndex, 2);
+        EXPECT_EQ(fixups[i].vmOffset, 0x4000 + i * 8);
+        EXPECT_EQ(fixups[i].importOrdinal, i);
+        EXPECT_EQ(fixups[i].libOrdinal, 2);
+        EXPECT_STREQ(fixups[i].symbolName, imports[i].name);
+    }
+}
+
+TEST(MachoCore, CodeSignature) {
+    MachoImage image(mainSha256.data(), mainSha256.size());
+
+    CodeSignatureSuperBlob signature = getCodeSignature(image);
+    EXPECT_EQ(signature.magic(), CSMAGIC_EMBEDDED_SIGNATURE);
+    ASSERT_EQ(signature.count(), 3);
+    EXPECT_EQ(signature[1].magic, CSMAGIC_REQUIREMENTS);
+    EXPECT_EQ(signature[2].magic, CSMAGIC_BLOBWRAPPER);
+    EXPECT_THROW(signature[3], std::runtime_error);
+
+    CodeSignatureBlob blob = signature[0];
+    ASSERT_EQ(blob.magic, CSMAGIC_CODEDIRECTORY);
+    CodeDirectory directory = decodeCodeDirectory(blob.data);
+    EXPECT_EQ(directory.hashType, CS_HASHTYPE_SHA256);
+    EXPECT_EQ(directory.nSpecialSlots, 2);
+    EXPECT_EQ(directory.nCodeSlots, 9);
+    EXPECT_EQ(directory.pageSize, 12);
+    EXPECT_STREQ(directory.identity, "main_sha256-555549447d2ac96ad05e37d899edffa300d9434b");
+    EXPECT_EQ(formatBufferToHex(directory.slotHash(-1), directory.hashSize), std::string(64, '0'));
+}
+
+TEST(MachoCore, FatArchs) {
+    // A FAT_MAGIC_64 header, big-endian like every fat header, with a slice past 4 GB.
+    std::vector<uint8_t> fat = {
+        0xca, 0xfe, 0xba, 0xbf, 0, 0, 0, 1,
+        0x01, 0, 0, 0x0c, 0, 0, 0, 0,
+        0, 0, 0, 0x01, 0x40, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0x10, 0,
+        0, 0, 0, 14, 0, 0, 0, 0,
+    };
+    ASSERT_TRUE(FatMacho::isFatMacho(fat.data(), fat.size()));
+
+    struct fat_header header;
+    std::vector<struct fat_arch_64> archs;
+    ASSERT_TRUE(FatMacho::readFatArchs(fat.data(), fat.size(), header, archs));
+    ASSERT_EQ(archs.size(), 1);
+    EXPECT_EQ(archs[0].cputype, CPU_TYPE_ARM64);
+    EXPECT_EQ(archs[0].offset, 0x140000000);
+    EXPECT_EQ(archs[0].size, 0x1000);
+    EXPECT_EQ(archs[0].align, 14);
+    EXPECT_FALSE(FatMacho::readFatArchs(fat.data(), fat.size() - 1, header, archs));
+
+    // The slice is outside of the buffer.
+    int slices = 0;
+    FatMacho::enumerateSlices(fat.data(), fat.size(), [&slices](cpu_type_t, uint8_t *, uint64_t) { slices += 1; });
+    EXPECT_EQ(slices, 0);
+}
+
+TEST(MachoCore, Truncated) {
+    EXPECT_THROW(MachoImage(mainSha256.data(), 16), std::runtime_error);
+    // Cut in the middle of the linkedit data, which LC_SYMTAB and LC_CODE_SIGNATURE point into.
+    EXPECT_THROW(MachoImage(mainSha256.data(), 0x8100), std::runtime_error);
+}
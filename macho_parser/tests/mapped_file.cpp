@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <stdexcept>
+#include "utils/utils.h"
+
+static std::string tempPath(const char *name) {
+    return std::string(::testing::TempDir()) + name;
+}
+
+TEST(MappedFile, Windows) {
+    std::string path = tempPath("mapped_file_windows.bin");
+    std::vector<uint8_t> bytes(3 * getpagesize() + 100);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = i * 7;
+    }
+    FILE *out = fopen(path.c_str(), "wb");
+    fwrite(bytes.data(), 1, bytes.size(), out);
+    fclose(out);
+
+    MappedFile file(path.c_str());
+    ASSERT_EQ(file.size(), bytes.size());
+
+    // Windows at unaligned offsets, across a page boundary and at the very end of the file.
+    for (uint64_t offset : {(uint64_t)0, (uint64_t)3, (uint64_t)getpagesize() - 5, (uint64_t)bytes.size() - 100}) {
+        uint8_t *window = file.map(offset, 100);
+        EXPECT_EQ(memcmp(window, bytes.data() + offset, 100), 0) << offset;
+        MappedFile::adviseSequential(window, 100);
+    }
+
+    // Released pages are read from the file again.
+    uint8_t *all = file.map(0, bytes.size());
+    MappedFile::release(all, bytes.size());
+    EXPECT_EQ(memcmp(all, bytes.data(), bytes.size()), 0);
+
+    file.map(bytes.size(), 0);
+    EXPECT_THROW(file.map(bytes.size(), 1), std::runtime_error);
+    EXPECT_THROW(file.map(1, UINT64_MAX), std::runtime_error);
+}
+
+TEST(MappedFile, Missing) {
+    EXPECT_THROW(MappedFile(tempPath("mapped_file_missing.bin").c_str()), std::runtime_error);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "utils/utils.h"
+
+static std::string readAll(FILE *file) {
+    std::string content;
+    rewind(file);
+    char buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        content.append(buf, n);
+    }
+    return content;
+}
+
+TEST(OutputBuffer, Append) {
+    FILE *file = tmpfile();
+    {
+        OutputBuffer out(file);
+        out.append("abc");
+        out.append('|');
+        out.append("abc", 5);
+        out.append('|');
+        out.append("abc", -5);
+        out.append('|');
+        out.append("abcdef", 3);
+        out.append('|');
+        out.appendSpaces(2);
+        out.append('|');
+    }
+    EXPECT_EQ(readAll(file), "abc|  abc|abc  |abcdef|  |");
+    fclose(file);
+}
+
+TEST(OutputBuffer, Numbers) {
+    FILE *file = tmpfile();
+    {
+        OutputBuffer out(file);
+        out.appendDecimal(0);
+        out.append(' ');
+        out.appendDecimal(-42, 5);
+        out.append(' ');
+        out.appendDecimal(7, -4);
+        out.append(' ');
+        out.appendDecimal(INT64_MIN);
+        out.append(' ');
+        out.appendHex(0);
+        out.append(' ');
+        out.appendHex(0x1f, 4);
+        out.append(' ');
+        out.appendHex(0x100003dd4, 16);
+        out.append(' ');
+        out.appendHex(UINT64_MAX);
+    }
+    EXPECT_EQ(readAll(file), "0   -42 7    -9223372036854775808 0 001f 0000000100003dd4 ffffffffffffffff");
+    fclose(file);
+}
+
+TEST(OutputBuffer, SmallCapacity) {
+    FILE *file = tmpfile();
+    std::string expected;
+    {
+        OutputBuffer out(file, 8);
+        for (int i = 0; i < 100; ++i) {
+            out.appendDecimal(i, -3);
+            out.append("longer than the buffer");
+            expected += std::to_string(i) + std::string(3 - std::min<size_t>(3, std::to_string(i).size()), ' ') + "longer than the buffer";
+        }
+        out.appendSpaces(20);
+        expected += std::string(20, ' ');
+    }
+    EXPECT_EQ(readAll(file), expected);
+    fclose(file);
+}
+
+TEST(TextOutput, Scope) {
+    EXPECT_EQ(textOutput(), stdout);
+
+    FILE *outer = tmpfile();
+    FILE *inner = tmpfile();
+    {
+        TextOutputScope outerScope(outer);
+        fprintf(textOutput(), "outer ");
+        {
+            TextOutputScope innerScope(inner);
+            fprintf(textOutput(), "inner");
+        }
+        fprintf(textOutput(), "again");
+    }
+    EXPECT_EQ(textOutput(), stdout);
+    EXPECT_EQ(readAll(outer), "outer again");
+    EXPECT_EQ(readAll(inner), "inner");
+
+    // Every thread has its own.
+    {
+        TextOutputScope scope(outer);
+        FILE *otherThread = nullptr;
+        std::thread([&otherThread]() { otherThread = textOutput(); }).join();
+        EXPECT_EQ(otherThread, stdout);
+    }
+    fclose(outer);
+    fclose(inner);
+}
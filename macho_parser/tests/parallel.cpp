@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "utils/utils.h"
+
+TEST(ParallelFor, VisitsEveryIndexOnce) {
+    const size_t count = 10000;
+    std::vector<std::atomic<int>> visits(count);
+
+    parallelFor(count, [&visits](size_t i) { visits[i]++; }, 8);
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(visits[i], 1);
+    }
+}
+
+TEST(ParallelFor, UnevenTasks) {
+    std::atomic<uint64_t> sum(0);
+
+    // The first few indexes are much more expensive, so other workers have to steal.
+    parallelFor(64, [&sum](size_t i) {
+        uint64_t local = 0;
+        for (uint64_t j = 0; j < (i < 4 ? 2000000 : 10); ++j) {
+            local += j % 3;
+        }
+        sum += local > 0 ? i : 0;
+    }, 4);
+
+    EXPECT_EQ(sum, 64 * 63 / 2);
+}
+
+TEST(ParallelFor, EmptyAndSingle) {
+    int calls = 0;
+    parallelFor(0, [&calls](size_t i) { calls++; });
+    EXPECT_EQ(calls, 0);
+
+    parallelFor(1, [&calls](size_t i) { calls++; });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ParallelFor, RethrowsException) {
+    EXPECT_THROW(parallelFor(100, [](size_t i) {
+        if (i == 42) {
+            throw std::runtime_error("failed");
+        }
+    }, 4), std::runtime_error);
+}
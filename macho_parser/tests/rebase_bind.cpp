@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "core/rebase_bind.h"
+#include "test_image.h"
+
+// An image with __TEXT and __DATA and `opcodes` in its data. Return the offset of the opcodes.
+static uint32_t addOpcodes(TestImage &image, const std::vector<uint8_t> &opcodes) {
+    image.addSegment("__TEXT", 0x100000000, 0x4000);
+    image.addSegment("__DATA", 0x100004000, 0x4000);
+    return image.addData(opcodes);
+}
+
+static std::vector<uint8_t> rebaseOpcodes = {
+    REBASE_OPCODE_SET_TYPE_IMM | REBASE_TYPE_POINTER,
+    REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x10,
+    REBASE_OPCODE_DO_REBASE_IMM_TIMES | 3,                  // 0x10, 0x18, 0x20
+    REBASE_OPCODE_ADD_ADDR_IMM_SCALED | 2,
+    REBASE_OPCODE_DO_REBASE_ULEB_TIMES, 2,                  // 0x38, 0x40
+    REBASE_OPCODE_ADD_ADDR_ULEB, 0x80, 0x02,
+    REBASE_OPCODE_SET_TYPE_IMM | REBASE_TYPE_TEXT_ABSOLUTE32,
+    REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB, 0x08,            // 0x148
+    REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB, 3, 8, // 0x158, 0x168, 0x178
+    REBASE_OPCODE_DONE,
+};
+
+static std::vector<uint8_t> bindOpcodes = {
+    BIND_OPCODE_SET_DYLIB_ORDINAL_IMM | 1,
+    BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM, '_', 'a', 0,
+    BIND_OPCODE_SET_TYPE_IMM | BIND_TYPE_POINTER,
+    BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00,
+    BIND_OPCODE_DO_BIND,                                    // 0x0
+    BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM | BIND_SYMBOL_FLAGS_WEAK_IMPORT, '_', 'b', 0,
+    BIND_OPCODE_SET_ADDEND_SLEB, 0x78,                      // -8
+    BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB, 0xac, 0x02,         // 300
+    BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB, 0x10,                // 0x8
+    BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED | 2,            // 0x20
+    BIND_OPCODE_SET_DYLIB_SPECIAL_IMM | (BIND_SPECIAL_DYLIB_FLAT_LOOKUP & BIND_IMMEDIATE_MASK),
+    BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM | BIND_SYMBOL_FLAGS_NON_WEAK_DEFINITION, '_', 'c', 0,
+    BIND_OPCODE_SET_ADDEND_SLEB, 0x00,
+    BIND_OPCODE_ADD_ADDR_ULEB, 0x08,
+    BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB, 2, 8,     // 0x40, 0x50
+    BIND_OPCODE_DONE,
+};
+
+TEST(RebaseBind, RebaseTable) {
+    TestImage image;
+    uint32_t offset = addOpcodes(image, rebaseOpcodes);
+
+    RebaseTable rebases = decodeRebaseTable(image.image(), offset, rebaseOpcodes.size());
+    std::vector<std::tuple<int, uint64_t, int>> expected = {
+        {1, 0x10, REBASE_TYPE_POINTER}, {1, 0x18, REBASE_TYPE_POINTER}, {1, 0x20, REBASE_TYPE_POINTER},
+        {1, 0x38, REBASE_TYPE_POINTER}, {1, 0x40, REBASE_TYPE_POINTER},
+        {1, 0x148, REBASE_TYPE_TEXT_ABSOLUTE32},
+        {1, 0x158, REBASE_TYPE_TEXT_ABSOLUTE32}, {1, 0x168, REBASE_TYPE_TEXT_ABSOLUTE32}, {1, 0x178, REBASE_TYPE_TEXT_ABSOLUTE32},
+    };
+    std::vector<std::tuple<int, uint64_t, int>> decoded;
+    for (size_t i = 0; i < rebases.count; ++i) {
+        RebaseRecord rebase = rebases[i];
+        decoded.push_back({rebase.segmentIndex, rebase.segmentOffset, rebase.type});
+    }
+    EXPECT_EQ(decoded, expected);
+}
+
+TEST(RebaseBind, BindTable) {
+    TestImage image;
+    uint32_t offset = addOpcodes(image, bindOpcodes);
+
+    BindTable binds = decodeBindTable(image.image(), offset, bindOpcodes.size());
+    ASSERT_EQ(binds.count, 5);
+
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < binds.count; ++i) {
+        EXPECT_EQ(binds[i].segmentIndex, 1);
+        EXPECT_EQ(binds[i].type, BIND_TYPE_POINTER);
+        offsets.push_back(binds[i].segmentOffset);
+    }
+    EXPECT_EQ(offsets, std::vector<uint64_t>({0x0, 0x8, 0x20, 0x40, 0x50}));
+
+    EXPECT_STREQ(binds[0].symbolName, "_a");
+    EXPECT_EQ(binds[0].dylibOrdinal, 1);
+    EXPECT_EQ(binds[0].symbolFlags, 0);
+    EXPECT_EQ(binds[0].addend, 0);
+
+    for (size_t i : {1, 2}) {
+        EXPECT_STREQ(binds[i].symbolName, "_b");
+        EXPECT_EQ(binds[i].dylibOrdinal, 300);
+        EXPECT_EQ(binds[i].symbolFlags, BIND_SYMBOL_FLAGS_WEAK_IMPORT);
+        EXPECT_EQ(binds[i].addend, -8);
+    }
+
+    for (size_t i : {3, 4}) {
+        EXPECT_STREQ(binds.symbolName(i), "_c");
+        EXPECT_EQ(binds[i].dylibOrdinal, BIND_SPECIAL_DYLIB_FLAT_LOOKUP);
+        EXPECT_EQ(binds[i].symbolFlags, BIND_SYMBOL_FLAGS_NON_WEAK_DEFINITION);
+        EXPECT_EQ(binds[i].addend, 0);
+    }
+}
+
+TEST(RebaseBind, UnknownOpcode) {
+    TestImage image;
+    // 0x90 is past the last rebase opcode and 0xe0 past the last bind opcode. BIND_OPCODE_THREADED isn't supported.
+    std::vector<uint8_t> opcodes = {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00, 0x90, BIND_OPCODE_THREADED, 0xe0};
+    uint32_t offset = addOpcodes(image, opcodes);
+
+    EXPECT_THROW(decodeRebaseTable(image.image(), offset, 3), std::runtime_error);
+    EXPECT_THROW(decodeBindTable(image.image(), offset + 3, 1), std::runtime_error);
+    EXPECT_THROW(decodeBindTable(image.image(), offset + 4, 1), std::runtime_error);
+
+    // A segment that the image doesn't have.
+    std::vector<uint8_t> badSegment = {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 2, 0x00};
+    TestImage other;
+    uint32_t badOffset = addOpcodes(other, badSegment);
+    EXPECT_THROW(decodeRebaseTable(other.image(), badOffset, badSegment.size()), std::runtime_error);
+}
+
+// Repeat counts and skips come straight from the file, so a run has to fit in its segment before it's expanded.
+TEST(RebaseBind, RunOutOfBounds) {
+    // __DATA is 0x4000 bytes
+    std::vector<std::vector<uint8_t>> rebaseStreams = {
+        // 2^60 rebases
+        {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00,
+            REBASE_OPCODE_DO_REBASE_ULEB_TIMES, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x10},
+        // 0x801 rebases, one more than fits
+        {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00, REBASE_OPCODE_DO_REBASE_ULEB_TIMES, 0x81, 0x10},
+        // count * stride overflows
+        {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00, REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB, 0x03,
+            0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01},
+        // a skip of -8 wraps the stride around to 0
+        {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00, REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB, 0x03,
+            0xf8, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01},
+        // a single rebase past the end
+        {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x80, 0x80, 0x01, REBASE_OPCODE_DO_REBASE_IMM_TIMES | 1},
+    };
+    for (const std::vector<uint8_t> &opcodes : rebaseStreams) {
+        TestImage image;
+        uint32_t offset = addOpcodes(image, opcodes);
+        EXPECT_THROW(decodeRebaseTable(image.image(), offset, opcodes.size()), std::runtime_error);
+        EXPECT_THROW(forEachRebaseRun(image.image(), offset, opcodes.size(), [](const RebaseRun &) {}), std::runtime_error);
+    }
+
+    std::vector<uint8_t> bindOpcodes = {
+        BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM, '_', 'a', 0,
+        BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00,
+        BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x10, 0x00,
+    };
+    TestImage image;
+    uint32_t offset = addOpcodes(image, bindOpcodes);
+    EXPECT_THROW(decodeBindTable(image.image(), offset, bindOpcodes.size()), std::runtime_error);
+
+    // The last pointer of the segment is still fine.
+    std::vector<uint8_t> lastPointer = {REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB | 1, 0x00, REBASE_OPCODE_DO_REBASE_ULEB_TIMES, 0x80, 0x10};
+    TestImage last;
+    uint32_t lastOffset = addOpcodes(last, lastPointer);
+    EXPECT_EQ(decodeRebaseTable(last.image(), lastOffset, lastPointer.size()).count, 0x800);
+}
+
+// Expanding the (start, count, stride) runs gives the same locations as walking every rebase and bind.
+TEST(RebaseBind, RunsMatchRecords) {
+    TestImage image;
+    uint32_t rebaseOffset = addOpcodes(image, rebaseOpcodes);
+    uint32_t bindOffset = image.addData(bindOpcodes);
+
+    std::vector<std::tuple<int, uint64_t, int>> rebases, rebaseRuns;
+    forEachRebase(image.image(), rebaseOffset, rebaseOpcodes.size(), [&rebases](const RebaseRecord &rebase) {
+        rebases.push_back({rebase.segmentIndex, rebase.segmentOffset, rebase.type});
+    });
+    forEachRebaseRun(image.image(), rebaseOffset, rebaseOpcodes.size(), [&rebaseRuns](const RebaseRun &run) {
+        for (uint64_t k = 0; k < run.count; ++k) {
+            rebaseRuns.push_back({run.segmentIndex, run.segmentOffset + k * run.stride, run.type});
+        }
+    });
+    EXPECT_EQ(rebaseRuns, rebases);
+
+    typedef std::tuple<int, uint64_t, int, int, std::string, int, int64_t> BindTuple;
+    auto toTuple = [](const BindRecord &bind, uint64_t segmentOffset) -> BindTuple {
+        return {bind.segmentIndex, segmentOffset, bind.type, bind.dylibOrdinal, bind.symbolName, bind.symbolFlags, bind.addend};
+    };
+    std::vector<BindTuple> binds, bindRuns;
+    forEachBind(image.image(), bindOffset, bindOpcodes.size(), [&](const BindRecord &bind) {
+        binds.push_back(toTuple(bind, bind.segmentOffset));
+    });
+    forEachBindRun(image.image(), bindOffset, bindOpcodes.size(), [&](const BindRun &run) {
+        for (uint64_t k = 0; k < run.count; ++k) {
+            bindRuns.push_back(toTuple(run.bind, run.bind.segmentOffset + k * run.stride));
+        }
+    });
+    EXPECT_EQ(bindRuns, binds);
+    EXPECT_EQ(binds.size(), 5);
+}
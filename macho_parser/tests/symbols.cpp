@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include "apple/mach-o/stab.h"
+#include <string>
+#include <vector>
+#include "test_image.h"
+
+static struct section_64 makeSection(const char *name, uint64_t addr, uint64_t size) {
+    struct section_64 sect = {};
+    strncpy(sect.sectname, name, sizeof(sect.sectname));
+    sect.addr = addr;
+    sect.size = size;
+    return sect;
+}
+
+static struct nlist_64 makeSymbol(uint32_t strx, uint8_t type, uint8_t sect, uint64_t value) {
+    struct nlist_64 nlist = {};
+    nlist.n_un.n_strx = strx;
+    nlist.n_type = type;
+    nlist.n_sect = sect;
+    nlist.n_value = value;
+    return nlist;
+}
+
+// __text is [0x1000, 0x1100) and __stubs is [0x1200, 0x1210), with a gap between them.
+static void addSymbols(TestImage &image) {
+    image.addSegment("__TEXT", 0x0, 0x2000, {makeSection("__text", 0x1000, 0x100), makeSection("__stubs", 0x1200, 0x10)});
+
+    std::string strings = std::string("\0_f\0_g\0_alias\0_h\0_stab\0_undef\0", 31);
+    image.addSymbolTable({
+        makeSymbol(1, N_SECT | N_EXT, 1, 0x1000),   // _f
+        makeSymbol(4, N_SECT | N_EXT, 1, 0x1080),   // _g
+        makeSymbol(7, N_SECT, 1, 0x1080),           // _alias, at the same address as _g
+        makeSymbol(14, N_SECT | N_EXT, 2, 0x1200),  // _h
+        makeSymbol(17, N_FUN, 1, 0x1040),           // _stab, ignored
+        makeSymbol(23, N_UNDF | N_EXT, 0, 0),       // _undef
+    }, strings);
+}
+
+TEST(Symbols, Symbolicate) {
+    TestImage testImage;
+    addSymbols(testImage);
+    const MachoImage &image = testImage.image();
+
+    // exact hits, where the first symbol in the symbol table wins
+    EXPECT_EQ(image.symbolicateAddress(0x1000), "_f");
+    EXPECT_EQ(image.symbolicateAddress(0x1080), "_g");
+    EXPECT_EQ(image.symbolicateAddress(0x1200), "_h");
+    EXPECT_STREQ(image.lookupSymbolByAddress(0x1080), "_g");
+
+    // offsets into a symbol, without the stab in between
+    EXPECT_EQ(image.symbolicateAddress(0x1010), "_f+0x10");
+    EXPECT_EQ(image.symbolicateAddress(0x1040), "_f+0x40");
+    EXPECT_EQ(image.symbolicateAddress(0x10ff), "_g+0x7f");
+    EXPECT_EQ(image.symbolicateAddress(0x120f), "_h+0xf");
+
+    // before the first symbol and past the section of the preceding symbol
+    EXPECT_EQ(image.symbolicateAddress(0xfff), "");
+    EXPECT_EQ(image.symbolicateAddress(0x1100), "");
+    EXPECT_EQ(image.symbolicateAddress(0x11ff), "");
+    EXPECT_EQ(image.symbolicateAddress(0x1210), "");
+    EXPECT_EQ(image.symbolicateAddress(UINT64_MAX), "");
+}
+
+TEST(Symbols, LookupByName) {
+    TestImage testImage;
+    std::string strings = std::string("\0_dup\0_one\0_other\0", 19);
+    testImage.addSymbolTable({
+        makeSymbol(1, N_FUN, 1, 0x1000),            // a stab named _dup, ignored
+        makeSymbol(6, N_SECT | N_EXT, 1, 0x1000),   // _one
+        makeSymbol(1, N_SECT | N_EXT, 1, 0x1010),   // _dup
+        makeSymbol(1, N_UNDF | N_EXT, 0, 0),        // _dup again
+        makeSymbol(11, N_UNDF | N_EXT, 0, 0),       // _other
+    }, strings);
+    const MachoImage &image = testImage.image();
+
+    EXPECT_EQ(image.lookupSymbolByName("_one"), 1);
+    EXPECT_EQ(image.lookupSymbolByName("_other"), 4);
+    // The first of the duplicates wins.
+    EXPECT_EQ(image.lookupSymbolByName("_dup"), 2);
+
+    EXPECT_EQ(image.lookupSymbolByName("_missing"), -1);
+    EXPECT_EQ(image.lookupSymbolByName("_du"), -1);
+    EXPECT_EQ(image.lookupSymbolByName("_dup_"), -1);
+    EXPECT_EQ(image.lookupSymbolByName(""), -1);
+}
+
+TEST(Symbols, LookupByNameWithoutSymbols) {
+    TestImage testImage;
+    testImage.addSegment("__TEXT", 0x0, 0x1000);
+    EXPECT_EQ(testImage.image().lookupSymbolByName("_main"), -1);
+}
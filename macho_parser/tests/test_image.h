@@ -0,0 +1,109 @@
+#ifndef TEST_IMAGE_H
+#define TEST_IMAGE_H
+
+#include <string.h>
+#include "apple/mach-o/loader.h"
+#include "apple/mach-o/nlist.h"
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "core/macho_image.h"
+
+// A Mach-O image built in memory, for the structures the fixtures don't have.
+// The load commands are at the start as usual and the data they refer to starts at DATA_OFFSET,
+// so the file offset of some data is known as soon as it's added.
+class TestImage {
+public:
+    static const uint32_t DATA_OFFSET = 0x1000;
+
+    // Append `size` bytes to the data, 8-byte aligned, and return their file offset.
+    uint32_t addData(const void *bytes, size_t size) {
+        data.resize((data.size() + 7) & ~(size_t)7);
+        uint32_t offset = DATA_OFFSET + data.size();
+        data.insert(data.end(), (const uint8_t *)bytes, (const uint8_t *)bytes + size);
+        return offset;
+    }
+    uint32_t addData(const std::vector<uint8_t> &bytes) { return addData(bytes.data(), bytes.size()); }
+    uint32_t addData(std::string_view bytes) { return addData(bytes.data(), bytes.size()); }
+
+    // Add a load command followed by `trailing` bytes. cmdsize is filled in.
+    template <typename Command>
+    void addCommand(Command command, const void *trailing = nullptr, size_t trailingSize = 0) {
+        command.cmdsize = (sizeof(command) + trailingSize + 7) & ~(size_t)7;
+        size_t offset = commands.size();
+        commands.resize(offset + command.cmdsize);
+        memcpy(commands.data() + offset, &command, sizeof(command));
+        if (trailingSize > 0) {
+            memcpy(commands.data() + offset + sizeof(command), trailing, trailingSize);
+        }
+        ncmds += 1;
+    }
+
+    // Add an LC_SEGMENT_64 with `sections`. Their segname is filled in.
+    void addSegment(const char *name, uint64_t vmaddr, uint64_t vmsize, std::vector<struct section_64> sections = {}) {
+        struct segment_command_64 segCmd = {};
+        segCmd.cmd = LC_SEGMENT_64;
+        strncpy(segCmd.segname, name, sizeof(segCmd.segname));
+        segCmd.vmaddr = vmaddr;
+        segCmd.vmsize = vmsize;
+        segCmd.nsects = sections.size();
+        for (struct section_64 &sect : sections) {
+            strncpy(sect.segname, name, sizeof(sect.segname));
+        }
+        addCommand(segCmd, sections.data(), sections.size() * sizeof(struct section_64));
+    }
+
+    // Add an LC_SYMTAB with `symbols`, whose n_strx are offsets in `strings`.
+    void addSymbolTable(const std::vector<struct nlist_64> &symbols, std::string_view strings) {
+        struct symtab_command symtabCmd = {};
+        symtabCmd.cmd = LC_SYMTAB;
+        symtabCmd.nsyms = symbols.size();
+        symtabCmd.symoff = addData(symbols.data(), symbols.size() * sizeof(struct nlist_64));
+        symtabCmd.stroff = addData(strings);
+        symtabCmd.strsize = strings.size();
+        addCommand(symtabCmd);
+    }
+
+    // Add a linkedit_data_command like LC_DYLD_CHAINED_FIXUPS with `bytes` as its data.
+    void addLinkEditData(uint32_t cmd, const std::vector<uint8_t> &bytes) {
+        struct linkedit_data_command linkEditDataCmd = {};
+        linkEditDataCmd.cmd = cmd;
+        linkEditDataCmd.dataoff = addData(bytes);
+        linkEditDataCmd.datasize = bytes.size();
+        addCommand(linkEditDataCmd);
+    }
+
+    // Parse the image on the first call. Nothing can be added afterwards.
+    const MachoImage &image() {
+        if (parsed == nullptr) {
+            if (sizeof(struct mach_header_64) + commands.size() > DATA_OFFSET) {
+                throw std::logic_error("The load commands of a test image don't fit before its data.");
+            }
+            struct mach_header_64 header = {};
+            header.magic = MH_MAGIC_64;
+            header.cputype = CPU_TYPE_ARM64;
+            header.filetype = MH_EXECUTE;
+            header.ncmds = ncmds;
+            header.sizeofcmds = commands.size();
+
+            bytes.resize(DATA_OFFSET + data.size());
+            memcpy(bytes.data(), &header, sizeof(header));
+            memcpy(bytes.data() + sizeof(header), commands.data(), commands.size());
+            memcpy(bytes.data() + DATA_OFFSET, data.data(), data.size());
+            parsed = std::make_unique<MachoImage>(bytes.data(), bytes.size());
+        }
+        return *parsed;
+    }
+
+private:
+    std::vector<uint8_t> commands;
+    uint32_t ncmds = 0;
+    std::vector<uint8_t> data;
+    // The image is parsed in place, so the bytes have to outlive it.
+    std::vector<uint8_t> bytes;
+    std::unique_ptr<MachoImage> parsed;
+};
+
+#endif /* TEST_IMAGE_H */